@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef TUBE_HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
+
+#include "engine/ImageDecoder.h"
+#include "engine/MappedFile.h"
+#include "engine/Parallel.h"
+
+namespace {
+
+constexpr int kRepetitions = 3;
+constexpr int kUpscale = 4;
+constexpr int kImageCopies = 8;
+// Bands the checks cut files into, whatever the core count.
+constexpr std::size_t kCheckBands = 4;
+
+void report(const char* name, std::size_t elementCount, const char* unit, const std::function<void()>& run) {
+    run();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepetitions; ++i) {
+        run();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double seconds = elapsed.count() / kRepetitions;
+    std::printf(
+        "%-56s %12zu %-8s %10.3f ms %10.2f M%s/s\n",
+        name,
+        elementCount,
+        unit,
+        seconds * 1000.0,
+        static_cast<double>(elementCount) / seconds / 1.0e6,
+        unit
+    );
+}
+
+using Bytes = std::vector<unsigned char>;
+using Decoders = std::vector<std::shared_ptr<const ImageDecoder>>;
+
+Bytes readFile(const std::string& path) {
+    const MappedFile file(path);
+    const auto* data = reinterpret_cast<const unsigned char*>(file.data());
+    return Bytes(data, data + file.size());
+}
+
+void benchFile(const std::string& label, const Bytes& file, const Decoders& decoders) {
+    DecodedImage probe;
+    if (!decoders.front()->decode(file.data(), file.size(), probe)) {
+        std::printf("%s: nao foi possivel decodificar\n", label.c_str());
+        return;
+    }
+    const std::size_t pixelCount = static_cast<std::size_t>(probe.width) * static_cast<std::size_t>(probe.height);
+
+    for (const auto& decoder : decoders) {
+        if (!decoder->accepts(file.data(), file.size())) {
+            continue;
+        }
+        char name[128];
+        std::snprintf(name, sizeof(name), "%s %s", label.c_str(), decoder->name());
+        report(name, pixelCount, "pixels", [&]() {
+            DecodedImage image;
+            decoder->decode(file.data(), file.size(), image);
+        });
+    }
+}
+
+// Timings mean nothing if the bands do not reassemble into exactly what the
+// inner decoder produces for the whole file.
+bool matchesReference(const std::string& label, const Bytes& file, const ImageDecoder& decoder, const ImageDecoder& reference) {
+    DecodedImage expected;
+    DecodedImage image;
+    if (!reference.decode(file.data(), file.size(), expected)) {
+        return true;
+    }
+    const bool same = decoder.decode(file.data(), file.size(), image) && image.width == expected.width &&
+        image.height == expected.height && image.channels == expected.channels && image.pixels == expected.pixels;
+    if (!same) {
+        std::printf("%s: %s difere de %s\n", label.c_str(), decoder.name(), reference.name());
+    }
+    return same;
+}
+
+// Several textures in flight at once, as the loader's workers decode them,
+// against one after the other.
+void benchCopies(const std::string& label, const Bytes& file, const ImageDecoder& decoder) {
+    DecodedImage probe;
+    if (!decoder.decode(file.data(), file.size(), probe)) {
+        return;
+    }
+    const std::size_t pixelCount = static_cast<std::size_t>(probe.width) * static_cast<std::size_t>(probe.height) * kImageCopies;
+
+    char name[128];
+    std::snprintf(name, sizeof(name), "%s %s x%d sequential", label.c_str(), decoder.name(), kImageCopies);
+    report(name, pixelCount, "pixels", [&]() {
+        for (int i = 0; i < kImageCopies; ++i) {
+            DecodedImage image;
+            decoder.decode(file.data(), file.size(), image);
+        }
+    });
+
+    std::snprintf(name, sizeof(name), "%s %s x%d concurrent", label.c_str(), decoder.name(), kImageCopies);
+    report(name, pixelCount, "pixels", [&]() {
+        parallelFor(kImageCopies, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                DecodedImage image;
+                decoder.decode(file.data(), file.size(), image);
+            }
+        });
+    });
+}
+
+#ifdef TUBE_HAVE_LIBJPEG
+
+// Bilinear, so the enlarged photo still has detail for the entropy coder.
+DecodedImage upscale(const DecodedImage& source, int factor) {
+    DecodedImage result;
+    result.width = source.width * factor;
+    result.height = source.height * factor;
+    result.channels = source.channels;
+    result.pixels.resize(static_cast<std::size_t>(result.width) * static_cast<std::size_t>(result.height) * result.channels);
+
+    const int channels = source.channels;
+    for (int y = 0; y < result.height; ++y) {
+        const float sy = std::max(0.0f, (static_cast<float>(y) + 0.5f) / factor - 0.5f);
+        const int y0 = std::min(static_cast<int>(sy), source.height - 1);
+        const int y1 = std::min(y0 + 1, source.height - 1);
+        const float fy = sy - static_cast<float>(y0);
+        for (int x = 0; x < result.width; ++x) {
+            const float sx = std::max(0.0f, (static_cast<float>(x) + 0.5f) / factor - 0.5f);
+            const int x0 = std::min(static_cast<int>(sx), source.width - 1);
+            const int x1 = std::min(x0 + 1, source.width - 1);
+            const float fx = sx - static_cast<float>(x0);
+            for (int c = 0; c < channels; ++c) {
+                const auto at = [&](int px, int py) {
+                    return static_cast<float>(source.pixels[(static_cast<std::size_t>(py) * source.width + px) * channels + c]);
+                };
+                const float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+                const float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+                result.pixels[(static_cast<std::size_t>(y) * result.width + x) * channels + c] =
+                    static_cast<unsigned char>(top + (bottom - top) * fy + 0.5f);
+            }
+        }
+    }
+    return result;
+}
+
+// Baseline, as photos usually ship; restartRows adds a restart marker at
+// the start of every that many MCU rows.
+Bytes encode(const DecodedImage& image, int restartRows) {
+    jpeg_compress_struct info{};
+    jpeg_error_mgr error{};
+    info.err = jpeg_std_error(&error);
+    jpeg_create_compress(&info);
+
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&info, &buffer, &size);
+    info.image_width = static_cast<JDIMENSION>(image.width);
+    info.image_height = static_cast<JDIMENSION>(image.height);
+    info.input_components = image.channels;
+    info.in_color_space = image.channels == 4 ? JCS_EXT_RGBA : JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, 90, TRUE);
+    info.restart_in_rows = restartRows;
+    jpeg_start_compress(&info, TRUE);
+
+    const std::size_t stride = static_cast<std::size_t>(image.width) * static_cast<std::size_t>(image.channels);
+    while (info.next_scanline < info.image_height) {
+        JSAMPROW row = const_cast<JSAMPROW>(image.pixels.data() + info.next_scanline * stride);
+        jpeg_write_scanlines(&info, &row, 1);
+    }
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+
+    Bytes file(buffer, buffer + size);
+    std::free(buffer);
+    return file;
+}
+
+#endif
+
+std::string baseName(const std::string& path) {
+    const std::size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        paths.emplace_back(argv[i]);
+    }
+    if (paths.empty()) {
+        paths = {"wall.jpg", "ground.jpg"};
+    }
+
+    const std::shared_ptr<const ImageDecoder> stb = makeStbDecoder();
+    const std::shared_ptr<const ImageDecoder> jpeg = makeLibjpegDecoder();
+    Decoders decoders{stb};
+    if (jpeg != nullptr) {
+        decoders.push_back(jpeg);
+    }
+    const std::shared_ptr<const ImageDecoder> reference = jpeg != nullptr ? jpeg : stb;
+    decoders.push_back(makeRestartParallelDecoder(reference));
+    const std::unique_ptr<ImageDecoder> checked = makeRestartParallelDecoder(reference, kCheckBands);
+
+    bool identical = true;
+    for (const std::string& path : paths) {
+        Bytes original;
+        try {
+            original = readFile(path);
+        } catch (const std::runtime_error& error) {
+            std::printf("%s\n", error.what());
+            continue;
+        }
+        const std::string label = baseName(path);
+        identical = matchesReference(label, original, *checked, *reference) && identical;
+        benchFile(label, original, decoders);
+
+#ifdef TUBE_HAVE_LIBJPEG
+        DecodedImage image;
+        if (!stb->decode(original.data(), original.size(), image)) {
+            continue;
+        }
+        const DecodedImage large = upscale(image, kUpscale);
+        char scaled[64];
+        std::snprintf(scaled, sizeof(scaled), "%s x%d", label.c_str(), kUpscale);
+        const Bytes plain = encode(large, 0);
+        const Bytes restarts = encode(large, 1);
+        identical = matchesReference(std::string(scaled) + " restarts", restarts, *checked, *reference) && identical;
+        benchFile(std::string(scaled) + " baseline", plain, decoders);
+        benchFile(std::string(scaled) + " restarts", restarts, decoders);
+        benchCopies(std::string(scaled) + " baseline", plain, *decoders[1]);
+#else
+        benchCopies(label, original, *stb);
+#endif
+    }
+
+#ifndef TUBE_HAVE_LIBJPEG
+    std::printf("Sem libjpeg: imagens ampliadas e decodificador SIMD indisponiveis\n");
+#endif
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "app_config.hpp"
+#include "engine/MeshKernels.h"
+#include "engine/TubeSweep.h"
+
+namespace {
+
+constexpr int kRepetitions = 3;
+
+void report(const char* name, std::size_t elementCount, const char* unit, const std::function<void()>& run) {
+    run();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepetitions; ++i) {
+        run();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double seconds = elapsed.count() / kRepetitions;
+    std::printf(
+        "%-28s %12zu %-8s %10.3f ms %10.2f M%s/s\n",
+        name,
+        elementCount,
+        unit,
+        seconds * 1000.0,
+        static_cast<double>(elementCount) / seconds / 1.0e6,
+        unit
+    );
+}
+
+void benchTube(int segments) {
+    const meshgen::MeshLayout layout = meshgen::tubeLayout(segments);
+    std::vector<float> vertices(layout.vertexCount * app::kVertexStrideFloats);
+    std::vector<unsigned int> indices(layout.indexCount);
+    const meshgen::TubeParams params{app::kTubeInnerRadius, app::kTubeOuterRadius, app::kTubeHeight, segments};
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "tube segments=%d", segments);
+    report(name, layout.vertexCount, "vertices", [&]() { meshgen::writeTube(params, vertices.data(), indices.data()); });
+}
+
+void benchSphere(int sectors, int stacks) {
+    const meshgen::MeshLayout layout = meshgen::sphereLayout(sectors, stacks);
+    std::vector<float> vertices(layout.vertexCount * app::kVertexStrideFloats);
+    std::vector<unsigned int> indices(layout.indexCount);
+    const meshgen::SphereParams params{app::kLightSphereRadius, sectors, stacks};
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "sphere %dx%d", sectors, stacks);
+    report(name, layout.vertexCount, "vertices", [&]() { meshgen::writeSphere(params, vertices.data(), indices.data()); });
+}
+
+meshgen::SweepPath spiralPath(std::size_t pointCount) {
+    meshgen::SweepPath path;
+    path.points.resize(pointCount);
+    path.radii = {0.05f};
+
+    for (std::size_t i = 0; i < pointCount; ++i) {
+        const float t = static_cast<float>(i) * 1.0e-3f;
+        path.points[i] = {50.0f * std::cos(t), 1.0e-2f * t, 50.0f * std::sin(1.3f * t)};
+    }
+    return path;
+}
+
+void benchFrames(std::size_t pointCount) {
+    const meshgen::SweepPath path = spiralPath(pointCount);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "sweep frames points=%zu", pointCount);
+    report(name, pointCount, "points", [&]() { const auto frames = meshgen::computeFrames(path.points, 4096); (void)frames; });
+}
+
+void benchSweep(std::size_t pointCount, int radialSegments) {
+    const meshgen::SweepPath path = spiralPath(pointCount);
+    meshgen::SweepOptions options;
+    options.radialSegments = radialSegments;
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "sweep points=%zu radial=%d", pointCount, radialSegments);
+    const std::size_t vertexCount = pointCount * static_cast<std::size_t>(radialSegments + 1);
+    report(name, vertexCount, "vertices", [&]() { const auto chunks = meshgen::sweepTube(path, options); (void)chunks; });
+}
+
+}  // namespace
+
+int main() {
+    benchTube(app::kTubeSegments);
+    benchTube(65536);
+    benchTube(1 << 20);
+    benchSphere(app::kLightSphereSectors, app::kLightSphereStacks);
+    benchSphere(1024, 512);
+    benchSphere(4096, 2048);
+    benchFrames(10'000'000);
+    benchSweep(1'000'000, 8);
+    return 0;
+}
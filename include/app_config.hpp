@@ -1,6 +1,6 @@
 #pragma once
 
-#include <array>
+#include <cstddef>
 
 namespace app {
 
@@ -8,28 +8,86 @@ inline constexpr const char* kWindowTitle = "Tube Renderer";
 inline constexpr unsigned int kWindowWidth = 800;
 inline constexpr unsigned int kWindowHeight = 600;
 
+inline constexpr float kCameraNearPlane = 0.1f;
+inline constexpr float kCameraFarPlane = 2000.0f;
+
 inline constexpr float kTubeInnerRadius = 0.6f;
 inline constexpr float kTubeOuterRadius = 1.0f;
 inline constexpr float kTubeHeight = 2.0f;
 inline constexpr int kTubeSegments = 32;
+inline constexpr float kTubePulseAmplitude = 0.08f;
+inline constexpr float kTubePulseWavelength = 1.0f;
+inline constexpr float kTubePulseSpeed = 0.6f;
+inline constexpr float kTubeFlexCurvature = 0.25f;
+inline constexpr float kTubeTwistRate = 0.15f;
 
 inline constexpr float kLightOrbitRadius = 5.0f;
 inline constexpr float kLightSphereRadius = 0.5f;
 inline constexpr int kLightSphereSectors = 32;
 inline constexpr int kLightSphereStacks = 16;
 
+inline constexpr int kRoutePointCount = 2048;
+inline constexpr float kRouteHelixRadius = 8.0f;
+inline constexpr float kRouteHelixTurns = 3.0f;
+inline constexpr float kRouteRise = 6.0f;
+inline constexpr float kRouteTubeRadius = 0.15f;
+inline constexpr std::size_t kRouteRingsPerChunk = 64;
+inline constexpr int kRouteSplineSubdivisions = 3;
+inline constexpr float kRoutePixelError = 0.5f;
+inline constexpr float kRouteScalarInterval = 1.0f / 30.0f;
+inline constexpr float kRouteScalarWaves = 6.0f;
+inline constexpr float kRouteScalarSpeed = 0.4f;
+inline constexpr std::size_t kScalarUploadBudgetBytes = 64u * 1024u;
+
+inline constexpr int kNetworkRadialSegments = 10;
+inline constexpr int kNetworkCapStacks = 3;
+inline constexpr int kNetworkGridSize = 24;
+inline constexpr float kNetworkSpacing = 1.5f;
+inline constexpr float kNetworkPipeRadius = 0.08f;
+inline constexpr std::size_t kNetworkSegmentsPerCluster = 256;
+inline constexpr float kNetworkImpostorPixels = 4.0f;
+inline constexpr float kNetworkLinePixels = 0.75f;
+inline constexpr float kNetworkAggregatePixels = 24.0f;
+
+inline constexpr float kLodPixelError = 1.0f;
+inline constexpr float kImpostorPixels = 32.0f;
+inline constexpr int kImpostorFramesPerSide = 8;
+inline constexpr int kImpostorFrameSize = 128;
+
+inline constexpr int kPropCount = 12;
+inline constexpr float kPropRingRadius = 30.0f;
+
+inline constexpr float kGroundHeight = -1.0f;
+inline constexpr float kGroundTexCoordScale = 0.25f;
+inline constexpr float kTerrainFlatRadius = 60.0f;
+inline constexpr int kTerrainGridSize = 32;
+inline constexpr int kTerrainLevels = 7;
+inline constexpr std::size_t kTerrainTilesPerFrame = 16;
+
+inline constexpr std::size_t kDatasetSegmentsPerFrame = 64u * 1024u;
+
 inline constexpr unsigned int kVertexStrideFloats = 8;
 
-inline constexpr std::array<float, 32> kGroundVertices = {
-    -100.0f, -1.0f, -100.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
-     100.0f, -1.0f, -100.0f, 0.0f, 1.0f, 0.0f, 50.0f, 0.0f,
-     100.0f, -1.0f,  100.0f, 0.0f, 1.0f, 0.0f, 50.0f, 50.0f,
-    -100.0f, -1.0f,  100.0f, 0.0f, 1.0f, 0.0f, 0.0f, 50.0f,
-};
-
-inline constexpr std::array<unsigned int, 6> kGroundIndices = {
-    0, 1, 2,
-    2, 3, 0,
-};
+inline constexpr std::size_t kTextureUploadBudgetBytes = 4u * 1024u * 1024u;
+inline constexpr double kTextureUploadBudgetSeconds = 0.002;
+inline constexpr std::size_t kTextureUploadBuffers = 4;
+inline constexpr std::size_t kTextureUploadBufferBytes = 1024u * 1024u;
+
+inline constexpr std::size_t kMeshCacheBudgetBytes = 256u * 1024u * 1024u;
+inline constexpr std::size_t kTextureCacheBudgetBytes = 256u * 1024u * 1024u;
+inline constexpr std::size_t kMaterialArrayLayers = 64;
+inline constexpr std::size_t kMaterialPacksPerFrame = 2;
+inline constexpr std::size_t kTextureStreamBudgetBytes = 64u * 1024u * 1024u;
+inline constexpr int kTextureStreamTailSize = 64;
+
+inline constexpr int kVirtualPageSize = 128;
+inline constexpr int kVirtualPageBorder = 4;
+inline constexpr int kVirtualCachePagesPerSide = 16;
+inline constexpr std::size_t kVirtualPagesPerFrame = 16;
+inline constexpr int kVirtualFeedbackDivisor = 8;
+inline constexpr float kVirtualGroundTexelSpacing = 0.05f;
+
+inline constexpr const char* kShaderDirectory = "shaders";
+inline constexpr const char* kProgramCacheDirectory = "shader_cache";
 
 }  // namespace app
@@ -0,0 +1,20 @@
+#version 330 core
+
+in vec3 Normal;
+in vec2 TexCoord;
+in float Height;
+
+uniform sampler2D texture1;
+
+layout (location = 0) out vec4 Color;
+layout (location = 1) out vec4 NormalDepth;
+
+void main() {
+    vec3 normal = normalize(Normal);
+    if (!gl_FrontFacing) {
+        normal = -normal;
+    }
+
+    Color = vec4(texture(texture1, TexCoord).rgb, 1.0);
+    NormalDepth = vec4(normal * 0.5 + 0.5, clamp(Height * 0.5 + 0.5, 0.0, 1.0));
+}
@@ -0,0 +1,23 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 boundsCenter;
+uniform float boundsRadius;
+uniform vec3 viewDirection;
+
+out vec3 Normal;
+out vec2 TexCoord;
+out float Height;
+
+void main() {
+    Normal = aNormal;
+    TexCoord = aTexCoord;
+    // Signed distance towards the viewer, in bounding radii.
+    Height = dot(aPos - boundsCenter, viewDirection) / boundsRadius;
+    gl_Position = projection * view * vec4(aPos, 1.0);
+}
@@ -4,14 +4,57 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
 in vec3 LightPos;
+in float Scalar;
 
 uniform sampler2D texture1;
+// Packed materials sample a layer of an array instead of texture1.
+uniform sampler2DArray materialArray;
+uniform bool useMaterialArray;
+uniform int materialLayer;
+// Virtual textures map TexCoord in [0, 1] over level 0 through a page
+// table to pages of a physical atlas.
+uniform bool useVirtualTexture;
+uniform sampler2D pageTable;
+uniform sampler2D pageAtlas;
+uniform float virtualSize;
+uniform int virtualLevels;
+uniform float pageSize;
+uniform float pageBorder;
+uniform float atlasSize;
+uniform sampler2D colormap;
+uniform int scalarMode;
 uniform vec3 viewPos;
 
 out vec4 FragColor;
 
+vec3 sampleVirtual(vec2 uv) {
+    vec2 texel = clamp(uv * virtualSize, 0.0, virtualSize - 1.0);
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0));
+    int level = min(int(lod), virtualLevels - 1);
+
+    // The entry names the atlas slot of the page, or of the nearest
+    // resident ancestor, and which level that page belongs to.
+    vec4 entry = texelFetch(pageTable, ivec2(texel / (pageSize * exp2(float(level)))), level);
+    float mapped = floor(entry.b * 255.0 + 0.5);
+    vec2 slot = floor(entry.rg * 255.0 + 0.5);
+    vec2 inPage = fract(texel / (pageSize * exp2(mapped)));
+    vec2 atlasTexel = slot * (pageSize + 2.0 * pageBorder) + pageBorder + inPage * pageSize;
+    return texture(pageAtlas, atlasTexel / atlasSize).rgb;
+}
+
 void main() {
-    vec3 color = texture(texture1, TexCoord).rgb;
+    vec3 color;
+    if (scalarMode != 0) {
+        color = texture(colormap, vec2(Scalar, 0.5)).rgb;
+    } else if (useVirtualTexture) {
+        color = sampleVirtual(TexCoord);
+    } else if (useMaterialArray) {
+        color = texture(materialArray, vec3(TexCoord, float(materialLayer))).rgb;
+    } else {
+        color = texture(texture1, TexCoord).rgb;
+    }
     vec3 ambient = 0.1 * color;
     vec3 lightDir = normalize(LightPos - FragPos);
     vec3 normal = normalize(Normal);
@@ -0,0 +1,114 @@
+#version 330 core
+
+in vec3 LocalPos;
+flat in vec3 LocalEye;
+flat in vec2 FrameBase;
+flat in vec2 FrameBlend;
+in vec3 LightPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+uniform vec3 boundsCenter;
+uniform float boundsRadius;
+uniform int framesPerSide;
+uniform bool hemisphere;
+uniform sampler2D atlasColor;
+uniform sampler2D atlasNormalDepth;
+
+out vec4 FragColor;
+
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Same mapping as ImpostorAtlas::frameDirection.
+vec3 frameDirection(vec2 frame) {
+    vec2 p = frame / float(framesPerSide - 1) * 2.0 - 1.0;
+    vec3 d;
+    if (hemisphere) {
+        d.x = 0.5 * (p.x + p.y);
+        d.z = 0.5 * (p.x - p.y);
+        d.y = 1.0 - abs(d.x) - abs(d.z);
+    } else {
+        d = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+        if (d.y < 0.0) {
+            d.xz = (1.0 - abs(d.zx)) * signNotZero(d.xz);
+        }
+    }
+    return normalize(d);
+}
+
+void main() {
+    vec3 rayDirection = LocalPos - LocalEye;
+    float frameTexels = float(textureSize(atlasColor, 0).x) / float(framesPerSide);
+
+    // The level is chosen here, in uniform control flow: implicit
+    // derivatives are undefined inside the loop's early continues. A frame
+    // spans the bounding diameter.
+    float footprint = max(length(dFdx(LocalPos)), length(dFdy(LocalPos))) * frameTexels / (2.0 * boundsRadius);
+    float lod = log2(max(footprint, 1e-6));
+    float halfTexel = 0.5 * exp2(max(ceil(lod), 0.0)) / frameTexels;
+
+    // The four frames around the view direction, each sampled where the
+    // view ray crosses its plane. The atlas is premultiplied by coverage
+    // (cleared to zero), so every channel blends the same way.
+    vec3 color = vec3(0.0);
+    vec3 normal = vec3(0.0);
+    vec3 surface = vec3(0.0);
+    float coverage = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        vec2 offset = vec2(float(i & 1), float(i >> 1));
+        vec2 weights = mix(1.0 - FrameBlend, FrameBlend, offset);
+        float weight = weights.x * weights.y;
+        if (weight <= 0.0) {
+            continue;
+        }
+
+        vec2 frame = FrameBase + offset;
+        vec3 direction = frameDirection(frame);
+        vec3 upHint = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+        vec3 right = normalize(cross(upHint, direction));
+        vec3 top = cross(direction, right);
+
+        float facing = dot(rayDirection, direction);
+        if (abs(facing) < 1e-6) {
+            continue;
+        }
+        vec3 hit = LocalEye + rayDirection * (dot(boundsCenter - LocalEye, direction) / facing) - boundsCenter;
+        vec2 local = vec2(dot(hit, right), dot(hit, top)) / boundsRadius * 0.5 + 0.5;
+        if (any(lessThan(local, vec2(0.0))) || any(greaterThan(local, vec2(1.0)))) {
+            continue;
+        }
+
+        vec2 uv = (frame + clamp(local, vec2(halfTexel), vec2(1.0 - halfTexel))) / float(framesPerSide);
+        vec4 texel = textureLod(atlasColor, uv, lod);
+        vec4 normalDepth = textureLod(atlasNormalDepth, uv, lod);
+        color += texel.rgb * weight;
+        normal += (normalDepth.xyz * 2.0 - texel.a) * weight;
+        surface += (hit * texel.a + direction * (normalDepth.w * 2.0 - texel.a) * boundsRadius) * weight;
+        coverage += texel.a * weight;
+    }
+
+    if (coverage < 0.5) {
+        discard;
+    }
+
+    color /= coverage;
+    vec3 fragPos = vec3(model * vec4(boundsCenter + surface / coverage, 1.0));
+    vec3 worldNormal = normalize(mat3(transpose(inverse(model))) * normal);
+
+    vec3 ambient = 0.1 * color;
+    vec3 lightDir = normalize(LightPos - fragPos);
+    float diff = max(dot(lightDir, worldNormal), 0.0);
+    vec3 diffuse = diff * color;
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 reflectDir = reflect(-lightDir, worldNormal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = vec3(0.3) * spec;
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+
+    vec4 clip = projection * view * vec4(fragPos, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+}
@@ -0,0 +1,68 @@
+#version 330 core
+
+// Corners of a unit quad in xy.
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform vec3 boundsCenter;
+uniform float boundsRadius;
+uniform int framesPerSide;
+uniform bool hemisphere;
+
+out vec3 LocalPos;
+flat out vec3 LocalEye;
+flat out vec2 FrameBase;
+flat out vec2 FrameBlend;
+out vec3 LightPos;
+
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Inverse of ImpostorAtlas::frameDirection, in [0, 1]^2.
+vec2 encodeDirection(vec3 d) {
+    if (hemisphere) {
+        d.y = max(d.y, 0.0);
+        d /= abs(d.x) + abs(d.y) + abs(d.z);
+        return vec2(d.x + d.z, d.x - d.z) * 0.5 + 0.5;
+    }
+
+    d /= abs(d.x) + abs(d.y) + abs(d.z);
+    vec2 p = d.xz;
+    if (d.y < 0.0) {
+        p = (1.0 - abs(p.yx)) * signNotZero(p);
+    }
+    return p * 0.5 + 0.5;
+}
+
+void main() {
+    vec3 worldCenter = vec3(model * vec4(boundsCenter, 1.0));
+    float scale = max(length(vec3(model[0])), max(length(vec3(model[1])), length(vec3(model[2]))));
+    float radius = boundsRadius * scale;
+
+    // A quad through the centre has to grow under perspective to still
+    // cover the sphere's silhouette.
+    float distanceToEye = max(length(viewPos - worldCenter), radius);
+    float extent = radius / sqrt(max(1.0 - (radius * radius) / (distanceToEye * distanceToEye), 0.25));
+
+    vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 worldPos = worldCenter + (aPos.x * cameraRight + aPos.y * cameraUp) * extent;
+
+    // Frames are chosen once per object so the blend does not shift across
+    // the quad.
+    mat4 inverseModel = inverse(model);
+    LocalPos = vec3(inverseModel * vec4(worldPos, 1.0));
+    LocalEye = vec3(inverseModel * vec4(viewPos, 1.0));
+    float last = float(framesPerSide - 1);
+    vec2 grid = encodeDirection(normalize(LocalEye - boundsCenter)) * last;
+    FrameBase = clamp(floor(grid), vec2(0.0), vec2(last - 1.0));
+    FrameBlend = clamp(grid - FrameBase, 0.0, 1.0);
+    LightPos = lightPos;
+
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -4,20 +4,113 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
+// Per-object deformation in model space; the tube axis is +Z.
+struct Deformation {
+    bool enabled;
+    float time;
+    float pulseAmplitude;
+    float pulseWavelength;
+    float pulseSpeed;
+    float bendCurvature;
+    float twistRate;
+};
+
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform vec3 lightPos;
+uniform Deformation deformation;
+
+// 0: no scalars, 1: one scalar per vertex, 2: one scalar per ring of
+// scalarRingSize vertices. scalarOffset is the first value of this draw.
+uniform int scalarMode;
+uniform int scalarOffset;
+uniform int scalarRingSize;
+uniform vec2 scalarRange;
+uniform samplerBuffer scalars;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
 out vec3 LightPos;
+out float Scalar;
+
+const float kTwoPi = 6.28318530718;
+
+// sin(a) / a and 2 sin(a / 2)^2 / a, the latter being (1 - cos(a)) / a
+// without the cancellation; both are 0 / 0 at zero, so small angles use
+// their series.
+vec2 bendQuotients(float a) {
+    if (abs(a) < 1e-3) {
+        return vec2(1.0 - a * a / 6.0, 0.5 * a);
+    }
+    float halfSine = sin(0.5 * a);
+    return vec2(sin(a) / a, 2.0 * halfSine * halfSine / a);
+}
+
+// Returns the deformed p and the Jacobian of the whole deformation at p,
+// which carries the normals along.
+vec3 deform(vec3 p, out mat3 jacobian) {
+    float waveNumber = kTwoPi / max(deformation.pulseWavelength, 1e-4);
+    float phase = waveNumber * p.z - kTwoPi * deformation.pulseSpeed * deformation.time;
+    float scale = 1.0 + deformation.pulseAmplitude * sin(phase);
+    float scaleSlope = deformation.pulseAmplitude * waveNumber * cos(phase);
+    mat3 pulse = mat3(
+        scale, 0.0, 0.0,
+        0.0, scale, 0.0,
+        p.x * scaleSlope, p.y * scaleSlope, 1.0
+    );
+    p.xy *= scale;
+
+    float twist = deformation.twistRate * p.z;
+    mat2 rotation = mat2(cos(twist), sin(twist), -sin(twist), cos(twist));
+    p.xy = rotation * p.xy;
+    mat3 twisting = mat3(
+        vec3(rotation[0], 0.0),
+        vec3(rotation[1], 0.0),
+        vec3(-deformation.twistRate * p.y, deformation.twistRate * p.x, 1.0)
+    );
+
+    // The axis follows a circle of radius 1 / bendCurvature in the YZ plane,
+    // written so it stays exact as the curvature goes through zero.
+    float curvature = deformation.bendCurvature;
+    float angle = curvature * p.z;
+    vec2 quotients = bendQuotients(angle);
+    float c = cos(angle);
+    float s = sin(angle);
+    float lever = 1.0 - curvature * p.y;
+    mat3 bending = mat3(
+        1.0, 0.0, 0.0,
+        0.0, c, -s,
+        0.0, lever * s, lever * c
+    );
+    p = vec3(p.x, p.y * c + p.z * quotients.y, p.z * quotients.x - p.y * s);
+
+    jacobian = bending * twisting * pulse;
+    return p;
+}
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+
+    if (deformation.enabled) {
+        mat3 jacobian;
+        position = deform(aPos, jacobian);
+        normal = transpose(inverse(jacobian)) * aNormal;
+    }
+
+    FragPos = vec3(model * vec4(position, 1.0));
+    Normal = mat3(transpose(inverse(model))) * normal;
     TexCoord = aTexCoord;
     LightPos = lightPos;
+
+    Scalar = 0.0;
+    if (scalarMode != 0) {
+        int index = scalarOffset + (scalarMode == 1 ? gl_VertexID : gl_VertexID / max(scalarRingSize, 1));
+        float value = texelFetch(scalars, index).r;
+        Scalar = clamp((value - scalarRange.x) / (scalarRange.y - scalarRange.x), 0.0, 1.0);
+    }
+
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
@@ -0,0 +1,55 @@
+#version 330 core
+
+// Grid coordinates of the node's vertex in x and z.
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+
+uniform vec2 nodeOrigin;
+uniform float nodeSpacing;
+// Distances over which the node morphs into the next coarser grid.
+uniform vec2 morphRange;
+uniform float tileLayer;
+uniform float tileSize;
+uniform float texCoordScale;
+uniform vec2 texCoordOffset;
+uniform sampler2DArray heights;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+out vec3 LightPos;
+out float Scalar;
+
+float heightAt(vec2 grid) {
+    // Tiles start one sample before the node for the normals.
+    return texture(heights, vec3((grid + 1.5) / tileSize, tileLayer)).r;
+}
+
+void main() {
+    vec2 grid = aPos.xz;
+    vec2 world = nodeOrigin + grid * nodeSpacing;
+    float distanceToEye = distance(viewPos, vec3(world.x, heightAt(grid), world.y));
+    float morph = clamp((distanceToEye - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+
+    // Odd vertices slide onto their even neighbours, so at the end of the
+    // range the node matches the coarser level next to it exactly.
+    grid -= fract(grid * 0.5) * 2.0 * morph;
+    world = nodeOrigin + grid * nodeSpacing;
+
+    float height = heightAt(grid);
+    Normal = normalize(vec3(
+        heightAt(grid - vec2(1.0, 0.0)) - heightAt(grid + vec2(1.0, 0.0)),
+        2.0 * nodeSpacing,
+        heightAt(grid - vec2(0.0, 1.0)) - heightAt(grid + vec2(0.0, 1.0))
+    ));
+    FragPos = vec3(world.x, height, world.y);
+    TexCoord = world * texCoordScale + texCoordOffset;
+    LightPos = lightPos;
+    Scalar = 0.0;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
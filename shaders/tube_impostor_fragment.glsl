@@ -0,0 +1,78 @@
+#version 330 core
+
+in vec3 FragPos;
+flat in vec3 SegmentStart;
+flat in vec3 SegmentEnd;
+flat in float SegmentRadius;
+flat in vec3 Color;
+in vec3 LightPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+out vec4 FragColor;
+
+// Ray/capsule intersection: the cylinder body first, then the end sphere on
+// whichever side the body hit fell outside of.
+float intersectCapsule(vec3 origin, vec3 direction, vec3 a, vec3 b, float radius) {
+    vec3 ba = b - a;
+    vec3 oa = origin - a;
+    float baba = dot(ba, ba);
+    float bard = dot(ba, direction);
+    float baoa = dot(ba, oa);
+    float rdoa = dot(direction, oa);
+    float oaoa = dot(oa, oa);
+
+    float qa = baba - bard * bard;
+    float qb = baba * rdoa - baoa * bard;
+    float qc = baba * oaoa - baoa * baoa - radius * radius * baba;
+    float h = qb * qb - qa * qc;
+    if (h < 0.0) {
+        return -1.0;
+    }
+
+    float t = (-qb - sqrt(h)) / qa;
+    float y = baoa + t * bard;
+    if (y > 0.0 && y < baba) {
+        return t;
+    }
+
+    vec3 oc = y <= 0.0 ? oa : origin - b;
+    qb = dot(direction, oc);
+    qc = dot(oc, oc) - radius * radius;
+    h = qb * qb - qc;
+    return h > 0.0 ? -qb - sqrt(h) : -1.0;
+}
+
+vec3 capsuleNormal(vec3 position, vec3 a, vec3 b, float radius) {
+    vec3 ba = b - a;
+    vec3 pa = position - a;
+    float h = clamp(dot(pa, ba) / max(dot(ba, ba), 1e-12), 0.0, 1.0);
+    return (pa - h * ba) / radius;
+}
+
+void main() {
+    vec3 direction = normalize(FragPos - viewPos);
+    float t = intersectCapsule(viewPos, direction, SegmentStart, SegmentEnd, SegmentRadius);
+    if (t <= 0.0) {
+        discard;
+    }
+
+    vec3 hit = viewPos + t * direction;
+    vec4 clip = projection * view * vec4(hit, 1.0);
+    float ndcDepth = clip.z / clip.w;
+    gl_FragDepth = ((gl_DepthRange.far - gl_DepthRange.near) * ndcDepth + gl_DepthRange.near + gl_DepthRange.far) * 0.5;
+
+    vec3 color = Color;
+    vec3 ambient = 0.1 * color;
+    vec3 lightDir = normalize(LightPos - hit);
+    vec3 normal = normalize(capsuleNormal(hit, SegmentStart, SegmentEnd, SegmentRadius));
+    float diff = max(dot(lightDir, normal), 0.0);
+    vec3 diffuse = diff * color;
+    vec3 viewDir = normalize(viewPos - hit);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = vec3(0.3) * spec;
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+}
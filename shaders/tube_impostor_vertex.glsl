@@ -0,0 +1,43 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec4 aStartRadius;
+layout (location = 4) in vec3 aEnd;
+layout (location = 5) in vec4 aColor;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 lightPos;
+
+out vec3 FragPos;
+flat out vec3 SegmentStart;
+flat out vec3 SegmentEnd;
+flat out float SegmentRadius;
+flat out vec3 Color;
+out vec3 LightPos;
+
+void main() {
+    vec3 axis = aEnd - aStartRadius.xyz;
+    float axisLength = length(axis);
+    vec3 tangent = axisLength > 1e-6 ? axis / axisLength : vec3(0.0, 0.0, 1.0);
+    vec3 helper = abs(tangent.y) < 0.9 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 normalAxis = normalize(cross(helper, tangent));
+    vec3 binormalAxis = cross(tangent, normalAxis);
+    mat3 frame = mat3(normalAxis, binormalAxis, tangent);
+
+    vec3 anchor = mix(aStartRadius.xyz, aEnd, aTexCoord.y);
+    vec3 localPos = anchor + aStartRadius.w * (frame * aPos);
+
+    // Impostors assume a uniformly scaled model matrix.
+    float scale = length(vec3(model[0]));
+    SegmentStart = vec3(model * vec4(aStartRadius.xyz, 1.0));
+    SegmentEnd = vec3(model * vec4(aEnd, 1.0));
+    SegmentRadius = aStartRadius.w * scale;
+    Color = aColor.rgb;
+    LightPos = lightPos;
+
+    FragPos = vec3(model * vec4(localPos, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec4 aStartRadius;
+layout (location = 4) in vec3 aEnd;
+layout (location = 5) in vec4 aColor;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 lightPos;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+out vec3 LightPos;
+
+void main() {
+    vec3 axis = aEnd - aStartRadius.xyz;
+    float axisLength = length(axis);
+    vec3 tangent = axisLength > 1e-6 ? axis / axisLength : vec3(0.0, 0.0, 1.0);
+    vec3 helper = abs(tangent.y) < 0.9 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 normalAxis = normalize(cross(helper, tangent));
+    vec3 binormalAxis = cross(tangent, normalAxis);
+    mat3 frame = mat3(normalAxis, binormalAxis, tangent);
+
+    vec3 anchor = mix(aStartRadius.xyz, aEnd, aTexCoord.y);
+    vec3 localPos = anchor + aStartRadius.w * (frame * aPos);
+
+    FragPos = vec3(model * vec4(localPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * (frame * aNormal);
+    Color = aColor.rgb;
+    LightPos = lightPos;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
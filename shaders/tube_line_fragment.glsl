@@ -0,0 +1,10 @@
+#version 330 core
+
+in vec3 Color;
+in float Coverage;
+
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(0.6 * Color, Coverage);
+}
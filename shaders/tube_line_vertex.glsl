@@ -0,0 +1,26 @@
+#version 330 core
+
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec4 aStartRadius;
+layout (location = 4) in vec3 aEnd;
+layout (location = 5) in vec4 aColor;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float pixelsPerUnit;
+
+out vec3 Color;
+out float Coverage;
+
+void main() {
+    vec3 anchor = mix(aStartRadius.xyz, aEnd, aTexCoord.y);
+    vec4 viewPos = view * model * vec4(anchor, 1.0);
+
+    // One-pixel lines stand in for sub-pixel tubes; alpha carries the
+    // fraction of the pixel the real tube would cover.
+    float depth = max(-viewPos.z, 1e-3);
+    Coverage = clamp(2.0 * aStartRadius.w * pixelsPerUnit / depth, 0.05, 1.0);
+    Color = aColor.rgb;
+    gl_Position = projection * viewPos;
+}
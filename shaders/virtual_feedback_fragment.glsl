@@ -0,0 +1,30 @@
+#version 330 core
+
+in vec2 TexCoord;
+
+uniform float virtualSize;
+uniform int virtualLevels;
+uniform float pageSize;
+// log2 of how many screen pixels one feedback pixel covers.
+uniform float feedbackLodBias;
+
+out vec4 FragColor;
+
+// Writes the page sampleVirtual() would want here: page x and y in the low
+// bytes of red and green, their high nibbles in blue and the level plus one
+// in alpha, so a cleared texel reads as no page.
+void main() {
+    vec2 texel = clamp(TexCoord * virtualSize, 0.0, virtualSize - 1.0);
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0)) - feedbackLodBias;
+    int level = clamp(int(lod), 0, virtualLevels - 1);
+
+    ivec2 page = ivec2(texel / (pageSize * exp2(float(level))));
+    FragColor = vec4(
+        float(page.x & 255),
+        float(page.y & 255),
+        float((page.x >> 8) | ((page.y >> 8) << 4)),
+        float(level + 1)
+    ) / 255.0;
+}
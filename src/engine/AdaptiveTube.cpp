@@ -0,0 +1,183 @@
+#include "engine/AdaptiveTube.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "app_config.hpp"
+#include "engine/Parallel.h"
+
+namespace {
+
+// Coarsening waits until the coarser class is comfortably inside the error
+// bound, so a camera hovering at a class boundary does not cause rebuilds.
+constexpr float kCoarsenHysteresis = 0.7f;
+constexpr std::size_t kFramesPerBatch = 4096;
+
+float distanceToBox(const glm::vec3& point, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    const glm::vec3 closest = glm::clamp(point, boundsMin, boundsMax);
+    return glm::length(point - closest);
+}
+
+}  // namespace
+
+void AdaptiveTube::build(const meshgen::SweepPath& path, const AdaptiveTubeOptions& options) {
+    options_ = options;
+    chunks_.clear();
+    rings_ = {};
+    frames_.clear();
+    lengths_.clear();
+    ringSources_.clear();
+
+    const meshgen::SweepPath dense = meshgen::catmullRom(path, options.splineSubdivisions);
+    if (dense.points.size() < 2) {
+        return;
+    }
+
+    const std::vector<meshgen::SweepFrame> denseFrames = meshgen::computeFrames(dense.points, kFramesPerBatch);
+    const std::vector<float> denseLengths = meshgen::arcLengths(dense.points);
+    const std::vector<std::size_t> selected = meshgen::placeRings(dense, denseFrames, options.placement);
+
+    rings_.points.reserve(selected.size());
+    rings_.radii.reserve(selected.size());
+    frames_.reserve(selected.size());
+    lengths_.reserve(selected.size());
+    ringSources_.reserve(selected.size());
+    const auto samplesPerSpan = static_cast<std::size_t>(std::max(options.splineSubdivisions, 0)) + 1;
+    for (const std::size_t index : selected) {
+        rings_.points.push_back(dense.points[index]);
+        rings_.radii.push_back(dense.radiusAt(index));
+        frames_.push_back(denseFrames[index]);
+        lengths_.push_back(denseLengths[index]);
+        ringSources_.push_back(std::min((index + samplesPerSpan / 2) / samplesPerSpan, path.points.size() - 1));
+    }
+
+    const std::size_t spanCount = selected.size() - 1;
+    const std::size_t spansPerChunk = std::max<std::size_t>(1, options.ringsPerChunk - 1);
+    for (std::size_t first = 0; first < spanCount; first += spansPerChunk) {
+        Chunk chunk;
+        chunk.firstRing = first;
+        chunk.lastRing = std::min(spanCount, first + spansPerChunk);
+        chunk.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        chunk.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+
+        for (std::size_t ring = chunk.firstRing; ring <= chunk.lastRing; ++ring) {
+            const float radius = rings_.radii[ring];
+            chunk.boundsMin = glm::min(chunk.boundsMin, rings_.points[ring] - glm::vec3(radius));
+            chunk.boundsMax = glm::max(chunk.boundsMax, rings_.points[ring] + glm::vec3(radius));
+            chunk.maxRadius = std::max(chunk.maxRadius, radius);
+        }
+        chunks_.push_back(std::move(chunk));
+    }
+}
+
+void AdaptiveTube::update(const Camera& camera) {
+    struct Pending {
+        std::size_t chunk;
+        int errorClass;
+        float distance;
+    };
+
+    std::vector<Pending> pending;
+    for (std::size_t i = 0; i < chunks_.size(); ++i) {
+        const int wanted = requiredClass(chunks_[i], camera);
+        if (wanted != chunks_[i].errorClass) {
+            pending.push_back({i, wanted, distanceToBox(camera.position(), chunks_[i].boundsMin, chunks_[i].boundsMax)});
+        }
+    }
+
+    if (pending.empty()) {
+        return;
+    }
+
+    // Nearest chunks first: they carry the most visible error.
+    std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+        return a.distance < b.distance;
+    });
+    if (options_.maxRebuildsPerUpdate > 0 && pending.size() > options_.maxRebuildsPerUpdate) {
+        pending.resize(options_.maxRebuildsPerUpdate);
+    }
+
+    std::vector<meshgen::SweptChunk> generated(pending.size());
+    std::vector<std::vector<meshgen::Meshlet>> meshlets(pending.size());
+    parallelFor(pending.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const Chunk& chunk = chunks_[pending[i].chunk];
+            generated[i] = meshgen::buildSweepChunk(
+                rings_,
+                frames_,
+                lengths_,
+                chunk.firstRing,
+                chunk.lastRing,
+                kRadialClasses[static_cast<std::size_t>(pending[i].errorClass)],
+                options_.textureLength
+            );
+            meshlets[i] = meshgen::buildMeshlets(
+                generated[i].vertices.data(),
+                generated[i].vertices.size() / app::kVertexStrideFloats,
+                generated[i].indices.data(),
+                generated[i].indices.size()
+            );
+        }
+    });
+
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        Chunk& chunk = chunks_[pending[i].chunk];
+        chunk.mesh = Mesh::createClustered(
+            generated[i].vertices.data(),
+            generated[i].vertices.size() * sizeof(float),
+            generated[i].indices.data(),
+            generated[i].indices.size() * sizeof(unsigned int),
+            std::move(meshlets[i])
+        );
+        chunk.errorClass = pending[i].errorClass;
+    }
+}
+
+void AdaptiveTube::draw(const Frustum& frustum, const glm::vec3& cameraPosition, const ChunkCallback& beforeChunk) const {
+    for (const Chunk& chunk : chunks_) {
+        if (chunk.errorClass < 0 || !frustum.intersectsBox(chunk.boundsMin, chunk.boundsMax)) {
+            continue;
+        }
+
+        if (beforeChunk) {
+            beforeChunk(chunk.firstRing, kRadialClasses[static_cast<std::size_t>(chunk.errorClass)] + 1);
+        }
+        chunk.mesh.drawCulled(frustum, cameraPosition);
+    }
+}
+
+std::size_t AdaptiveTube::chunkCount() const {
+    return chunks_.size();
+}
+
+std::size_t AdaptiveTube::ringCount() const {
+    return rings_.points.size();
+}
+
+const std::vector<std::size_t>& AdaptiveTube::ringSources() const {
+    return ringSources_;
+}
+
+int AdaptiveTube::requiredClass(const Chunk& chunk, const Camera& camera) const {
+    const float distance = distanceToBox(camera.position(), chunk.boundsMin, chunk.boundsMax);
+    const float pixelsPerUnit = camera.pixelsPerUnit(distance);
+    const int lastClass = static_cast<int>(kRadialClasses.size()) - 1;
+
+    const auto classFor = [&](float pixelError) {
+        for (int i = 0; i < lastClass; ++i) {
+            const float error = meshgen::ringSagitta(chunk.maxRadius, kRadialClasses[static_cast<std::size_t>(i)]);
+            if (error * pixelsPerUnit <= pixelError) {
+                return i;
+            }
+        }
+        return lastClass;
+    };
+
+    const int refined = classFor(options_.pixelError);
+    if (chunk.errorClass < 0 || refined > chunk.errorClass) {
+        return refined;
+    }
+
+    return std::max(refined, std::min(chunk.errorClass, classFor(options_.pixelError * kCoarsenHysteresis)));
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "engine/Camera.h"
+#include "engine/Frustum.h"
+#include "engine/Mesh.h"
+#include "engine/TubeSweep.h"
+#include "engine/TubeTessellation.h"
+
+struct AdaptiveTubeOptions {
+    meshgen::RingPlacement placement;
+    int splineSubdivisions = 4;
+    std::size_t ringsPerChunk = 128;
+    float textureLength = 1.0f;
+    // Allowed silhouette deviation of the ring polygon, in pixels.
+    float pixelError = 0.5f;
+    // Chunks re-tessellated per update; the rest wait for later frames.
+    std::size_t maxRebuildsPerUpdate = 16;
+};
+
+class AdaptiveTube {
+public:
+    static constexpr std::array<int, 5> kRadialClasses = {4, 8, 16, 32, 64};
+
+    void build(const meshgen::SweepPath& path, const AdaptiveTubeOptions& options);
+    using ChunkCallback = std::function<void(std::size_t firstRing, int ringSize)>;
+
+    void update(const Camera& camera);
+    void draw(const Frustum& frustum, const glm::vec3& cameraPosition, const ChunkCallback& beforeChunk = {}) const;
+
+    [[nodiscard]] std::size_t chunkCount() const;
+    [[nodiscard]] std::size_t ringCount() const;
+    // Index of the input path point each ring was generated from, so
+    // per-point data can be resampled onto the rings.
+    [[nodiscard]] const std::vector<std::size_t>& ringSources() const;
+
+private:
+    struct Chunk {
+        std::size_t firstRing = 0;
+        std::size_t lastRing = 0;
+        glm::vec3 boundsMin{0.0f};
+        glm::vec3 boundsMax{0.0f};
+        float maxRadius = 0.0f;
+        int errorClass = -1;
+        Mesh mesh;
+    };
+
+    [[nodiscard]] int requiredClass(const Chunk& chunk, const Camera& camera) const;
+
+    AdaptiveTubeOptions options_;
+    meshgen::SweepPath rings_;
+    std::vector<meshgen::SweepFrame> frames_;
+    std::vector<float> lengths_;
+    std::vector<std::size_t> ringSources_;
+    std::vector<Chunk> chunks_;
+};
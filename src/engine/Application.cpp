@@ -1,15 +1,82 @@
 #include "engine/Application.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "app_config.hpp"
+#include "engine/DefaultMeshes.h"
 #include "engine/Mesh.h"
+#include "engine/ProgramCache.h"
+#include "engine/ShaderManager.h"
 #include "engine/Texture.h"
+#include "engine/TextureLoader.h"
+#include "engine/TextureStreamer.h"
 
-Application::Application() = default;
+namespace {
+
+meshgen::SweepPath demoRoute() {
+    meshgen::SweepPath path;
+    path.points.resize(app::kRoutePointCount);
+    path.radii.resize(app::kRoutePointCount);
+
+    for (int i = 0; i < app::kRoutePointCount; ++i) {
+        const float t = static_cast<float>(i) / static_cast<float>(app::kRoutePointCount - 1);
+        const float angle = t * app::kRouteHelixTurns * 2.0f * 3.14159265359f;
+        path.points[i] = {
+            app::kRouteHelixRadius * std::cos(angle),
+            -1.0f + t * app::kRouteRise,
+            app::kRouteHelixRadius * std::sin(angle),
+        };
+        path.radii[i] = app::kRouteTubeRadius * (1.0f + 0.3f * std::sin(angle * 4.0f));
+    }
+
+    return path;
+}
+
+// A pipe rack beside the scene: a square grid of horizontal runs with a
+// vertical riser at every node, colour-coded by row.
+std::vector<TubeSegment> demoNetwork() {
+    constexpr int kSize = app::kNetworkGridSize;
+    constexpr float kSpacing = app::kNetworkSpacing;
+    const glm::vec3 origin(-12.0f - kSize * kSpacing, -1.0f, -0.5f * kSize * kSpacing);
+
+    std::vector<TubeSegment> segments;
+    segments.reserve(static_cast<std::size_t>(3 * kSize * kSize));
+
+    for (int row = 0; row < kSize; ++row) {
+        const float shade = static_cast<float>(row) / static_cast<float>(kSize - 1);
+        const std::uint32_t color = TubeNetwork::packColor({0.3f + 0.6f * shade, 0.55f, 0.9f - 0.6f * shade});
+
+        for (int column = 0; column < kSize; ++column) {
+            const glm::vec3 node = origin + glm::vec3(column * kSpacing, 1.5f, row * kSpacing);
+            const glm::vec3 base(node.x, origin.y, node.z);
+
+            segments.push_back({base, app::kNetworkPipeRadius, node, color});
+            if (column + 1 < kSize) {
+                segments.push_back({node, app::kNetworkPipeRadius, node + glm::vec3(kSpacing, 0.0f, 0.0f), color});
+            }
+            if (row + 1 < kSize) {
+                segments.push_back({node, app::kNetworkPipeRadius, node + glm::vec3(0.0f, 0.0f, kSpacing), color});
+            }
+        }
+    }
+
+    return segments;
+}
+
+}  // namespace
+
+Application::Application(std::string datasetPath, std::string heightmapPath, std::string groundPath)
+    : datasetPath_(std::move(datasetPath)),
+      heightmapPath_(std::move(heightmapPath)),
+      groundPath_(std::move(groundPath)) {}
 
 Application::~Application() {
     shutdown();
@@ -39,6 +106,7 @@ void Application::initialize() {
     initializeWindow();
     renderer_.initialize();
     initializeScene();
+    ShaderManager::shared().finish();
     initialized_ = true;
 }
 
@@ -68,44 +136,120 @@ void Application::initializeWindow() {
     if (!gladLoadGL(glfwGetProcAddress)) {
         throw std::runtime_error("Erro ao carregar OpenGL");
     }
+    ProgramCache::shared().initialize(glfwGetProcAddress);
+    ShaderManager::shared().initialize(glfwGetProcAddress);
 
     glEnable(GL_DEPTH_TEST);
     glViewport(0, 0, app::kWindowWidth, app::kWindowHeight);
     camera_.attach(window_);
 }
 
-void Application::initializeScene() {    
+void Application::initializeScene() {
+#ifndef NDEBUG
+    if (!app::validateDefaultMeshes()) {
+        std::cerr << "Malhas padrao divergem do gerador em tempo de execucao\n";
+    }
+#endif
+
     tube_ = GameObject(
-        Mesh::createTube(
-            app::kTubeInnerRadius,
-            app::kTubeOuterRadius,
-            app::kTubeHeight,
-            app::kTubeSegments
+        meshes_.tube(
+            {app::kTubeInnerRadius, app::kTubeOuterRadius, app::kTubeHeight, app::kTubeSegments},
+            []() {
+                return Mesh::createFromRawWithLods(
+                    app::kDefaultTube.vertices.data(),
+                    app::kDefaultTube.vertices.size() * sizeof(float),
+                    app::kDefaultTube.indices.data(),
+                    app::kDefaultTube.indices.size() * sizeof(unsigned int)
+                );
+            }
         ),
-        Texture("wall.jpg")
+        textures_.load("wall.jpg")
     );
 
-    ground_ = GameObject(
-        Mesh::createFromRaw(
-            app::kGroundVertices.data(),
-            app::kGroundVertices.size() * sizeof(float),
-            app::kGroundIndices.data(),
-            app::kGroundIndices.size() * sizeof(unsigned int),
-            true
-        ),
-        Texture("ground.jpg")
-    );
+    tube_.deformation.enabled = true;
+    tube_.deformation.pulseAmplitude = app::kTubePulseAmplitude;
+    tube_.deformation.pulseWavelength = app::kTubePulseWavelength;
+    tube_.deformation.pulseSpeed = app::kTubePulseSpeed;
+    tube_.deformation.twistRate = app::kTubeTwistRate;
+
+    // Upright, undeformed copies of the tube ringed around the scene. They
+    // share one impostor, baked once their texture has arrived.
+    propImpostor_ = std::make_shared<ImpostorAtlas>();
+    for (int i = 0; i < app::kPropCount; ++i) {
+        const float angle = static_cast<float>(i) / static_cast<float>(app::kPropCount) * 2.0f * 3.14159265359f;
+        GameObject prop(tube_.mesh, tube_.texture);
+        prop.position = {app::kPropRingRadius * std::cos(angle), app::kGroundHeight, app::kPropRingRadius * std::sin(angle)};
+        prop.rotation.x = -90.0f;
+        prop.impostor = propImpostor_;
+        props_.push_back(std::move(prop));
+    }
+
+    TerrainOptions terrainOptions;
+    terrainOptions.gridSize = app::kTerrainGridSize;
+    terrainOptions.levels = app::kTerrainLevels;
+    terrainOptions.baseHeight = app::kGroundHeight;
+    terrainOptions.flatRadius = app::kTerrainFlatRadius;
+    terrainOptions.tilesPerFrame = app::kTerrainTilesPerFrame;
+    terrain_.initialize(terrainOptions);
+    if (!heightmapPath_.empty()) {
+        try {
+            terrain_.open(heightmapPath_);
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << '\n';
+        }
+    }
+    groundTexture_ = textures_.load("ground.jpg");
+    if (!groundPath_.empty()) {
+        VirtualTextureOptions groundOptions;
+        groundOptions.cachePagesPerSide = app::kVirtualCachePagesPerSide;
+        groundOptions.pagesPerFrame = app::kVirtualPagesPerFrame;
+        groundOptions.feedbackDivisor = app::kVirtualFeedbackDivisor;
+        groundVirtual_.initialize(groundOptions);
+        try {
+            groundVirtual_.open(groundPath_);
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << '\n';
+        }
+    }
 
     lightSphere_ = GameObject(
-        Mesh::createSphere(
-            app::kLightSphereRadius,
-            app::kLightSphereSectors,
-            app::kLightSphereStacks
+        meshes_.sphere(
+            {app::kLightSphereRadius, app::kLightSphereSectors, app::kLightSphereStacks},
+            []() {
+                return Mesh::createFromRaw(
+                    app::kDefaultLightSphere.vertices.data(),
+                    app::kDefaultLightSphere.vertices.size() * sizeof(float),
+                    app::kDefaultLightSphere.indices.data(),
+                    app::kDefaultLightSphere.indices.size() * sizeof(unsigned int),
+                    false
+                );
+            }
         ),
-        Texture()
+        nullptr
     );
     lightSphere_.position = lightPosition(0.0f);
 
+    AdaptiveTubeOptions routeOptions;
+    routeOptions.ringsPerChunk = app::kRouteRingsPerChunk;
+    routeOptions.splineSubdivisions = app::kRouteSplineSubdivisions;
+    routeOptions.pixelError = app::kRoutePixelError;
+    route_.build(demoRoute(), routeOptions);
+    routeTexture_ = textures_.load("wall.jpg");
+    routeScalars_.initialize(route_.ringCount(), -1.0f, 1.0f);
+
+    const std::vector<TubeSegment> networkSegments = demoNetwork();
+    network_.initialize(app::kNetworkRadialSegments, app::kNetworkCapStacks, app::kNetworkSegmentsPerCluster);
+    network_.setSegments(networkSegments.data(), networkSegments.size());
+
+    if (!datasetPath_.empty()) {
+        dataset_.initialize(app::kNetworkRadialSegments, app::kNetworkCapStacks, app::kNetworkSegmentsPerCluster);
+        try {
+            datasetStream_.open(datasetPath_);
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << '\n';
+        }
+    }
+
     particles_.initialize(500);
     particles_.setEmitterPosition(lightSphere_.position);
 }
@@ -127,20 +271,114 @@ void Application::update(float currentFrame) {
     lastFrame_ = currentFrame;
 
     input_.process(window_, camera_, deltaTime);
+    ShaderManager::shared().update();
+    TextureLoader::shared().pump(app::kTextureUploadBudgetBytes, app::kTextureUploadBudgetSeconds);
+    textures_.collectGarbage();
     lightSphere_.position = lightPosition(currentFrame);
     particles_.setEmitterPosition(lightSphere_.position);
     particles_.update(deltaTime);
+    route_.update(camera_);
+    updateRouteScalars(currentFrame);
+    updateDataset();
+    terrain_.update(camera_);
+    groundVirtual_.update(app::kTextureUploadBudgetBytes, app::kTextureUploadBudgetSeconds);
+    tube_.deformation.bendCurvature = app::kTubeFlexCurvature * sinf(currentFrame * 0.7f);
+    requestTextureDetail();
+    TextureStreamer::shared().update(app::kTextureUploadBudgetBytes, app::kTextureUploadBudgetSeconds);
 }
 
 void Application::render() {
     glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    renderer_.renderScene(camera_, tube_, ground_, lightSphere_);
+    // The atlas is baked once, so it waits for the finest level.
+    if (!props_.empty() && !propImpostor_->baked() && props_.front().texture->complete()) {
+        ImpostorAtlasOptions impostorOptions;
+        impostorOptions.framesPerSide = app::kImpostorFramesPerSide;
+        impostorOptions.frameSize = app::kImpostorFrameSize;
+        renderer_.bakeImpostor(props_.front(), *propImpostor_, impostorOptions);
+    }
+
+    renderer_.renderScene(camera_, tube_, lightSphere_, lastFrame_);
+    renderer_.renderTerrainFeedback(camera_, terrain_, groundVirtual_);
+    renderer_.renderTerrain(camera_, terrain_, *groundTexture_, lightSphere_.position, &groundVirtual_);
+    renderer_.renderObjects(camera_, props_, lightSphere_.position);
+    renderer_.renderSweptTube(camera_, route_, *routeTexture_, lightSphere_.position, &routeScalars_);
+    renderer_.renderTubeNetwork(camera_, network_, networkLod_, lightSphere_.position);
+    if (dataset_.segmentCount() > 0) {
+        renderer_.renderTubeNetwork(camera_, dataset_, networkLod_, lightSphere_.position);
+    }
 
     particles_.draw(camera_);
 }
 
+void Application::updateRouteScalars(float timeSeconds) {
+    // A new timestep is produced per input point at a fixed rate and
+    // resampled onto the rings; the upload itself is spread over frames.
+    if (routeScalarTime_ < 0.0f || timeSeconds - routeScalarTime_ >= app::kRouteScalarInterval) {
+        routeScalarTime_ = timeSeconds;
+
+        std::vector<float> pressure(app::kRoutePointCount);
+        for (int i = 0; i < app::kRoutePointCount; ++i) {
+            const float t = static_cast<float>(i) / static_cast<float>(app::kRoutePointCount - 1);
+            pressure[i] = std::sin((t * app::kRouteScalarWaves - timeSeconds * app::kRouteScalarSpeed) * 2.0f * 3.14159265359f);
+        }
+
+        const std::vector<std::size_t>& sources = route_.ringSources();
+        std::vector<float> values(sources.size());
+        for (std::size_t ring = 0; ring < sources.size(); ++ring) {
+            values[ring] = pressure[sources[ring]];
+        }
+        routeScalars_.submit(std::move(values));
+    }
+
+    routeScalars_.pump(app::kScalarUploadBudgetBytes);
+}
+
+// Streamed textures keep the level that maps about one texel to a pixel at
+// the nearest point of each object using them, measured the same way the
+// renderer picks mesh LODs.
+void Application::requestTextureDetail() {
+    const auto request = [this](const GameObject& object) {
+        if (object.texture == nullptr || object.mesh->uvDensity() <= 0.0f) {
+            return;
+        }
+        const glm::mat4 model = object.modelMatrix();
+        const float scale = std::max({object.scale.x, object.scale.y, object.scale.z});
+        const float radius = object.mesh->boundingRadius() * scale;
+        const glm::vec3 center(model * glm::vec4(object.mesh->boundingCenter(), 1.0f));
+        const float distance = std::max(0.0f, glm::length(camera_.position() - center) - radius);
+        object.texture->requestDetail(object.mesh->uvDensity() / scale / camera_.pixelsPerUnit(distance));
+    };
+    request(tube_);
+    for (const GameObject& prop : props_) {
+        request(prop);
+    }
+    // The impostor bake needs level 0 however far away the props are.
+    if (!props_.empty() && !propImpostor_->baked() && props_.front().texture != nullptr) {
+        props_.front().texture->requestDetail(0.0f);
+    }
+
+    const float groundDistance = std::max(0.0f, camera_.position().y - app::kGroundHeight);
+    groundTexture_->requestDetail(app::kGroundTexCoordScale / camera_.pixelsPerUnit(groundDistance));
+}
+
+// Whatever the loader has parsed so far is appended each frame, capped so a
+// fast parser cannot stall rendering with one huge upload.
+void Application::updateDataset() {
+    if (!datasetStream_.active()) {
+        return;
+    }
+
+    datasetBatch_.clear();
+    if (datasetStream_.poll(datasetBatch_, app::kDatasetSegmentsPerFrame) > 0) {
+        dataset_.appendSegments(datasetBatch_.data(), datasetBatch_.size());
+    }
+    if (datasetStream_.finished()) {
+        datasetStream_.close();
+    }
+}
+
 bool Application::isRunning() const {
     return window_ != nullptr && !glfwWindowShouldClose(window_);
 }
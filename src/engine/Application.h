@@ -3,15 +3,28 @@
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "app_config.hpp"
+#include "engine/AdaptiveTube.h"
 #include "engine/Camera.h"
 #include "engine/GameObject.h"
 #include "engine/Input.h"
+#include "engine/MeshRegistry.h"
 #include "engine/Renderer.h"
 #include "engine/ParticleSystem.h"
+#include "engine/PolylineStream.h"
+#include "engine/ScalarField.h"
+#include "engine/Terrain.h"
+#include "engine/TextureRegistry.h"
+#include "engine/TubeNetwork.h"
+#include "engine/VirtualTexture.h"
 
 class Application {
 public:
-    Application();
+    explicit Application(std::string datasetPath = "", std::string heightmapPath = "", std::string groundPath = "");
     ~Application();
 
     void run();
@@ -23,6 +36,9 @@ private:
     void shutdown();
     void update(float currentFrame);
     void render();
+    void updateRouteScalars(float timeSeconds);
+    void updateDataset();
+    void requestTextureDetail();
 
     [[nodiscard]] bool isRunning() const;
     [[nodiscard]] glm::vec3 lightPosition(float timeSeconds) const;
@@ -34,10 +50,34 @@ private:
     Camera camera_;
     Input input_;
     Renderer renderer_;
+    MeshRegistry meshes_;
+    TextureRegistry textures_;
 
     GameObject tube_;
-    GameObject ground_;
+    Terrain terrain_;
+    TextureHandle groundTexture_;
+    VirtualTexture groundVirtual_;
     GameObject lightSphere_;
+    std::vector<GameObject> props_;
+    std::shared_ptr<ImpostorAtlas> propImpostor_;
+    AdaptiveTube route_;
+    TextureHandle routeTexture_;
+    ScalarField routeScalars_;
+    float routeScalarTime_ = -1.0f;
+    TubeNetwork network_;
+    TubeLodPolicy networkLod_{
+        app::kNetworkImpostorPixels,
+        false,
+        app::kNetworkLinePixels,
+        app::kNetworkAggregatePixels,
+    };
+
+    std::string datasetPath_;
+    std::string heightmapPath_;
+    std::string groundPath_;
+    TubeNetwork dataset_;
+    PolylineStream datasetStream_;
+    std::vector<TubeSegment> datasetBatch_;
 
     ParticleSystem particles_;
 };
@@ -1,11 +1,14 @@
 #include "engine/Camera.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include <glad/gl.h>
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "app_config.hpp"
+
 namespace {
 
 Camera* g_activeCamera = nullptr;
@@ -70,6 +73,7 @@ void Camera::onFramebufferResize(int width, int height) {
     glViewport(0, 0, width, height);
     if (height > 0) {
         aspectRatio_ = static_cast<float>(width) / static_cast<float>(height);
+        viewportHeight_ = static_cast<float>(height);
     }
 }
 
@@ -102,13 +106,18 @@ glm::mat4 Camera::viewMatrix() const {
 }
 
 glm::mat4 Camera::projectionMatrix() const {
-    return glm::perspective(glm::radians(zoom_), aspectRatio_, 0.1f, 100.0f);
+    return glm::perspective(glm::radians(zoom_), aspectRatio_, app::kCameraNearPlane, app::kCameraFarPlane);
 }
 
 const glm::vec3& Camera::position() const {
     return position_;
 }
 
+float Camera::pixelsPerUnit(float distance) const {
+    const float halfHeight = std::max(distance, 0.1f) * std::tan(glm::radians(zoom_) * 0.5f);
+    return viewportHeight_ / (2.0f * halfHeight);
+}
+
 void Camera::updateFrontVector() {
     glm::vec3 direction;
     direction.x = cos(glm::radians(yaw_)) * cos(glm::radians(pitch_));
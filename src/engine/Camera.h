@@ -24,6 +24,7 @@ public:
     [[nodiscard]] glm::mat4 viewMatrix() const;
     [[nodiscard]] glm::mat4 projectionMatrix() const;
     [[nodiscard]] const glm::vec3& position() const;
+    [[nodiscard]] float pixelsPerUnit(float distance) const;
 
 private:
     void updateFrontVector();
@@ -38,5 +39,6 @@ private:
     float lastX_ = 400.0f;
     float lastY_ = 300.0f;
     float aspectRatio_ = 800.0f / 600.0f;
+    float viewportHeight_ = 600.0f;
     bool firstMouse_ = true;
 };
@@ -0,0 +1,101 @@
+#include "engine/Capsule.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+int longestAxis(const glm::vec3& extent) {
+    return extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+}
+
+float volume(const Capsule& capsule) {
+    const float r = capsule.radius;
+    return r * r * (glm::length(capsule.end - capsule.start) + 4.0f / 3.0f * r);
+}
+
+}  // namespace
+
+// Every point of the box lies between the end planes and within half the
+// cross-section diagonal of the axis.
+Capsule enclosingCapsule(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    const glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+    const glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+    const int axis = longestAxis(extent);
+
+    Capsule capsule;
+    capsule.start = center;
+    capsule.end = center;
+    capsule.start[axis] = boundsMin[axis];
+    capsule.end[axis] = boundsMax[axis];
+    capsule.radius = 0.5f * std::sqrt(
+        extent[(axis + 1) % 3] * extent[(axis + 1) % 3] + extent[(axis + 2) % 3] * extent[(axis + 2) % 3]
+    );
+    return capsule;
+}
+
+// A capsule is the convex hull of its end spheres, so holding those holds
+// it. A sphere at axial position t and distance q from the axis fits when
+// q + r <= R and it is within R - r of the axis segment, which bounds the
+// segment ends to [t - s, t + s] with s = sqrt((R - r)^2 - q^2).
+Capsule enclosingCapsule(
+    const glm::vec3& boundsMin,
+    const glm::vec3& boundsMax,
+    const Capsule* capsules,
+    std::size_t count
+) {
+    const Capsule boxCapsule = enclosingCapsule(boundsMin, boundsMax);
+    if (count == 0) {
+        return boxCapsule;
+    }
+
+    const glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+    glm::vec3 direction(0.0f);
+    direction[longestAxis(boundsMax - boundsMin)] = 1.0f;
+
+    const auto place = [&](const glm::vec3& point, float& t, float& q) {
+        const glm::vec3 offset = point - center;
+        t = glm::dot(offset, direction);
+        q = glm::length(offset - t * direction);
+    };
+
+    float radius = 0.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        for (const glm::vec3& point : {capsules[i].start, capsules[i].end}) {
+            float t = 0.0f;
+            float q = 0.0f;
+            place(point, t, q);
+            radius = std::max(radius, q + capsules[i].radius);
+        }
+    }
+
+    float low = std::numeric_limits<float>::max();
+    float high = std::numeric_limits<float>::lowest();
+    for (std::size_t i = 0; i < count; ++i) {
+        const float slack = radius - capsules[i].radius;
+        for (const glm::vec3& point : {capsules[i].start, capsules[i].end}) {
+            float t = 0.0f;
+            float q = 0.0f;
+            place(point, t, q);
+            const float reach = std::sqrt(std::max(slack * slack - q * q, 0.0f));
+            low = std::min(low, t + reach);
+            high = std::max(high, t - reach);
+        }
+    }
+    // Any point between the two bounds serves when the spheres overlap.
+    if (low > high) {
+        low = high = 0.5f * (low + high);
+    }
+
+    const Capsule fitted{center + low * direction, center + high * direction, radius};
+    return volume(fitted) < volume(boxCapsule) ? fitted : boxCapsule;
+}
+
+bool containsSphere(const Capsule& capsule, const glm::vec3& center, float radius) {
+    const glm::vec3 axis = capsule.end - capsule.start;
+    const float lengthSquared = glm::dot(axis, axis);
+    const float t = lengthSquared > 0.0f ? std::clamp(glm::dot(center - capsule.start, axis) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+    const float distance = glm::length(center - (capsule.start + t * axis));
+    return distance + radius <= capsule.radius * (1.0f + 1.0e-5f) + 1.0e-6f;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// Every point within radius of the segment [start, end].
+struct Capsule {
+    glm::vec3 start{0.0f};
+    glm::vec3 end{0.0f};
+    float radius = 0.0f;
+};
+
+// Capsule along the longest axis of the box that holds the whole box.
+[[nodiscard]] Capsule enclosingCapsule(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+// Capsule holding every one of capsules, which must lie inside the box:
+// the tighter of the box's capsule and one along the same axis fitted to
+// the end spheres of capsules.
+[[nodiscard]] Capsule enclosingCapsule(
+    const glm::vec3& boundsMin,
+    const glm::vec3& boundsMax,
+    const Capsule* capsules,
+    std::size_t count
+);
+
+[[nodiscard]] bool containsSphere(const Capsule& capsule, const glm::vec3& center, float radius);
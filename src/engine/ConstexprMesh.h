@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "app_config.hpp"
+
+namespace meshgen {
+
+template <std::size_t VertexFloats, std::size_t IndexCount>
+struct StaticMeshData {
+    std::array<float, VertexFloats> vertices{};
+    std::array<unsigned int, IndexCount> indices{};
+};
+
+namespace detail {
+
+inline constexpr double kConstexprPi = 3.14159265358979323846;
+
+// Taylor series after reduction to [-pi, pi]; 20 terms keep the error well
+// below float precision over the whole reduced range.
+constexpr double constexprSin(double x) {
+    while (x > kConstexprPi) {
+        x -= 2.0 * kConstexprPi;
+    }
+    while (x < -kConstexprPi) {
+        x += 2.0 * kConstexprPi;
+    }
+
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 20; ++n) {
+        term *= -x * x / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCos(double x) {
+    return constexprSin(x + kConstexprPi / 2.0);
+}
+
+// Same float expression as the runtime kernels so both sides start from the
+// identical angle.
+constexpr float ringAngle(int index, int count) {
+    return 2.0f * 3.14159265359f * static_cast<float>(index) / static_cast<float>(count);
+}
+
+}  // namespace detail
+
+template <int Segments>
+using StaticTube = StaticMeshData<
+    static_cast<std::size_t>(Segments + 1) * 4 * app::kVertexStrideFloats,
+    static_cast<std::size_t>(Segments) * 24
+>;
+
+template <int Sectors, int Stacks>
+using StaticSphere = StaticMeshData<
+    static_cast<std::size_t>((Stacks + 1) * (Sectors + 1)) * app::kVertexStrideFloats,
+    static_cast<std::size_t>(Sectors * (2 * Stacks - 2) * 3)
+>;
+
+template <int Segments>
+constexpr StaticTube<Segments> makeStaticTube(float innerRadius, float outerRadius, float height) {
+    static_assert(Segments > 0, "tube needs at least one segment");
+
+    StaticTube<Segments> mesh;
+    std::size_t v = 0;
+    std::size_t i = 0;
+
+    for (int segment = 0; segment <= Segments; ++segment) {
+        const double theta = detail::ringAngle(segment, Segments);
+        const auto c = static_cast<float>(detail::constexprCos(theta));
+        const auto s = static_cast<float>(detail::constexprSin(theta));
+        const float u = static_cast<float>(segment) / static_cast<float>(Segments);
+
+        const float ring[] = {
+            outerRadius * c, outerRadius * s, 0.0f, c, s, 0.0f, u, 0.0f,
+            outerRadius * c, outerRadius * s, height, c, s, 0.0f, u, 1.0f,
+            innerRadius * c, innerRadius * s, 0.0f, -c, -s, 0.0f, u, 0.0f,
+            innerRadius * c, innerRadius * s, height, -c, -s, 0.0f, u, 1.0f,
+        };
+        for (const float value : ring) {
+            mesh.vertices[v++] = value;
+        }
+    }
+
+    for (int segment = 0; segment < Segments; ++segment) {
+        const auto base = static_cast<unsigned int>(segment * 4);
+        const auto next = static_cast<unsigned int>((segment + 1) * 4);
+        const unsigned int quad[] = {
+            base, next + 1, base + 1,
+            base, next, next + 1,
+
+            base + 2, next + 3, next + 2,
+            base + 2, base + 3, next + 3,
+
+            base + 1, next + 1, next + 3,
+            base + 1, next + 3, base + 3,
+
+            base, base + 2, next + 2,
+            base, next + 2, next,
+        };
+        for (const unsigned int index : quad) {
+            mesh.indices[i++] = index;
+        }
+    }
+
+    return mesh;
+}
+
+template <int Sectors, int Stacks>
+constexpr StaticSphere<Sectors, Stacks> makeStaticSphere(float radius) {
+    static_assert(Sectors > 0 && Stacks > 1, "sphere needs at least one sector and two stacks");
+
+    StaticSphere<Sectors, Stacks> mesh;
+    std::size_t v = 0;
+    std::size_t i = 0;
+
+    for (int stack = 0; stack <= Stacks; ++stack) {
+        const double stackAngle =
+            (3.14159265359f / 2.0f) - (static_cast<float>(stack) * 3.14159265359f / static_cast<float>(Stacks));
+        const float xy = radius * static_cast<float>(detail::constexprCos(stackAngle));
+        const float z = radius * static_cast<float>(detail::constexprSin(stackAngle));
+
+        for (int sector = 0; sector <= Sectors; ++sector) {
+            const double sectorAngle = detail::ringAngle(sector, Sectors);
+            const float x = xy * static_cast<float>(detail::constexprCos(sectorAngle));
+            const float y = xy * static_cast<float>(detail::constexprSin(sectorAngle));
+
+            const float vertex[] = {
+                x, y, z,
+                x / radius, y / radius, z / radius,
+                static_cast<float>(sector) / static_cast<float>(Sectors),
+                static_cast<float>(stack) / static_cast<float>(Stacks),
+            };
+            for (const float value : vertex) {
+                mesh.vertices[v++] = value;
+            }
+        }
+    }
+
+    for (int stack = 0; stack < Stacks; ++stack) {
+        auto current = static_cast<unsigned int>(stack * (Sectors + 1));
+        auto next = static_cast<unsigned int>(current + Sectors + 1);
+
+        for (int sector = 0; sector < Sectors; ++sector, ++current, ++next) {
+            if (stack != 0) {
+                mesh.indices[i++] = current;
+                mesh.indices[i++] = next;
+                mesh.indices[i++] = current + 1;
+            }
+            if (stack != Stacks - 1) {
+                mesh.indices[i++] = current + 1;
+                mesh.indices[i++] = next;
+                mesh.indices[i++] = next + 1;
+            }
+        }
+    }
+
+    return mesh;
+}
+
+}  // namespace meshgen
@@ -0,0 +1,72 @@
+#include "engine/DefaultMeshes.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "engine/MeshKernels.h"
+
+namespace app {
+
+namespace {
+
+constexpr float kTolerance = 1.0e-5f;
+
+template <typename StaticData>
+bool matches(
+    const char* name,
+    const StaticData& expected,
+    const meshgen::MeshLayout& layout,
+    const std::vector<float>& vertices,
+    const std::vector<unsigned int>& indices
+) {
+    if (layout.vertexCount * kVertexStrideFloats != expected.vertices.size()
+        || layout.indexCount != expected.indices.size()) {
+        std::cerr << "Malha padrao com tamanho divergente: " << name << '\n';
+        return false;
+    }
+
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        if (std::fabs(vertices[i] - expected.vertices[i]) > kTolerance) {
+            std::cerr << "Malha padrao divergente: " << name << " vertice " << i / kVertexStrideFloats << '\n';
+            return false;
+        }
+    }
+
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        if (indices[i] != expected.indices[i]) {
+            std::cerr << "Malha padrao divergente: " << name << " indice " << i << '\n';
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace
+
+bool validateDefaultMeshes() {
+    const meshgen::MeshLayout tubeLayout = meshgen::tubeLayout(kTubeSegments);
+    std::vector<float> tubeVertices(tubeLayout.vertexCount * kVertexStrideFloats);
+    std::vector<unsigned int> tubeIndices(tubeLayout.indexCount);
+    meshgen::writeTube(
+        {kTubeInnerRadius, kTubeOuterRadius, kTubeHeight, kTubeSegments},
+        tubeVertices.data(),
+        tubeIndices.data()
+    );
+
+    const meshgen::MeshLayout sphereLayout = meshgen::sphereLayout(kLightSphereSectors, kLightSphereStacks);
+    std::vector<float> sphereVertices(sphereLayout.vertexCount * kVertexStrideFloats);
+    std::vector<unsigned int> sphereIndices(sphereLayout.indexCount);
+    meshgen::writeSphere(
+        {kLightSphereRadius, kLightSphereSectors, kLightSphereStacks},
+        sphereVertices.data(),
+        sphereIndices.data()
+    );
+
+    const bool tubeMatches = matches("tubo", kDefaultTube, tubeLayout, tubeVertices, tubeIndices);
+    const bool sphereMatches = matches("esfera", kDefaultLightSphere, sphereLayout, sphereVertices, sphereIndices);
+    return tubeMatches && sphereMatches;
+}
+
+}  // namespace app
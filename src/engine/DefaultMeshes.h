@@ -0,0 +1,26 @@
+#pragma once
+
+#include "app_config.hpp"
+#include "engine/ConstexprMesh.h"
+
+namespace app {
+
+inline constexpr auto kDefaultTube = meshgen::makeStaticTube<kTubeSegments>(
+    kTubeInnerRadius,
+    kTubeOuterRadius,
+    kTubeHeight
+);
+
+inline constexpr auto kDefaultLightSphere = meshgen::makeStaticSphere<kLightSphereSectors, kLightSphereStacks>(
+    kLightSphereRadius
+);
+
+static_assert(kDefaultTube.vertices[0] == kTubeOuterRadius, "tube ring must start on +X");
+static_assert(kDefaultTube.vertices[10] == kTubeHeight, "second tube vertex must sit on the top rim");
+static_assert(kDefaultLightSphere.vertices[2] == kLightSphereRadius, "sphere must start at the north pole");
+
+// Regenerates the default meshes with the runtime kernels and compares them
+// against the compile-time tables. Returns false and logs the first mismatch.
+bool validateDefaultMeshes();
+
+}  // namespace app
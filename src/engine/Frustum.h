@@ -0,0 +1,17 @@
+#pragma once
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+class Frustum {
+public:
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    [[nodiscard]] bool intersectsBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+    [[nodiscard]] bool intersectsSphere(const glm::vec3& center, float radius) const;
+
+private:
+    std::array<glm::vec4, 6> planes_{};
+};
@@ -2,7 +2,10 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
-GameObject::GameObject(Mesh meshValue, Texture textureValue)
+GameObject::GameObject(Mesh meshValue, std::shared_ptr<const Texture> textureValue)
+    : mesh(std::make_shared<const Mesh>(std::move(meshValue))), texture(std::move(textureValue)) {}
+
+GameObject::GameObject(std::shared_ptr<const Mesh> meshValue, std::shared_ptr<const Texture> textureValue)
     : mesh(std::move(meshValue)), texture(std::move(textureValue)) {}
 
 glm::mat4 GameObject::modelMatrix() const {
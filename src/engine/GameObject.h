@@ -1,20 +1,47 @@
 #pragma once
 
+#include <memory>
+
 #include <glm/glm.hpp>
 
+#include "engine/ImpostorAtlas.h"
 #include "engine/Mesh.h"
 #include "engine/Texture.h"
 
+struct TubeDeformation {
+    bool enabled = false;
+    float pulseAmplitude = 0.0f;
+    float pulseWavelength = 1.0f;
+    float pulseSpeed = 0.0f;
+    float bendCurvature = 0.0f;
+    float twistRate = 0.0f;
+};
+
+// Which faces the rasterizer drops for an object. Closed meshes wound
+// counter-clockwise from outside use Back; open or two-sided ones None.
+enum class CullMode {
+    None,
+    Back,
+    Front,
+};
+
 class GameObject {
 public:
     GameObject() = default;
-    GameObject(Mesh mesh, Texture texture);
+    GameObject(Mesh mesh, std::shared_ptr<const Texture> texture);
+    GameObject(std::shared_ptr<const Mesh> mesh, std::shared_ptr<const Texture> texture);
 
     [[nodiscard]] glm::mat4 modelMatrix() const;
 
-    Mesh mesh;
-    Texture texture;
+    std::shared_ptr<const Mesh> mesh;
+    // Shared with every other object using the same image; may be null.
+    std::shared_ptr<const Texture> texture;
     glm::vec3 position{0.0f, 0.0f, 0.0f};
     glm::vec3 rotation{0.0f, 0.0f, 0.0f};
     glm::vec3 scale{1.0f, 1.0f, 1.0f};
+    TubeDeformation deformation;
+    CullMode cullMode = CullMode::Back;
+    // Drawn instead of the mesh once the object covers only a few pixels;
+    // ignored while the object deforms, since the views are static.
+    std::shared_ptr<const ImpostorAtlas> impostor;
 };
@@ -0,0 +1,66 @@
+#include "engine/GlUtil.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace glutil {
+
+bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const auto* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension != nullptr && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string readTextFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Nao foi possivel abrir o arquivo: " + path);
+    }
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+GLuint issueShader(GLenum type, const std::string& source) {
+    const char* shaderSource = source.c_str();
+    const GLuint shader = glCreateShader(type);
+
+    glShaderSource(shader, 1, &shaderSource, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+std::string shaderError(GLuint shader) {
+    GLint success = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (success == GL_TRUE) {
+        return {};
+    }
+
+    char log[512];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    return std::string("Erro ao compilar shader:\n") + log;
+}
+
+std::string programError(GLuint program) {
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success == GL_TRUE) {
+        return {};
+    }
+
+    char log[512];
+    glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+    return std::string("Erro ao linkar programa:\n") + log;
+}
+
+}  // namespace glutil
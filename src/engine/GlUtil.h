@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <string>
+
+// Helpers shared by the shader and texture code.
+namespace glutil {
+
+// Whether the current context lists the extension.
+bool hasExtension(const char* name);
+// Throws when the file cannot be opened.
+std::string readTextFile(const std::string& path);
+
+// Issues the compile without waiting for it, so drivers that compile in
+// the background can overlap several shaders.
+GLuint issueShader(GLenum type, const std::string& source);
+// The compile or link log of a failed build, or an empty string.
+std::string shaderError(GLuint shader);
+std::string programError(GLuint program);
+
+}  // namespace glutil
@@ -0,0 +1,429 @@
+#include "engine/ImageDecoder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#ifdef TUBE_HAVE_LIBJPEG
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+#endif
+
+#include "engine/MappedFile.h"
+#include "engine/Parallel.h"
+
+namespace {
+
+bool isJpeg(const unsigned char* data, std::size_t size) {
+    return size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff;
+}
+
+class StbDecoder : public ImageDecoder {
+public:
+    const char* name() const override {
+        return "stb_image";
+    }
+
+    bool accepts(const unsigned char*, std::size_t) const override {
+        return true;
+    }
+
+    // Alpha is kept only when the file has it; grey images are expanded
+    // so every result is RGB or RGBA.
+    bool decode(const unsigned char* data, std::size_t size, DecodedImage& image) const override {
+        const auto length = static_cast<int>(std::min<std::size_t>(size, INT32_MAX));
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        if (stbi_info_from_memory(data, length, &width, &height, &channels) == 0) {
+            return false;
+        }
+        const int wanted = channels == 2 || channels == 4 ? 4 : 3;
+        unsigned char* pixels = stbi_load_from_memory(data, length, &width, &height, &channels, wanted);
+        if (pixels == nullptr) {
+            return false;
+        }
+
+        image.width = width;
+        image.height = height;
+        image.channels = wanted;
+        image.pixels.assign(pixels, pixels + static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * wanted);
+        stbi_image_free(pixels);
+        return true;
+    }
+};
+
+#ifdef TUBE_HAVE_LIBJPEG
+
+struct JpegError {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+};
+
+// libjpeg reports fatal errors through a callback that must not return.
+void jpegErrorExit(j_common_ptr info) {
+    std::longjmp(reinterpret_cast<JpegError*>(info->err)->jump, 1);
+}
+
+void jpegSilence(j_common_ptr, int) {}
+
+class LibjpegDecoder : public ImageDecoder {
+public:
+    const char* name() const override {
+#ifdef LIBJPEG_TURBO_VERSION
+        return "libjpeg-turbo";
+#else
+        return "libjpeg";
+#endif
+    }
+
+    bool accepts(const unsigned char* data, std::size_t size) const override {
+        return isJpeg(data, size);
+    }
+
+    // Everything that may need destroying is created before setjmp, so the
+    // jump back on errors skips no destructors.
+    bool decode(const unsigned char* data, std::size_t size, DecodedImage& image) const override {
+        jpeg_decompress_struct info{};
+        JpegError error{};
+        info.err = jpeg_std_error(&error.manager);
+        error.manager.error_exit = jpegErrorExit;
+        error.manager.emit_message = jpegSilence;
+        std::vector<JSAMPROW> rows;
+        if (setjmp(error.jump) != 0) {
+            jpeg_destroy_decompress(&info);
+            return false;
+        }
+
+        jpeg_create_decompress(&info);
+        jpeg_mem_src(&info, data, static_cast<unsigned long>(size));
+        jpeg_read_header(&info, TRUE);
+        // Grey expands to RGB; CMYK is left to stb_image.
+        if (info.jpeg_color_space == JCS_CMYK || info.jpeg_color_space == JCS_YCCK) {
+            jpeg_destroy_decompress(&info);
+            return false;
+        }
+        info.out_color_space = JCS_RGB;
+        jpeg_start_decompress(&info);
+
+        image.width = static_cast<int>(info.output_width);
+        image.height = static_cast<int>(info.output_height);
+        image.channels = 3;
+        const std::size_t stride = static_cast<std::size_t>(info.output_width) * 3u;
+        image.pixels.resize(stride * info.output_height);
+        rows.resize(info.output_height);
+        for (JDIMENSION y = 0; y < info.output_height; ++y) {
+            rows[y] = image.pixels.data() + y * stride;
+        }
+        while (info.output_scanline < info.output_height) {
+            jpeg_read_scanlines(&info, rows.data() + info.output_scanline, info.output_height - info.output_scanline);
+        }
+
+        jpeg_finish_decompress(&info);
+        jpeg_destroy_decompress(&info);
+        return true;
+    }
+};
+
+#endif
+
+// Where the pieces of a baseline JPEG are, for cutting it into bands.
+struct JpegScan {
+    // Offset of the frame height in the SOF segment.
+    std::size_t heightField = 0;
+    int width = 0;
+    int height = 0;
+    int mcuWidth = 8;
+    int mcuHeight = 8;
+    int restartInterval = 0;
+    // Entropy-coded data, without the EOI marker.
+    std::size_t dataBegin = 0;
+    std::size_t dataEnd = 0;
+    // Offsets of the RSTn markers within the data.
+    std::vector<std::size_t> restarts;
+};
+
+std::uint16_t readBigEndian(const unsigned char* data) {
+    return static_cast<std::uint16_t>((data[0] << 8) | data[1]);
+}
+
+// False for anything but a single-scan baseline file with restart markers.
+bool parseScan(const unsigned char* data, std::size_t size, JpegScan& scan) {
+    if (!isJpeg(data, size)) {
+        return false;
+    }
+
+    int components = 0;
+    std::size_t position = 2;
+    for (;;) {
+        if (position + 4 > size || data[position] != 0xff) {
+            return false;
+        }
+        const unsigned char marker = data[position + 1];
+        if (marker == 0xff) {
+            ++position;
+            continue;
+        }
+        const std::size_t length = readBigEndian(data + position + 2);
+        if (length < 2 || position + 2 + length > size) {
+            return false;
+        }
+        const unsigned char* segment = data + position + 4;
+
+        if (marker == 0xc0 || marker == 0xc1) {
+            if (length < 8) {
+                return false;
+            }
+            scan.heightField = position + 5;
+            scan.height = readBigEndian(segment + 1);
+            scan.width = readBigEndian(segment + 3);
+            components = segment[5];
+            if (components == 0 || length < 8u + 3u * static_cast<std::size_t>(components)) {
+                return false;
+            }
+            // A single component is coded one 8x8 block per MCU whatever
+            // its sampling factors say.
+            int maxH = 1;
+            int maxV = 1;
+            for (int c = 0; c < components && components > 1; ++c) {
+                maxH = std::max(maxH, segment[7 + 3 * c] >> 4);
+                maxV = std::max(maxV, segment[7 + 3 * c] & 0x0f);
+            }
+            scan.mcuWidth = 8 * maxH;
+            scan.mcuHeight = 8 * maxV;
+        } else if (marker >= 0xc2 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+            // Progressive, lossless or arithmetic-coded.
+            return false;
+        } else if (marker == 0xdd) {
+            if (length < 4) {
+                return false;
+            }
+            scan.restartInterval = readBigEndian(segment);
+        } else if (marker == 0xda) {
+            if (components == 0 || segment[0] != components) {
+                return false;
+            }
+            scan.dataBegin = position + 2 + length;
+            break;
+        }
+        position += 2 + length;
+    }
+    if (scan.restartInterval == 0 || scan.width == 0 || scan.height == 0) {
+        return false;
+    }
+
+    // Within the data a 0xff is followed by a stuffed zero, an RSTn, or the
+    // marker that ends the scan, which must be EOI for a single scan.
+    for (std::size_t i = scan.dataBegin; i + 1 < size; ++i) {
+        if (data[i] != 0xff || data[i + 1] == 0x00 || data[i + 1] == 0xff) {
+            continue;
+        }
+        if (data[i + 1] >= 0xd0 && data[i + 1] <= 0xd7) {
+            scan.restarts.push_back(i);
+            ++i;
+            continue;
+        }
+        if (data[i + 1] != 0xd9) {
+            return false;
+        }
+        scan.dataEnd = i;
+        return true;
+    }
+    return false;
+}
+
+class RestartParallelDecoder : public ImageDecoder {
+public:
+    RestartParallelDecoder(std::shared_ptr<const ImageDecoder> inner, std::size_t bandCount)
+        : inner_(std::move(inner)),
+          bandCount_(bandCount) {
+        name_ = std::string(inner_->name()) + " restart-parallel";
+    }
+
+    const char* name() const override {
+        return name_.c_str();
+    }
+
+    bool accepts(const unsigned char* data, std::size_t size) const override {
+        return isJpeg(data, size) && inner_->accepts(data, size);
+    }
+
+    bool decode(const unsigned char* data, std::size_t size, DecodedImage& image) const override {
+        JpegScan scan;
+        if (!parseScan(data, size, scan)) {
+            return inner_->decode(data, size, image);
+        }
+
+        // Bands can only start where a restart interval starts a row.
+        const auto interval = static_cast<std::size_t>(scan.restartInterval);
+        const auto mcusPerRow = static_cast<std::size_t>((scan.width + scan.mcuWidth - 1) / scan.mcuWidth);
+        const auto mcuRows = static_cast<std::size_t>((scan.height + scan.mcuHeight - 1) / scan.mcuHeight);
+        std::size_t rowStep = 0;
+        if (mcusPerRow % interval == 0) {
+            rowStep = 1;
+        } else if (interval % mcusPerRow == 0) {
+            rowStep = interval / mcusPerRow;
+        }
+        const std::size_t intervals = (mcusPerRow * mcuRows + interval - 1) / interval;
+        std::size_t threads = bandCount_;
+        if (threads == 0) {
+            threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+        }
+        const std::size_t bandCount = rowStep == 0 ? 1 : std::min(threads, mcuRows / rowStep);
+        if (bandCount < 2 || scan.restarts.size() + 1 != intervals) {
+            return inner_->decode(data, size, image);
+        }
+
+        const std::size_t bandRows = (mcuRows / rowStep + bandCount - 1) / bandCount * rowStep;
+        const auto mcuHeight = static_cast<std::size_t>(scan.mcuHeight);
+        const auto height = static_cast<std::size_t>(scan.height);
+        // MCU rows a band decodes, its own plus a restart step of context on
+        // each side where there is one.
+        const auto decodeFirst = [&](std::size_t band) {
+            return band == 0 ? 0 : band * bandRows - rowStep;
+        };
+        const auto decodeLast = [&](std::size_t band) {
+            return std::min(mcuRows, (band + 1) * bandRows + rowStep);
+        };
+
+        std::vector<DecodedImage> bands((mcuRows + bandRows - 1) / bandRows);
+        std::vector<char> decoded(bands.size(), 0);
+        parallelFor(bands.size(), 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t band = begin; band < end; ++band) {
+                const std::vector<unsigned char> file = cutBand(data, scan, decodeFirst(band), decodeLast(band), mcusPerRow, intervals);
+                decoded[band] = inner_->decode(file.data(), file.size(), bands[band]) ? 1 : 0;
+            }
+        });
+
+        image.width = scan.width;
+        image.height = scan.height;
+        image.channels = bands.front().channels;
+        const std::size_t stride = static_cast<std::size_t>(image.width) * static_cast<std::size_t>(image.channels);
+        image.pixels.resize(stride * height);
+        for (std::size_t band = 0; band < bands.size(); ++band) {
+            const DecodedImage& part = bands[band];
+            const std::size_t firstPixelRow = band * bandRows * mcuHeight;
+            const std::size_t lastPixelRow = std::min(height, (band + 1) * bandRows * mcuHeight);
+            const std::size_t skipped = firstPixelRow - decodeFirst(band) * mcuHeight;
+            const std::size_t decodedRows = std::min(height, decodeLast(band) * mcuHeight) - decodeFirst(band) * mcuHeight;
+            if (decoded[band] == 0 || part.width != image.width || part.channels != image.channels ||
+                static_cast<std::size_t>(part.height) != decodedRows) {
+                return inner_->decode(data, size, image);
+            }
+            std::memcpy(
+                image.pixels.data() + firstPixelRow * stride,
+                part.pixels.data() + skipped * stride,
+                (lastPixelRow - firstPixelRow) * stride
+            );
+        }
+        return true;
+    }
+
+private:
+    // A standalone JPEG of MCU rows [firstRow, lastRow): the original
+    // headers with the frame height cut down, the band's restart intervals
+    // renumbered from RST0, and EOI.
+    static std::vector<unsigned char> cutBand(
+        const unsigned char* data,
+        const JpegScan& scan,
+        std::size_t firstRow,
+        std::size_t lastRow,
+        std::size_t mcusPerRow,
+        std::size_t intervals
+    ) {
+        const auto interval = static_cast<std::size_t>(scan.restartInterval);
+        const std::size_t first = firstRow * mcusPerRow / interval;
+        const std::size_t last = std::min(intervals, (lastRow * mcusPerRow + interval - 1) / interval);
+        std::vector<unsigned char> file(data, data + scan.dataBegin);
+        const std::size_t bandHeight = std::min(lastRow * static_cast<std::size_t>(scan.mcuHeight), static_cast<std::size_t>(scan.height)) -
+            firstRow * static_cast<std::size_t>(scan.mcuHeight);
+        file[scan.heightField] = static_cast<unsigned char>(bandHeight >> 8);
+        file[scan.heightField + 1] = static_cast<unsigned char>(bandHeight & 0xff);
+
+        for (std::size_t i = first; i < last; ++i) {
+            const std::size_t segmentBegin = i == 0 ? scan.dataBegin : scan.restarts[i - 1] + 2;
+            const std::size_t segmentEnd = i + 1 == intervals ? scan.dataEnd : scan.restarts[i];
+            file.insert(file.end(), data + segmentBegin, data + segmentEnd);
+            if (i + 1 < last) {
+                file.push_back(0xff);
+                file.push_back(static_cast<unsigned char>(0xd0 + (i - first) % 8));
+            }
+        }
+        file.push_back(0xff);
+        file.push_back(0xd9);
+        return file;
+    }
+
+    std::shared_ptr<const ImageDecoder> inner_;
+    std::size_t bandCount_ = 0;
+    std::string name_;
+};
+
+}  // namespace
+
+std::unique_ptr<ImageDecoder> makeStbDecoder() {
+    return std::make_unique<StbDecoder>();
+}
+
+std::unique_ptr<ImageDecoder> makeLibjpegDecoder() {
+#ifdef TUBE_HAVE_LIBJPEG
+    return std::make_unique<LibjpegDecoder>();
+#else
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<ImageDecoder> makeRestartParallelDecoder(std::shared_ptr<const ImageDecoder> inner, std::size_t bandCount) {
+    return std::make_unique<RestartParallelDecoder>(std::move(inner), bandCount);
+}
+
+ImageDecoders::ImageDecoders() {
+    std::shared_ptr<const ImageDecoder> stb = makeStbDecoder();
+    std::shared_ptr<const ImageDecoder> jpeg = makeLibjpegDecoder();
+    add(stb);
+    add(makeRestartParallelDecoder(jpeg != nullptr ? jpeg : stb));
+}
+
+void ImageDecoders::add(std::shared_ptr<const ImageDecoder> decoder) {
+    if (decoder == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoders_.insert(decoders_.begin(), std::move(decoder));
+}
+
+std::vector<std::shared_ptr<const ImageDecoder>> ImageDecoders::decoders() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return decoders_;
+}
+
+bool ImageDecoders::decode(const std::string& path, DecodedImage& image) const {
+    try {
+        const MappedFile file(path);
+        return decode(reinterpret_cast<const unsigned char*>(file.data()), file.size(), image);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+bool ImageDecoders::decode(const unsigned char* data, std::size_t size, DecodedImage& image) const {
+    for (const std::shared_ptr<const ImageDecoder>& decoder : decoders()) {
+        if (decoder->accepts(data, size) && decoder->decode(data, size, image)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ImageDecoders& ImageDecoders::shared() {
+    static ImageDecoders decoders;
+    return decoders;
+}
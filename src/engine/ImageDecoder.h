@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    // 3, or 4 when the file has alpha.
+    int channels = 0;
+    // Rows top to bottom, tightly packed.
+    std::vector<unsigned char> pixels;
+};
+
+// One way of turning an image file in memory into texels. Decoders are
+// shared between the loader's worker threads, so decode() must be safe to
+// call concurrently.
+class ImageDecoder {
+public:
+    virtual ~ImageDecoder() = default;
+
+    [[nodiscard]] virtual const char* name() const = 0;
+    // Judged from the first bytes of the file.
+    [[nodiscard]] virtual bool accepts(const unsigned char* data, std::size_t size) const = 0;
+    // False when the data cannot be decoded; image is then unspecified.
+    virtual bool decode(const unsigned char* data, std::size_t size, DecodedImage& image) const = 0;
+};
+
+// Every format stb_image reads.
+std::unique_ptr<ImageDecoder> makeStbDecoder();
+// JPEG through libjpeg-turbo's SIMD decoder; null unless the build found it.
+std::unique_ptr<ImageDecoder> makeLibjpegDecoder();
+// JPEG through inner, cut into bands of MCU rows at restart markers that
+// are decoded in parallel. Each band is decoded with the restart step of
+// rows on either side, whose texels are thrown away, so chroma upsampling
+// sees the same neighbours as in one whole decode and the result matches
+// inner byte for byte. Only single-scan baseline files whose restart
+// interval ends on MCU row boundaries can be cut; any other file goes to
+// inner whole. A bandCount of zero uses every hardware thread. On a
+// TaskPool thread the bands go to the pool's idle threads (see
+// parallelFor).
+std::unique_ptr<ImageDecoder> makeRestartParallelDecoder(std::shared_ptr<const ImageDecoder> inner, std::size_t bandCount = 0);
+
+// The decoders TextureLoader tries, most recently added first, until one
+// that accepts the file succeeds. By default that is stb_image for
+// everything, behind the fastest available JPEG decoder.
+class ImageDecoders {
+public:
+    ImageDecoders();
+
+    ImageDecoders(const ImageDecoders&) = delete;
+    ImageDecoders& operator=(const ImageDecoders&) = delete;
+
+    void add(std::shared_ptr<const ImageDecoder> decoder);
+    [[nodiscard]] std::vector<std::shared_ptr<const ImageDecoder>> decoders() const;
+
+    bool decode(const std::string& path, DecodedImage& image) const;
+    bool decode(const unsigned char* data, std::size_t size, DecodedImage& image) const;
+
+    // The set Texture loads through.
+    static ImageDecoders& shared();
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<const ImageDecoder>> decoders_;
+};
@@ -0,0 +1,241 @@
+#include "engine/ImpostorAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+// Mip levels that still split the atlas exactly into frames of at least
+// four texels, so minification never blends neighbouring views.
+int atlasMipLevels(int frameSize) {
+    int levels = 0;
+    while (frameSize % 2 == 0 && frameSize / 2 >= 4) {
+        frameSize /= 2;
+        ++levels;
+    }
+    return levels;
+}
+
+GLuint createAtlasTexture(int size, int mipLevels) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    return texture;
+}
+
+float signNotZero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+}  // namespace
+
+ImpostorAtlas::~ImpostorAtlas() {
+    release();
+}
+
+ImpostorAtlas::ImpostorAtlas(ImpostorAtlas&& other) noexcept
+    : color_(other.color_),
+      normalDepth_(other.normalDepth_),
+      framesPerSide_(other.framesPerSide_),
+      atlasSize_(other.atlasSize_),
+      mipLevels_(other.mipLevels_),
+      hemisphere_(other.hemisphere_),
+      center_(other.center_),
+      radius_(other.radius_) {
+    other.color_ = 0;
+    other.normalDepth_ = 0;
+    other.framesPerSide_ = 0;
+    other.atlasSize_ = 0;
+}
+
+ImpostorAtlas& ImpostorAtlas::operator=(ImpostorAtlas&& other) noexcept {
+    if (this != &other) {
+        release();
+        color_ = other.color_;
+        normalDepth_ = other.normalDepth_;
+        framesPerSide_ = other.framesPerSide_;
+        atlasSize_ = other.atlasSize_;
+        mipLevels_ = other.mipLevels_;
+        hemisphere_ = other.hemisphere_;
+        center_ = other.center_;
+        radius_ = other.radius_;
+
+        other.color_ = 0;
+        other.normalDepth_ = 0;
+        other.framesPerSide_ = 0;
+        other.atlasSize_ = 0;
+    }
+    return *this;
+}
+
+void ImpostorAtlas::bake(
+    const Mesh& mesh,
+    const Texture& texture,
+    const Shader& bakeShader,
+    const ImpostorAtlasOptions& options
+) {
+    release();
+
+    framesPerSide_ = std::max(options.framesPerSide, 2);
+    const int frameSize = std::max(options.frameSize, 8);
+    atlasSize_ = framesPerSide_ * frameSize;
+    mipLevels_ = atlasMipLevels(frameSize);
+    hemisphere_ = options.hemisphere;
+    center_ = mesh.boundingCenter();
+    radius_ = std::max(mesh.boundingRadius(), 1e-4f);
+
+    GLint previousFramebuffer = 0;
+    GLint previousViewport[4] = {};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    color_ = createAtlasTexture(atlasSize_, mipLevels_);
+    normalDepth_ = createAtlasTexture(atlasSize_, mipLevels_);
+
+    GLuint depth = 0;
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasSize_, atlasSize_);
+
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalDepth_, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        glViewport(0, 0, atlasSize_, atlasSize_);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Open meshes are seen from both sides at some angle, so nothing is
+        // culled; the shader flips back-face normals instead.
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_BLEND);
+
+        bakeShader.use();
+        bakeShader.setInt("texture1", 0);
+        bakeShader.setVec3("boundsCenter", center_);
+        bakeShader.setFloat("boundsRadius", radius_);
+        bakeShader.setMat4("projection", glm::ortho(-radius_, radius_, -radius_, radius_, 0.0f, 4.0f * radius_));
+        texture.bind(GL_TEXTURE0);
+
+        for (int y = 0; y < framesPerSide_; ++y) {
+            for (int x = 0; x < framesPerSide_; ++x) {
+                const glm::vec3 direction = frameDirection(x, y, framesPerSide_, hemisphere_);
+                const glm::vec3 up = std::abs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+                glViewport(x * frameSize, y * frameSize, frameSize, frameSize);
+                bakeShader.setVec3("viewDirection", direction);
+                bakeShader.setMat4("view", glm::lookAt(center_ + direction * (2.0f * radius_), center_, up));
+                mesh.draw();
+            }
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depth);
+
+    if (!complete) {
+        release();
+        throw std::runtime_error("Erro ao criar framebuffer do impostor");
+    }
+
+    // Coverage is premultiplied, so plain box filtering keeps edges clean.
+    for (const GLuint atlas : {color_, normalDepth_}) {
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void ImpostorAtlas::bind(GLenum colorUnit, GLenum normalDepthUnit) const {
+    glActiveTexture(colorUnit);
+    glBindTexture(GL_TEXTURE_2D, color_);
+    glActiveTexture(normalDepthUnit);
+    glBindTexture(GL_TEXTURE_2D, normalDepth_);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+bool ImpostorAtlas::baked() const {
+    return color_ != 0;
+}
+
+int ImpostorAtlas::framesPerSide() const {
+    return framesPerSide_;
+}
+
+bool ImpostorAtlas::hemisphere() const {
+    return hemisphere_;
+}
+
+glm::vec3 ImpostorAtlas::center() const {
+    return center_;
+}
+
+float ImpostorAtlas::radius() const {
+    return radius_;
+}
+
+std::size_t ImpostorAtlas::gpuBytes() const {
+    if (!baked()) {
+        return 0;
+    }
+    std::size_t bytes = 0;
+    for (int level = 0; level <= mipLevels_; ++level) {
+        const auto size = static_cast<std::size_t>(atlasSize_ >> level);
+        bytes += 2u * 4u * size * size;
+    }
+    return bytes;
+}
+
+glm::vec3 ImpostorAtlas::frameDirection(int x, int y, int framesPerSide, bool hemisphere) {
+    // Frames sit on the grid corners, so the outermost ones lie exactly on
+    // the octahedron's edges and blending never leaves the atlas.
+    const float last = static_cast<float>(framesPerSide - 1);
+    const glm::vec2 p = glm::vec2(static_cast<float>(x), static_cast<float>(y)) / last * 2.0f - 1.0f;
+
+    glm::vec3 direction;
+    if (hemisphere) {
+        direction.x = 0.5f * (p.x + p.y);
+        direction.z = 0.5f * (p.x - p.y);
+        direction.y = 1.0f - std::abs(direction.x) - std::abs(direction.z);
+    } else {
+        direction = glm::vec3(p.x, 1.0f - std::abs(p.x) - std::abs(p.y), p.y);
+        if (direction.y < 0.0f) {
+            const float foldedX = (1.0f - std::abs(direction.z)) * signNotZero(direction.x);
+            const float foldedZ = (1.0f - std::abs(direction.x)) * signNotZero(direction.z);
+            direction.x = foldedX;
+            direction.z = foldedZ;
+        }
+    }
+    return glm::normalize(direction);
+}
+
+void ImpostorAtlas::release() {
+    if (color_ != 0) {
+        glDeleteTextures(1, &color_);
+        color_ = 0;
+    }
+    if (normalDepth_ != 0) {
+        glDeleteTextures(1, &normalDepth_);
+        normalDepth_ = 0;
+    }
+}
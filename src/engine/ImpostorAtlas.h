@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "engine/Mesh.h"
+#include "engine/Shader.h"
+#include "engine/Texture.h"
+
+struct ImpostorAtlasOptions {
+    int framesPerSide = 8;
+    int frameSize = 128;
+    // Views only from the upper hemisphere (+Y in mesh space), for objects
+    // that are never seen from below; the same atlas then resolves each
+    // direction about twice as finely.
+    bool hemisphere = false;
+};
+
+// Colour and normal/depth views of a mesh, one frame per direction on an
+// octahedral grid around its bounding sphere. Colour is unlit with alpha as
+// coverage; the second texture holds the mesh-space normal and the depth
+// along the view direction, so the impostor can be lit and depth-tested.
+// Both are mipmapped down to four texels per frame.
+class ImpostorAtlas {
+public:
+    ImpostorAtlas() = default;
+    ~ImpostorAtlas();
+
+    ImpostorAtlas(const ImpostorAtlas&) = delete;
+    ImpostorAtlas& operator=(const ImpostorAtlas&) = delete;
+    ImpostorAtlas(ImpostorAtlas&& other) noexcept;
+    ImpostorAtlas& operator=(ImpostorAtlas&& other) noexcept;
+
+    // Renders every view into an offscreen framebuffer with bakeShader,
+    // then restores the previous framebuffer and viewport.
+    void bake(
+        const Mesh& mesh,
+        const Texture& texture,
+        const Shader& bakeShader,
+        const ImpostorAtlasOptions& options = {}
+    );
+    void bind(GLenum colorUnit, GLenum normalDepthUnit) const;
+
+    [[nodiscard]] bool baked() const;
+    [[nodiscard]] int framesPerSide() const;
+    [[nodiscard]] bool hemisphere() const;
+    [[nodiscard]] glm::vec3 center() const;
+    [[nodiscard]] float radius() const;
+    [[nodiscard]] std::size_t gpuBytes() const;
+
+    // Unit direction from the centre towards the viewer of frame (x, y);
+    // object_impostor_fragment.glsl decodes frames the same way.
+    [[nodiscard]] static glm::vec3 frameDirection(int x, int y, int framesPerSide, bool hemisphere);
+
+private:
+    void release();
+
+    GLuint color_ = 0;
+    GLuint normalDepth_ = 0;
+    int framesPerSide_ = 0;
+    int atlasSize_ = 0;
+    int mipLevels_ = 0;
+    bool hemisphere_ = false;
+    glm::vec3 center_{0.0f};
+    float radius_ = 0.0f;
+};
@@ -0,0 +1,164 @@
+#include "engine/MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path, Access access) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        access == Access::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Erro ao abrir arquivo: " + path);
+    }
+    file_ = file;
+
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ == 0) {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        release();
+        throw std::runtime_error("Erro ao mapear arquivo: " + path);
+    }
+    mapping_ = mapping;
+    data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Erro ao abrir arquivo: " + path);
+    }
+
+    struct stat status {};
+    if (fstat(descriptor, &status) != 0) {
+        close(descriptor);
+        throw std::runtime_error("Erro ao ler tamanho do arquivo: " + path);
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ == 0) {
+        close(descriptor);
+        return;
+    }
+
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapped == MAP_FAILED) {
+        size_ = 0;
+        throw std::runtime_error("Erro ao mapear arquivo: " + path);
+    }
+    madvise(mapped, size_, access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(mapped);
+#endif
+
+    if (data_ == nullptr) {
+        release();
+        throw std::runtime_error("Erro ao mapear arquivo: " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_),
+      size_(other.size_)
+#ifdef _WIN32
+      ,
+      file_(other.file_),
+      mapping_(other.mapping_)
+#endif
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+#ifdef _WIN32
+    other.file_ = nullptr;
+    other.mapping_ = nullptr;
+#endif
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+#ifdef _WIN32
+        file_ = other.file_;
+        mapping_ = other.mapping_;
+        other.file_ = nullptr;
+        other.mapping_ = nullptr;
+#endif
+    }
+    return *this;
+}
+
+const char* MappedFile::data() const {
+    return data_;
+}
+
+std::size_t MappedFile::size() const {
+    return size_;
+}
+
+void MappedFile::discard(std::size_t offset, std::size_t length) const {
+    if (data_ == nullptr || offset >= size_) {
+        return;
+    }
+
+#ifdef _WIN32
+    (void)length;
+#else
+    // madvise needs a page-aligned start; only whole pages inside the range
+    // are dropped.
+    const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t end = offset + length < size_ ? offset + length : size_;
+    const std::size_t first = (offset + pageSize - 1) / pageSize * pageSize;
+    const std::size_t last = end == size_ ? end : end / pageSize * pageSize;
+    if (last > first) {
+        madvise(const_cast<char*>(data_) + first, last - first, MADV_DONTNEED);
+    }
+#endif
+}
+
+void MappedFile::release() {
+#ifdef _WIN32
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+        mapping_ = nullptr;
+    }
+    if (file_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(file_));
+        file_ = nullptr;
+    }
+#else
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are faulted in on demand
+// and can be dropped again with discard(), so very large files can be
+// scanned front to back without their contents staying resident.
+class MappedFile {
+public:
+    // Read-ahead hint for the kernel: Sequential suits files scanned front
+    // to back, Random files read in scattered pieces such as tiles.
+    enum class Access {
+        Sequential,
+        Random,
+    };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path, Access access = Access::Sequential);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    [[nodiscard]] const char* data() const;
+    [[nodiscard]] std::size_t size() const;
+
+    // Hints that [offset, offset + length) is no longer needed. The bytes
+    // stay readable; they are simply paged in again from disk.
+    void discard(std::size_t offset, std::size_t length) const;
+
+private:
+    void release();
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
@@ -0,0 +1,400 @@
+#include "engine/MaterialArrays.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t kNotPacked = static_cast<std::size_t>(-1);
+
+// Storage per texel of the uncompressed formats textures are loaded as.
+std::size_t storedTexelBytes(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_R8:
+            return 1;
+        case GL_RG8:
+            return 2;
+        case GL_RGB:
+        case GL_RGB8:
+        case GL_SRGB8:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+}  // namespace
+
+bool MaterialArrays::Format::operator==(const Format& other) const {
+    return width == other.width && height == other.height && levels == other.levels && internalFormat == other.internalFormat
+        && compressed == other.compressed;
+}
+
+MaterialArrays::~MaterialArrays() {
+    release();
+}
+
+MaterialArrays::MaterialArrays(MaterialArrays&& other) noexcept
+    : layersPerArray_(other.layersPerArray_),
+      transfer_(other.transfer_),
+      arrays_(std::move(other.arrays_)),
+      packed_(std::move(other.packed_)),
+      queue_(std::move(other.queue_)),
+      queued_(std::move(other.queued_)) {
+    other.transfer_ = 0;
+    other.arrays_.clear();
+}
+
+MaterialArrays& MaterialArrays::operator=(MaterialArrays&& other) noexcept {
+    if (this != &other) {
+        release();
+        layersPerArray_ = other.layersPerArray_;
+        transfer_ = other.transfer_;
+        arrays_ = std::move(other.arrays_);
+        packed_ = std::move(other.packed_);
+        queue_ = std::move(other.queue_);
+        queued_ = std::move(other.queued_);
+
+        other.transfer_ = 0;
+        other.arrays_.clear();
+    }
+    return *this;
+}
+
+void MaterialArrays::initialize(std::size_t layersPerArray) {
+    release();
+
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    layersPerArray_ = std::clamp<std::size_t>(layersPerArray, 1, static_cast<std::size_t>(std::max(maxLayers, 1)));
+    glGenBuffers(1, &transfer_);
+}
+
+void MaterialArrays::request(const std::shared_ptr<const Texture>& texture) {
+    if (texture == nullptr || transfer_ == 0 || queued_.count(texture.get()) != 0) {
+        return;
+    }
+
+    const auto found = packed_.find(texture.get());
+    if (found != packed_.end()) {
+        if (!found->second.texture.expired()) {
+            return;
+        }
+        // A new texture at the address of a destroyed one.
+        if (found->second.array != kNotPacked) {
+            arrays_[found->second.array].used[static_cast<std::size_t>(found->second.layer)] = false;
+        }
+        packed_.erase(found);
+    }
+
+    queue_.push_back(texture);
+    queued_.insert(texture.get());
+}
+
+void MaterialArrays::update(std::size_t maxTextures) {
+    for (auto it = packed_.begin(); it != packed_.end();) {
+        if (!it->second.texture.expired()) {
+            ++it;
+            continue;
+        }
+        if (it->second.array != kNotPacked) {
+            arrays_[it->second.array].used[static_cast<std::size_t>(it->second.layer)] = false;
+        }
+        it = packed_.erase(it);
+    }
+
+    // Copies bind textures on unit 0, which every pass rebinds anyway.
+    glActiveTexture(GL_TEXTURE0);
+    std::size_t packedCount = 0;
+    std::vector<std::weak_ptr<const Texture>> waiting;
+    for (const std::weak_ptr<const Texture>& entry : queue_) {
+        const std::shared_ptr<const Texture> texture = entry.lock();
+        if (texture == nullptr) {
+            continue;
+        }
+        if (packedCount >= maxTextures || !texture->ready()) {
+            waiting.push_back(entry);
+            continue;
+        }
+
+        queued_.erase(texture.get());
+        pack(texture);
+        ++packedCount;
+    }
+    queue_.swap(waiting);
+
+    // Dead entries no longer hold their address in queued_.
+    queued_.clear();
+    for (const std::weak_ptr<const Texture>& entry : queue_) {
+        if (const std::shared_ptr<const Texture> texture = entry.lock()) {
+            queued_.insert(texture.get());
+        }
+    }
+}
+
+MaterialArrays::Slot MaterialArrays::find(const Texture* texture) const {
+    const auto found = packed_.find(texture);
+    if (found == packed_.end() || found->second.array == kNotPacked || found->second.texture.expired()) {
+        return {};
+    }
+    return {arrays_[found->second.array].texture, found->second.layer};
+}
+
+std::size_t MaterialArrays::arrayCount() const {
+    return arrays_.size();
+}
+
+std::size_t MaterialArrays::gpuBytes() const {
+    std::size_t bytes = 0;
+    for (const Array& array : arrays_) {
+        bytes += array.layerBytes * array.used.size();
+    }
+    return bytes;
+}
+
+void MaterialArrays::release() {
+    for (Array& array : arrays_) {
+        if (array.texture != 0) {
+            glDeleteTextures(1, &array.texture);
+        }
+    }
+    arrays_.clear();
+    packed_.clear();
+    queue_.clear();
+    queued_.clear();
+
+    if (transfer_ != 0) {
+        glDeleteBuffers(1, &transfer_);
+        transfer_ = 0;
+    }
+}
+
+bool MaterialArrays::describe(const Texture& texture, Format& format, std::vector<std::size_t>& levelBytes) const {
+    glBindTexture(GL_TEXTURE_2D, texture.id());
+
+    // Only complete chains that are sampled from level 0 can be copied
+    // layer for layer.
+    GLint baseLevel = 0;
+    GLint compressed = GL_FALSE;
+    GLint internalFormat = 0;
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &baseLevel);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &format.width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &format.height);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+    if (baseLevel != 0 || format.width <= 0 || format.height <= 0) {
+        return false;
+    }
+    format.internalFormat = static_cast<GLenum>(internalFormat);
+    format.compressed = compressed == GL_TRUE;
+
+    levelBytes.clear();
+    GLint width = format.width;
+    GLint height = format.height;
+    for (GLint level = 0;; ++level) {
+        GLint levelWidth = 0;
+        GLint levelHeight = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &levelWidth);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &levelHeight);
+        if (levelWidth != width || levelHeight != height) {
+            return false;
+        }
+
+        if (format.compressed) {
+            GLint size = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+            levelBytes.push_back(static_cast<std::size_t>(size));
+        } else {
+            // Uncompressed levels travel as RGBA whatever their format.
+            levelBytes.push_back(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4u);
+        }
+
+        if (width == 1 && height == 1) {
+            break;
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    format.levels = static_cast<GLint>(levelBytes.size());
+    return true;
+}
+
+void MaterialArrays::pack(const std::shared_ptr<const Texture>& texture) {
+    Format format;
+    std::vector<std::size_t> levelBytes;
+    if (texture->streamed() || !describe(*texture, format, levelBytes)) {
+        packed_[texture.get()] = {texture, kNotPacked, -1};
+        return;
+    }
+
+    Packed packed = allocateLayer(format, levelBytes);
+    const Array& array = arrays_[packed.array];
+    for (GLint level = 0; level < format.levels; ++level) {
+        copyLevel(GL_TEXTURE_2D, texture->id(), array, level, packed.layer, 1, levelBytes[static_cast<std::size_t>(level)]);
+    }
+    packed.texture = texture;
+    packed_[texture.get()] = std::move(packed);
+}
+
+MaterialArrays::Packed MaterialArrays::allocateLayer(const Format& format, const std::vector<std::size_t>& levelBytes) {
+    for (std::size_t i = 0; i < arrays_.size(); ++i) {
+        Array& array = arrays_[i];
+        if (!(array.format == format)) {
+            continue;
+        }
+
+        const auto free = std::find(array.used.begin(), array.used.end(), false);
+        if (free != array.used.end()) {
+            *free = true;
+            return {{}, i, static_cast<int>(free - array.used.begin())};
+        }
+        if (array.used.size() < layersPerArray_) {
+            const std::size_t layer = array.used.size();
+            grow(array, std::min(layer * 2, layersPerArray_));
+            array.used[layer] = true;
+            return {{}, i, static_cast<int>(layer)};
+        }
+    }
+
+    Array array;
+    array.format = format;
+    array.levelBytes = levelBytes;
+    GLint width = format.width;
+    GLint height = format.height;
+    for (const std::size_t bytes : levelBytes) {
+        array.layerBytes += format.compressed
+            ? bytes
+            : static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * storedTexelBytes(format.internalFormat);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    array.used.assign(1, true);
+    glGenTextures(1, &array.texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, format.levels - 1);
+    allocateStorage(array, 1);
+    arrays_.push_back(std::move(array));
+    return {{}, arrays_.size() - 1, 0};
+}
+
+void MaterialArrays::grow(Array& array, std::size_t layers) {
+    Array grown;
+    grown.format = array.format;
+    grown.levelBytes = array.levelBytes;
+    glGenTextures(1, &grown.texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, grown.texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, array.format.levels - 1);
+    allocateStorage(grown, layers);
+
+    const auto oldLayers = static_cast<GLint>(array.used.size());
+    for (GLint level = 0; level < array.format.levels; ++level) {
+        const std::size_t bytes = array.levelBytes[static_cast<std::size_t>(level)] * array.used.size();
+        copyLevel(GL_TEXTURE_2D_ARRAY, array.texture, grown, level, 0, oldLayers, bytes);
+    }
+
+    glDeleteTextures(1, &array.texture);
+    array.texture = grown.texture;
+    array.used.resize(layers, false);
+}
+
+void MaterialArrays::allocateStorage(const Array& array, std::size_t layers) const {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    GLint width = array.format.width;
+    GLint height = array.format.height;
+    for (GLint level = 0; level < array.format.levels; ++level) {
+        if (array.format.compressed) {
+            glCompressedTexImage3D(
+                GL_TEXTURE_2D_ARRAY,
+                level,
+                array.format.internalFormat,
+                width,
+                height,
+                static_cast<GLsizei>(layers),
+                0,
+                static_cast<GLsizei>(array.levelBytes[static_cast<std::size_t>(level)] * layers),
+                nullptr
+            );
+        } else {
+            glTexImage3D(
+                GL_TEXTURE_2D_ARRAY,
+                level,
+                static_cast<GLint>(array.format.internalFormat),
+                width,
+                height,
+                static_cast<GLsizei>(layers),
+                0,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                nullptr
+            );
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+}
+
+void MaterialArrays::copyLevel(
+    GLenum sourceTarget,
+    GLuint source,
+    const Array& target,
+    GLint level,
+    GLint layer,
+    GLint layers,
+    std::size_t bytes
+) {
+    // Read back into a buffer object and upload from it again: both halves
+    // stay on the GPU, and GL 3.3 has no direct image copy.
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, transfer_);
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_COPY);
+    glBindTexture(sourceTarget, source);
+    if (target.format.compressed) {
+        glGetCompressedTexImage(sourceTarget, level, nullptr);
+    } else {
+        glGetTexImage(sourceTarget, level, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    const GLint width = std::max(1, target.format.width >> level);
+    const GLint height = std::max(1, target.format.height >> level);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, transfer_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, target.texture);
+    if (target.format.compressed) {
+        glCompressedTexSubImage3D(
+            GL_TEXTURE_2D_ARRAY,
+            level,
+            0,
+            0,
+            layer,
+            width,
+            height,
+            layers,
+            target.format.internalFormat,
+            static_cast<GLsizei>(bytes),
+            nullptr
+        );
+    } else {
+        glTexSubImage3D(
+            GL_TEXTURE_2D_ARRAY,
+            level,
+            0,
+            0,
+            layer,
+            width,
+            height,
+            layers,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            nullptr
+        );
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
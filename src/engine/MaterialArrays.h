@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "engine/Texture.h"
+
+// Packs loaded material textures into GL_TEXTURE_2D_ARRAYs, one array per
+// size and format, so objects with different textures can be drawn with a
+// single array bound and a per-draw layer. Texels are copied on the GPU
+// through a pixel buffer, and arrays grow by doubling up to layersPerArray
+// before another one is started. Layers of destroyed textures are reused.
+// Streamed textures are never packed: a layer would hold every level
+// resident outside TextureStreamer's budget, so they keep sampling their
+// own GL_TEXTURE_2D and the levels it streams in.
+// Textures that are not packed yet keep being drawn from their own
+// GL_TEXTURE_2D. All calls belong on the GL thread.
+class MaterialArrays {
+public:
+    struct Slot {
+        GLuint array = 0;
+        int layer = -1;
+    };
+
+    MaterialArrays() = default;
+    ~MaterialArrays();
+
+    MaterialArrays(const MaterialArrays&) = delete;
+    MaterialArrays& operator=(const MaterialArrays&) = delete;
+    MaterialArrays(MaterialArrays&& other) noexcept;
+    MaterialArrays& operator=(MaterialArrays&& other) noexcept;
+
+    void initialize(std::size_t layersPerArray);
+
+    // Queues texture for packing once it has finished loading.
+    void request(const std::shared_ptr<const Texture>& texture);
+    // Packs at most maxTextures queued textures and frees the layers of
+    // destroyed ones.
+    void update(std::size_t maxTextures);
+
+    // An array of zero when texture is not packed.
+    [[nodiscard]] Slot find(const Texture* texture) const;
+    [[nodiscard]] std::size_t arrayCount() const;
+    [[nodiscard]] std::size_t gpuBytes() const;
+
+private:
+    struct Format {
+        GLint width = 0;
+        GLint height = 0;
+        GLint levels = 0;
+        GLenum internalFormat = 0;
+        bool compressed = false;
+
+        bool operator==(const Format& other) const;
+    };
+
+    struct Array {
+        GLuint texture = 0;
+        Format format;
+        // Bytes of one layer, per level, as copyLevel() moves them.
+        std::vector<std::size_t> levelBytes;
+        // Bytes of one layer as stored.
+        std::size_t layerBytes = 0;
+        std::vector<bool> used;
+    };
+
+    struct Packed {
+        std::weak_ptr<const Texture> texture;
+        // Into arrays_; all bits set for textures that cannot be packed.
+        std::size_t array = 0;
+        int layer = -1;
+    };
+
+    void release();
+    [[nodiscard]] bool describe(const Texture& texture, Format& format, std::vector<std::size_t>& levelBytes) const;
+    void pack(const std::shared_ptr<const Texture>& texture);
+    [[nodiscard]] Packed allocateLayer(const Format& format, const std::vector<std::size_t>& levelBytes);
+    void grow(Array& array, std::size_t layers);
+    void allocateStorage(const Array& array, std::size_t layers) const;
+    void copyLevel(
+        GLenum sourceTarget,
+        GLuint source,
+        const Array& target,
+        GLint level,
+        GLint layer,
+        GLint layers,
+        std::size_t bytes
+    );
+
+    std::size_t layersPerArray_ = 0;
+    GLuint transfer_ = 0;
+    std::vector<Array> arrays_;
+    std::unordered_map<const Texture*, Packed> packed_;
+    std::vector<std::weak_ptr<const Texture>> queue_;
+    std::unordered_set<const Texture*> queued_;
+};
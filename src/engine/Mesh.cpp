@@ -1,13 +1,14 @@
 #include "engine/Mesh.h"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
+#include <vector>
 
 #include "app_config.hpp"
 
 namespace {
 
-constexpr float kPi = 3.14159265359f;
-
 void configureVertexAttributes(bool withNormalsAndTexcoords) {
     constexpr GLsizei stride = static_cast<GLsizei>(app::kVertexStrideFloats * sizeof(float));
 
@@ -39,11 +40,22 @@ Mesh::~Mesh() {
 }
 
 Mesh::Mesh(Mesh&& other) noexcept
-    : vao_(other.vao_), vbo_(other.vbo_), ebo_(other.ebo_), indexCount_(other.indexCount_) {
+    : vao_(other.vao_),
+      vbo_(other.vbo_),
+      ebo_(other.ebo_),
+      indexCount_(other.indexCount_),
+      gpuBytes_(other.gpuBytes_),
+      meshlets_(std::move(other.meshlets_)),
+      lods_(std::move(other.lods_)),
+      lodErrors_(std::move(other.lodErrors_)),
+      boundingCenter_(other.boundingCenter_),
+      boundingRadius_(other.boundingRadius_),
+      uvDensity_(other.uvDensity_) {
     other.vao_ = 0;
     other.vbo_ = 0;
     other.ebo_ = 0;
     other.indexCount_ = 0;
+    other.gpuBytes_ = 0;
 }
 
 Mesh& Mesh::operator=(Mesh&& other) noexcept {
@@ -62,127 +74,47 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept {
         vbo_ = other.vbo_;
         ebo_ = other.ebo_;
         indexCount_ = other.indexCount_;
+        gpuBytes_ = other.gpuBytes_;
+        meshlets_ = std::move(other.meshlets_);
+        lods_ = std::move(other.lods_);
+        lodErrors_ = std::move(other.lodErrors_);
+        boundingCenter_ = other.boundingCenter_;
+        boundingRadius_ = other.boundingRadius_;
+        uvDensity_ = other.uvDensity_;
 
         other.vao_ = 0;
         other.vbo_ = 0;
         other.ebo_ = 0;
         other.indexCount_ = 0;
+        other.gpuBytes_ = 0;
     }
     return *this;
 }
 
 Mesh Mesh::createSphere(float radius, int sectorCount, int stackCount) {
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-
-    for (int stack = 0; stack <= stackCount; ++stack) {
-        const float stackAngle = (kPi / 2.0f) - (static_cast<float>(stack) * kPi / static_cast<float>(stackCount));
-        const float xy = radius * cosf(stackAngle);
-        const float z = radius * sinf(stackAngle);
-
-        for (int sector = 0; sector <= sectorCount; ++sector) {
-            const float sectorAngle = static_cast<float>(sector) * 2.0f * kPi / static_cast<float>(sectorCount);
-            const float x = xy * cosf(sectorAngle);
-            const float y = xy * sinf(sectorAngle);
-
-            vertices.insert(vertices.end(), {
-                x, y, z,
-                x / radius, y / radius, z / radius,
-                static_cast<float>(sector) / static_cast<float>(sectorCount),
-                static_cast<float>(stack) / static_cast<float>(stackCount),
-            });
-        }
-    }
-
-    for (int stack = 0; stack < stackCount; ++stack) {
-        int current = stack * (sectorCount + 1);
-        int next = current + sectorCount + 1;
-
-        for (int sector = 0; sector < sectorCount; ++sector, ++current, ++next) {
-            if (stack != 0) {
-                indices.insert(indices.end(), {
-                    static_cast<unsigned int>(current),
-                    static_cast<unsigned int>(next),
-                    static_cast<unsigned int>(current + 1),
-                });
-            }
-
-            if (stack != (stackCount - 1)) {
-                indices.insert(indices.end(), {
-                    static_cast<unsigned int>(current + 1),
-                    static_cast<unsigned int>(next),
-                    static_cast<unsigned int>(next + 1),
-                });
-            }
-        }
-    }
+    const meshgen::SphereParams params{radius, sectorCount, stackCount};
 
     Mesh mesh;
-    mesh.upload(
-        vertices.data(),
-        vertices.size() * sizeof(float),
-        indices.data(),
-        indices.size() * sizeof(unsigned int),
-        false
+    mesh.uploadGenerated(
+        meshgen::sphereLayout(sectorCount, stackCount),
+        false,
+        [&params](float* vertices, unsigned int* indices) {
+            meshgen::writeSphere(params, vertices, indices);
+        }
     );
     return mesh;
 }
 
 Mesh Mesh::createTube(float innerRadius, float outerRadius, float height, int segments) {
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-
-    for (int segment = 0; segment <= segments; ++segment) {
-        const float theta = 2.0f * kPi * static_cast<float>(segment) / static_cast<float>(segments);
-        const float cosTheta = cosf(theta);
-        const float sinTheta = sinf(theta);
-        const float u = static_cast<float>(segment) / static_cast<float>(segments);
-
-        vertices.insert(vertices.end(), {
-            outerRadius * cosTheta, outerRadius * sinTheta, 0.0f,
-            cosTheta, sinTheta, 0.0f,
-            u, 0.0f,
-
-            outerRadius * cosTheta, outerRadius * sinTheta, height,
-            cosTheta, sinTheta, 0.0f,
-            u, 1.0f,
-
-            innerRadius * cosTheta, innerRadius * sinTheta, 0.0f,
-            -cosTheta, -sinTheta, 0.0f,
-            u, 0.0f,
-
-            innerRadius * cosTheta, innerRadius * sinTheta, height,
-            -cosTheta, -sinTheta, 0.0f,
-            u, 1.0f,
-        });
-    }
-
-    for (int segment = 0; segment < segments; ++segment) {
-        const unsigned int base = static_cast<unsigned int>(segment * 4);
-        const unsigned int next = static_cast<unsigned int>((segment + 1) * 4);
-
-        indices.insert(indices.end(), {
-            base, base + 1, next + 1,
-            base, next + 1, next,
-
-            base + 2, next + 2, next + 3,
-            base + 2, next + 3, base + 3,
-
-            base + 1, next + 1, next + 3,
-            base + 1, next + 3, base + 3,
-
-            base, base + 2, next + 2,
-            base, next + 2, next,
-        });
-    }
+    const meshgen::TubeParams params{innerRadius, outerRadius, height, segments};
 
     Mesh mesh;
-    mesh.upload(
-        vertices.data(),
-        vertices.size() * sizeof(float),
-        indices.data(),
-        indices.size() * sizeof(unsigned int),
-        true
+    mesh.uploadGenerated(
+        meshgen::tubeLayout(segments),
+        true,
+        [&params](float* vertices, unsigned int* indices) {
+            meshgen::writeTube(params, vertices, indices);
+        }
     );
     return mesh;
 }
@@ -199,12 +131,132 @@ Mesh Mesh::createFromRaw(
     return mesh;
 }
 
+Mesh Mesh::createFromRawWithLods(
+    const float* vertices,
+    std::size_t vertexBytes,
+    const unsigned int* indices,
+    std::size_t indexBytes,
+    const meshgen::LodChainOptions& options
+) {
+    const std::size_t vertexCount = vertexBytes / (app::kVertexStrideFloats * sizeof(float));
+    const std::size_t indexCount = indexBytes / sizeof(unsigned int);
+
+    Mesh mesh;
+    mesh.upload(vertices, vertexBytes, indices, indexBytes, true);
+
+    for (const meshgen::LodLevel& level : meshgen::buildLodChain(vertices, vertexCount, indices, indexCount, options)) {
+        mesh.lods_.push_back(createFromRaw(
+            level.vertices.data(),
+            level.vertices.size() * sizeof(float),
+            level.indices.data(),
+            level.indices.size() * sizeof(unsigned int),
+            true
+        ));
+        mesh.lodErrors_.push_back(level.error);
+    }
+    return mesh;
+}
+
+Mesh Mesh::createClustered(
+    const float* vertices,
+    std::size_t vertexBytes,
+    const unsigned int* indices,
+    std::size_t indexBytes,
+    std::vector<meshgen::Meshlet> meshlets
+) {
+    Mesh mesh;
+    mesh.upload(vertices, vertexBytes, indices, indexBytes, true);
+    mesh.meshlets_ = std::move(meshlets);
+    return mesh;
+}
+
 void Mesh::draw() const {
     glBindVertexArray(vao_);
     glDrawElements(GL_TRIANGLES, indexCount_, GL_UNSIGNED_INT, nullptr);
     glBindVertexArray(0);
 }
 
+void Mesh::drawCulled(const Frustum& frustum, const glm::vec3& cameraPosition) const {
+    if (meshlets_.empty()) {
+        draw();
+        return;
+    }
+
+    // Meshlets are contiguous in the index buffer, so neighbouring
+    // survivors are merged into a single draw.
+    glBindVertexArray(vao_);
+    for (std::size_t i = 0; i < meshlets_.size();) {
+        const auto visible = [&](const meshgen::Meshlet& meshlet) {
+            return frustum.intersectsSphere(meshlet.center, meshlet.radius)
+                   && !meshgen::meshletBackfacing(meshlet, cameraPosition);
+        };
+        if (!visible(meshlets_[i])) {
+            ++i;
+            continue;
+        }
+
+        const std::size_t first = meshlets_[i].firstIndex;
+        std::size_t count = 0;
+        for (; i < meshlets_.size() && visible(meshlets_[i]); ++i) {
+            count += meshlets_[i].indexCount;
+        }
+        glDrawElements(
+            GL_TRIANGLES,
+            static_cast<GLsizei>(count),
+            GL_UNSIGNED_INT,
+            reinterpret_cast<void*>(first * sizeof(unsigned int))
+        );
+    }
+    glBindVertexArray(0);
+}
+
+void Mesh::drawInstanced(GLsizei instanceCount, GLenum mode) const {
+    glBindVertexArray(vao_);
+    glDrawElementsInstanced(mode, indexCount_, GL_UNSIGNED_INT, nullptr, instanceCount);
+    glBindVertexArray(0);
+}
+
+const Mesh& Mesh::selectLod(float pixelsPerUnit, float pixelError) const {
+    // Errors grow monotonically along the chain.
+    const Mesh* selected = this;
+    for (std::size_t i = 0; i < lods_.size() && lodErrors_[i] * pixelsPerUnit <= pixelError; ++i) {
+        selected = &lods_[i];
+    }
+    return *selected;
+}
+
+std::size_t Mesh::lodCount() const {
+    return lods_.size();
+}
+
+glm::vec3 Mesh::boundingCenter() const {
+    return boundingCenter_;
+}
+
+float Mesh::boundingRadius() const {
+    return boundingRadius_;
+}
+
+float Mesh::uvDensity() const {
+    return uvDensity_;
+}
+
+GLuint Mesh::vertexArray() const {
+    return vao_;
+}
+
+std::size_t Mesh::gpuBytes() const {
+    std::size_t total = gpuBytes_;
+    for (const Mesh& lod : lods_) {
+        total += lod.gpuBytes();
+    }
+    return total;
+}
+
+std::size_t Mesh::meshletCount() const {
+    return meshlets_.size();
+}
+
 void Mesh::upload(
     const float* vertices,
     std::size_t vertexBytes,
@@ -213,6 +265,7 @@ void Mesh::upload(
     bool withNormalsAndTexcoords
 ) {
     indexCount_ = static_cast<GLsizei>(indexBytes / sizeof(unsigned int));
+    gpuBytes_ = vertexBytes + indexBytes;
 
     glGenVertexArrays(1, &vao_);
     glGenBuffers(1, &vbo_);
@@ -226,4 +279,96 @@ void Mesh::upload(
 
     configureVertexAttributes(withNormalsAndTexcoords);
     glBindVertexArray(0);
+
+    // Centred on the bounding box, which is tight enough for LOD and
+    // impostor decisions without an exact minimal sphere.
+    const std::size_t vertexCount = vertexBytes / (app::kVertexStrideFloats * sizeof(float));
+    if (vertexCount == 0) {
+        return;
+    }
+    glm::vec3 boundsMin(vertices[0], vertices[1], vertices[2]);
+    glm::vec3 boundsMax = boundsMin;
+    for (std::size_t v = 1; v < vertexCount; ++v) {
+        const float* p = vertices + v * app::kVertexStrideFloats;
+        boundsMin = glm::min(boundsMin, glm::vec3(p[0], p[1], p[2]));
+        boundsMax = glm::max(boundsMax, glm::vec3(p[0], p[1], p[2]));
+    }
+    boundingCenter_ = 0.5f * (boundsMin + boundsMax);
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+        const float* p = vertices + v * app::kVertexStrideFloats;
+        boundingRadius_ = std::max(boundingRadius_, glm::length(glm::vec3(p[0], p[1], p[2]) - boundingCenter_));
+    }
+
+    if (!withNormalsAndTexcoords) {
+        return;
+    }
+    double worldArea = 0.0;
+    double uvArea = 0.0;
+    for (std::size_t i = 0; i + 2 < static_cast<std::size_t>(indexCount_); i += 3) {
+        const float* a = vertices + indices[i] * app::kVertexStrideFloats;
+        const float* b = vertices + indices[i + 1] * app::kVertexStrideFloats;
+        const float* c = vertices + indices[i + 2] * app::kVertexStrideFloats;
+        const glm::vec3 edge1(b[0] - a[0], b[1] - a[1], b[2] - a[2]);
+        const glm::vec3 edge2(c[0] - a[0], c[1] - a[1], c[2] - a[2]);
+        worldArea += glm::length(glm::cross(edge1, edge2));
+        uvArea += std::abs((b[6] - a[6]) * (c[7] - a[7]) - (c[6] - a[6]) * (b[7] - a[7]));
+    }
+    if (worldArea > 0.0) {
+        uvDensity_ = static_cast<float>(std::sqrt(uvArea / worldArea));
+    }
+}
+
+void Mesh::uploadGenerated(
+    const meshgen::MeshLayout& layout,
+    bool withNormalsAndTexcoords,
+    const std::function<void(float*, unsigned int*)>& generate
+) {
+    const std::size_t vertexBytes = layout.vertexCount * app::kVertexStrideFloats * sizeof(float);
+    const std::size_t indexBytes = layout.indexCount * sizeof(unsigned int);
+    indexCount_ = static_cast<GLsizei>(layout.indexCount);
+    gpuBytes_ = vertexBytes + indexBytes;
+
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glGenBuffers(1, &ebo_);
+
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexBytes), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indexBytes), nullptr, GL_STATIC_DRAW);
+
+    constexpr GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+    void* mappedVertices = vertexBytes > 0
+        ? glMapBufferRange(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(vertexBytes), access)
+        : nullptr;
+    void* mappedIndices = indexBytes > 0
+        ? glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(indexBytes), access)
+        : nullptr;
+
+    bool written = false;
+    if (mappedVertices != nullptr && mappedIndices != nullptr) {
+        generate(static_cast<float*>(mappedVertices), static_cast<unsigned int*>(mappedIndices));
+        written = true;
+    }
+
+    // Unmap can report GL_FALSE when the store was lost (e.g. mode switch);
+    // the contents are then undefined and have to be written again.
+    if (mappedVertices != nullptr && glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE) {
+        written = false;
+    }
+    if (mappedIndices != nullptr && glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) != GL_TRUE) {
+        written = false;
+    }
+
+    if (!written) {
+        std::vector<float> vertices(layout.vertexCount * app::kVertexStrideFloats);
+        std::vector<unsigned int> indices(layout.indexCount);
+        generate(vertices.data(), indices.data());
+        glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(vertexBytes), vertices.data());
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(indexBytes), indices.data());
+    }
+
+    configureVertexAttributes(withNormalsAndTexcoords);
+    glBindVertexArray(0);
 }
@@ -3,8 +3,16 @@
 #include <glad/gl.h>
 
 #include <cstddef>
+#include <functional>
 #include <vector>
 
+#include <glm/glm.hpp>
+
+#include "engine/Frustum.h"
+#include "engine/MeshKernels.h"
+#include "engine/MeshSimplify.h"
+#include "engine/Meshlets.h"
+
 class Mesh {
 public:
     Mesh() = default;
@@ -24,8 +32,48 @@ public:
         std::size_t indexBytes,
         bool withNormalsAndTexcoords
     );
+    // Like createFromRaw with normals and texcoords, plus a chain of
+    // simplified levels chosen per draw by selectLod.
+    static Mesh createFromRawWithLods(
+        const float* vertices,
+        std::size_t vertexBytes,
+        const unsigned int* indices,
+        std::size_t indexBytes,
+        const meshgen::LodChainOptions& options = {}
+    );
+    // Like createFromRaw with normals and texcoords, for indices already
+    // reordered by meshgen::buildMeshlets; drawCulled then rejects the
+    // meshlets individually.
+    static Mesh createClustered(
+        const float* vertices,
+        std::size_t vertexBytes,
+        const unsigned int* indices,
+        std::size_t indexBytes,
+        std::vector<meshgen::Meshlet> meshlets
+    );
 
     void draw() const;
+    // Skips meshlets outside the frustum or facing away from the camera,
+    // both given in the mesh's own space. Meshes without meshlets draw whole.
+    void drawCulled(const Frustum& frustum, const glm::vec3& cameraPosition) const;
+    void drawInstanced(GLsizei instanceCount, GLenum mode = GL_TRIANGLES) const;
+
+    // Coarsest level whose error stays within pixelError once projected at
+    // pixelsPerUnit; meshes without levels return themselves.
+    [[nodiscard]] const Mesh& selectLod(float pixelsPerUnit, float pixelError) const;
+    [[nodiscard]] std::size_t lodCount() const;
+    // Bounding sphere in the mesh's own space, known for meshes uploaded
+    // from raw data; generated meshes report a zero radius.
+    [[nodiscard]] glm::vec3 boundingCenter() const;
+    [[nodiscard]] float boundingRadius() const;
+    // Texture coordinates per unit of length, averaged by area over the
+    // triangles; zero for meshes without texcoords or generated ones.
+    [[nodiscard]] float uvDensity() const;
+
+    [[nodiscard]] GLuint vertexArray() const;
+
+    [[nodiscard]] std::size_t gpuBytes() const;
+    [[nodiscard]] std::size_t meshletCount() const;
 
 private:
     void upload(
@@ -35,9 +83,21 @@ private:
         std::size_t indexBytes,
         bool withNormalsAndTexcoords
     );
+    void uploadGenerated(
+        const meshgen::MeshLayout& layout,
+        bool withNormalsAndTexcoords,
+        const std::function<void(float*, unsigned int*)>& generate
+    );
 
     GLuint vao_ = 0;
     GLuint vbo_ = 0;
     GLuint ebo_ = 0;
     GLsizei indexCount_ = 0;
+    std::size_t gpuBytes_ = 0;
+    std::vector<meshgen::Meshlet> meshlets_;
+    std::vector<Mesh> lods_;
+    std::vector<float> lodErrors_;
+    glm::vec3 boundingCenter_{0.0f};
+    float boundingRadius_ = 0.0f;
+    float uvDensity_ = 0.0f;
 };
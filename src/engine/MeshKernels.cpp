@@ -0,0 +1,288 @@
+#include "engine/MeshKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TUBE_MESHGEN_SSE2 1
+#endif
+
+#include "app_config.hpp"
+#include "engine/Parallel.h"
+
+namespace meshgen {
+
+namespace {
+
+constexpr float kPi = 3.14159265359f;
+constexpr std::size_t kStride = app::kVertexStrideFloats;
+constexpr std::size_t kTubeVerticesPerSegment = 4;
+constexpr std::size_t kTubeIndicesPerSegment = 24;
+constexpr std::size_t kMinSegmentsPerBatch = 4096;
+constexpr std::size_t kMinVerticesPerBatch = 16384;
+
+#ifdef TUBE_MESHGEN_SSE2
+
+// Four-lane port of the Cephes sinf/cosf kernels: Cody-Waite reduction to
+// [-pi/4, pi/4] followed by the minimax polynomials for both functions.
+void sincos4(__m128 x, __m128* sinOut, __m128* cosOut) {
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    __m128 signSin = _mm_and_ps(x, signMask);
+    x = _mm_and_ps(x, absMask);
+
+    __m128i quadrant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+    quadrant = _mm_add_epi32(quadrant, _mm_set1_epi32(1));
+    quadrant = _mm_and_si128(quadrant, _mm_set1_epi32(~1));
+    const __m128 y = _mm_cvtepi32_ps(quadrant);
+
+    const __m128i flipSin = _mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(4)), 29);
+    const __m128i flipCos = _mm_slli_epi32(
+        _mm_andnot_si128(_mm_sub_epi32(quadrant, _mm_set1_epi32(2)), _mm_set1_epi32(4)),
+        29
+    );
+    const __m128 polyMask = _mm_castsi128_ps(
+        _mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), _mm_setzero_si128())
+    );
+
+    signSin = _mm_xor_ps(signSin, _mm_castsi128_ps(flipSin));
+    const __m128 signCos = _mm_castsi128_ps(flipCos);
+
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+
+    const __m128 z = _mm_mul_ps(x, x);
+
+    __m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+    cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+    cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+    __m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), x), x);
+
+    const __m128 sinValue = _mm_or_ps(_mm_and_ps(polyMask, sinPoly), _mm_andnot_ps(polyMask, cosPoly));
+    const __m128 cosValue = _mm_or_ps(_mm_and_ps(polyMask, cosPoly), _mm_andnot_ps(polyMask, sinPoly));
+
+    *sinOut = _mm_xor_ps(sinValue, signSin);
+    *cosOut = _mm_xor_ps(cosValue, signCos);
+}
+
+#endif
+
+void writeTubeSegments(
+    const TubeParams& params,
+    const float* cosRing,
+    const float* sinRing,
+    std::size_t begin,
+    std::size_t end,
+    float* vertices,
+    unsigned int* indices
+) {
+    const auto segments = static_cast<std::size_t>(params.segments);
+    const float inner = params.innerRadius;
+    const float outer = params.outerRadius;
+    const float height = params.height;
+
+    for (std::size_t segment = begin; segment < end; ++segment) {
+        const float c = cosRing[segment];
+        const float s = sinRing[segment];
+        const float u = static_cast<float>(segment) / static_cast<float>(segments);
+        float* v = vertices + segment * kTubeVerticesPerSegment * kStride;
+
+        const float ring[kTubeVerticesPerSegment * kStride] = {
+            outer * c, outer * s, 0.0f, c, s, 0.0f, u, 0.0f,
+            outer * c, outer * s, height, c, s, 0.0f, u, 1.0f,
+            inner * c, inner * s, 0.0f, -c, -s, 0.0f, u, 0.0f,
+            inner * c, inner * s, height, -c, -s, 0.0f, u, 1.0f,
+        };
+        for (std::size_t i = 0; i < kTubeVerticesPerSegment * kStride; ++i) {
+            v[i] = ring[i];
+        }
+
+        if (segment == segments) {
+            continue;
+        }
+
+        const auto base = static_cast<unsigned int>(segment * kTubeVerticesPerSegment);
+        const unsigned int next = base + static_cast<unsigned int>(kTubeVerticesPerSegment);
+        const unsigned int quad[kTubeIndicesPerSegment] = {
+            base, next + 1, base + 1,
+            base, next, next + 1,
+
+            base + 2, next + 3, next + 2,
+            base + 2, base + 3, next + 3,
+
+            base + 1, next + 1, next + 3,
+            base + 1, next + 3, base + 3,
+
+            base, base + 2, next + 2,
+            base, next + 2, next,
+        };
+        unsigned int* out = indices + segment * kTubeIndicesPerSegment;
+        for (std::size_t i = 0; i < kTubeIndicesPerSegment; ++i) {
+            out[i] = quad[i];
+        }
+    }
+}
+
+std::size_t sphereTrianglesBeforeStack(std::size_t stack) {
+    return stack == 0 ? 0 : 2 * stack - 1;
+}
+
+void writeSphereStacks(
+    const SphereParams& params,
+    const float* cosSector,
+    const float* sinSector,
+    const float* cosStack,
+    const float* sinStack,
+    std::size_t begin,
+    std::size_t end,
+    float* vertices,
+    unsigned int* indices
+) {
+    const auto sectors = static_cast<std::size_t>(params.sectorCount);
+    const auto stacks = static_cast<std::size_t>(params.stackCount);
+    const float radius = params.radius;
+
+    for (std::size_t stack = begin; stack < end; ++stack) {
+        const float xy = radius * cosStack[stack];
+        const float z = radius * sinStack[stack];
+        const float v = static_cast<float>(stack) / static_cast<float>(stacks);
+        float* out = vertices + stack * (sectors + 1) * kStride;
+
+        for (std::size_t sector = 0; sector <= sectors; ++sector, out += kStride) {
+            const float x = xy * cosSector[sector];
+            const float y = xy * sinSector[sector];
+            out[0] = x;
+            out[1] = y;
+            out[2] = z;
+            out[3] = x / radius;
+            out[4] = y / radius;
+            out[5] = z / radius;
+            out[6] = static_cast<float>(sector) / static_cast<float>(sectors);
+            out[7] = v;
+        }
+
+        if (stack == stacks) {
+            continue;
+        }
+
+        unsigned int* tri = indices + sphereTrianglesBeforeStack(stack) * sectors * 3;
+        auto current = static_cast<unsigned int>(stack * (sectors + 1));
+        auto next = static_cast<unsigned int>(current + sectors + 1);
+
+        for (std::size_t sector = 0; sector < sectors; ++sector, ++current, ++next) {
+            if (stack != 0) {
+                *tri++ = current;
+                *tri++ = next;
+                *tri++ = current + 1;
+            }
+            if (stack != stacks - 1) {
+                *tri++ = current + 1;
+                *tri++ = next;
+                *tri++ = next + 1;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+MeshLayout tubeLayout(int segments) {
+    const auto count = static_cast<std::size_t>(segments);
+    return {
+        (count + 1) * kTubeVerticesPerSegment,
+        count * kTubeIndicesPerSegment,
+    };
+}
+
+MeshLayout sphereLayout(int sectorCount, int stackCount) {
+    const auto sectors = static_cast<std::size_t>(sectorCount);
+    const auto stacks = static_cast<std::size_t>(stackCount);
+    return {
+        (stacks + 1) * (sectors + 1),
+        stacks == 0 ? 0 : sectors * (2 * stacks - 2) * 3,
+    };
+}
+
+void computeAngles(const float* angles, std::size_t count, float* cosOut, float* sinOut) {
+    std::size_t i = 0;
+
+#ifdef TUBE_MESHGEN_SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128 sinValue;
+        __m128 cosValue;
+        sincos4(_mm_loadu_ps(angles + i), &sinValue, &cosValue);
+        _mm_storeu_ps(sinOut + i, sinValue);
+        _mm_storeu_ps(cosOut + i, cosValue);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        cosOut[i] = std::cos(angles[i]);
+        sinOut[i] = std::sin(angles[i]);
+    }
+}
+
+void computeRing(int segments, float* cosOut, float* sinOut) {
+    const auto count = static_cast<std::size_t>(segments) + 1;
+    std::vector<float> angles(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        angles[i] = 2.0f * kPi * static_cast<float>(i) / static_cast<float>(segments);
+    }
+    computeAngles(angles.data(), count, cosOut, sinOut);
+}
+
+void writeTube(const TubeParams& params, float* vertices, unsigned int* indices) {
+    const auto ringSize = static_cast<std::size_t>(params.segments) + 1;
+    std::vector<float> cosRing(ringSize);
+    std::vector<float> sinRing(ringSize);
+    computeRing(params.segments, cosRing.data(), sinRing.data());
+
+    parallelFor(ringSize, kMinSegmentsPerBatch, [&](std::size_t begin, std::size_t end) {
+        writeTubeSegments(params, cosRing.data(), sinRing.data(), begin, end, vertices, indices);
+    });
+}
+
+void writeSphere(const SphereParams& params, float* vertices, unsigned int* indices) {
+    const auto sectorRingSize = static_cast<std::size_t>(params.sectorCount) + 1;
+    const auto stackRingSize = static_cast<std::size_t>(params.stackCount) + 1;
+
+    std::vector<float> cosSector(sectorRingSize);
+    std::vector<float> sinSector(sectorRingSize);
+    computeRing(params.sectorCount, cosSector.data(), sinSector.data());
+
+    std::vector<float> stackAngles(stackRingSize);
+    for (std::size_t stack = 0; stack < stackRingSize; ++stack) {
+        stackAngles[stack] = (kPi / 2.0f) - (static_cast<float>(stack) * kPi / static_cast<float>(params.stackCount));
+    }
+    std::vector<float> cosStack(stackRingSize);
+    std::vector<float> sinStack(stackRingSize);
+    computeAngles(stackAngles.data(), stackRingSize, cosStack.data(), sinStack.data());
+
+    const std::size_t minStacks = std::max<std::size_t>(1, kMinVerticesPerBatch / sectorRingSize);
+    parallelFor(stackRingSize, minStacks, [&](std::size_t begin, std::size_t end) {
+        writeSphereStacks(
+            params,
+            cosSector.data(),
+            sinSector.data(),
+            cosStack.data(),
+            sinStack.data(),
+            begin,
+            end,
+            vertices,
+            indices
+        );
+    });
+}
+
+}  // namespace meshgen
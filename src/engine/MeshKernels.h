@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+namespace meshgen {
+
+struct TubeParams {
+    float innerRadius;
+    float outerRadius;
+    float height;
+    int segments;
+};
+
+struct SphereParams {
+    float radius;
+    int sectorCount;
+    int stackCount;
+};
+
+struct MeshLayout {
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+};
+
+[[nodiscard]] MeshLayout tubeLayout(int segments);
+[[nodiscard]] MeshLayout sphereLayout(int sectorCount, int stackCount);
+
+// Fills cosOut/sinOut with the segments + 1 ring angles 2 * pi * i / segments.
+void computeRing(int segments, float* cosOut, float* sinOut);
+void computeAngles(const float* angles, std::size_t count, float* cosOut, float* sinOut);
+
+// Output buffers must hold exactly the sizes reported by the matching layout
+// (vertexCount * app::kVertexStrideFloats floats). They may point into mapped
+// GPU memory; every element is written exactly once.
+void writeTube(const TubeParams& params, float* vertices, unsigned int* indices);
+void writeSphere(const SphereParams& params, float* vertices, unsigned int* indices);
+
+}  // namespace meshgen
@@ -0,0 +1,143 @@
+#include "engine/MeshRegistry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+std::uint32_t floatBits(float value) {
+    if (value == 0.0f) {
+        value = 0.0f;
+    }
+
+    std::uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+std::uint32_t intBits(int value) {
+    return static_cast<std::uint32_t>(value);
+}
+
+}  // namespace
+
+bool MeshRegistry::Key::operator==(const Key& other) const {
+    return kind == other.kind && words == other.words;
+}
+
+std::size_t MeshRegistry::KeyHash::operator()(const Key& key) const {
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](std::uint32_t word) {
+        for (int byte = 0; byte < 4; ++byte) {
+            hash ^= (word >> (byte * 8)) & 0xffu;
+            hash *= 1099511628211ull;
+        }
+    };
+
+    mix(static_cast<std::uint32_t>(key.kind));
+    for (const std::uint32_t word : key.words) {
+        mix(word);
+    }
+    return static_cast<std::size_t>(hash);
+}
+
+MeshRegistry::MeshRegistry(std::size_t budgetBytes) : budgetBytes_(budgetBytes) {}
+
+MeshHandle MeshRegistry::tube(const meshgen::TubeParams& params, const Builder& build) {
+    const Key key{
+        Kind::Tube,
+        {floatBits(params.innerRadius), floatBits(params.outerRadius), floatBits(params.height), intBits(params.segments)},
+    };
+
+    if (build) {
+        return acquire(key, build);
+    }
+    return acquire(key, [&params]() {
+        return Mesh::createTube(params.innerRadius, params.outerRadius, params.height, params.segments);
+    });
+}
+
+MeshHandle MeshRegistry::sphere(const meshgen::SphereParams& params, const Builder& build) {
+    const Key key{
+        Kind::Sphere,
+        {floatBits(params.radius), intBits(params.sectorCount), intBits(params.stackCount), 0},
+    };
+
+    if (build) {
+        return acquire(key, build);
+    }
+    return acquire(key, [&params]() {
+        return Mesh::createSphere(params.radius, params.sectorCount, params.stackCount);
+    });
+}
+
+void MeshRegistry::setBudget(std::size_t budgetBytes) {
+    budgetBytes_ = budgetBytes;
+    collectGarbage();
+}
+
+void MeshRegistry::collectGarbage() {
+    evictUnreferenced(budgetBytes_);
+}
+
+void MeshRegistry::clear() {
+    entries_.clear();
+    residentBytes_ = 0;
+}
+
+std::size_t MeshRegistry::residentBytes() const {
+    return residentBytes_;
+}
+
+std::size_t MeshRegistry::size() const {
+    return entries_.size();
+}
+
+MeshHandle MeshRegistry::acquire(const Key& key, const Builder& build) {
+    const auto found = entries_.find(key);
+    if (found != entries_.end()) {
+        found->second.lastUse = ++useCounter_;
+        return found->second.mesh;
+    }
+
+    auto mesh = std::make_shared<Mesh>(build());
+    const std::size_t bytes = mesh->gpuBytes();
+
+    // Make room before adding so a burst of new sizes cannot push the
+    // resident set past the budget while stale entries are still cached.
+    if (residentBytes_ + bytes > budgetBytes_) {
+        evictUnreferenced(budgetBytes_ > bytes ? budgetBytes_ - bytes : 0);
+    }
+
+    entries_.emplace(key, Entry{mesh, bytes, ++useCounter_});
+    residentBytes_ += bytes;
+    return mesh;
+}
+
+void MeshRegistry::evictUnreferenced(std::size_t targetBytes) {
+    if (residentBytes_ <= targetBytes) {
+        return;
+    }
+
+    std::vector<std::pair<std::uint64_t, Key>> candidates;
+    for (const auto& [key, entry] : entries_) {
+        if (entry.mesh.use_count() == 1) {
+            candidates.emplace_back(entry.lastUse, key);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    for (const auto& candidate : candidates) {
+        if (residentBytes_ <= targetBytes) {
+            break;
+        }
+
+        const auto entry = entries_.find(candidate.second);
+        residentBytes_ -= entry->second.bytes;
+        entries_.erase(entry);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "app_config.hpp"
+#include "engine/Mesh.h"
+#include "engine/MeshKernels.h"
+
+using MeshHandle = std::shared_ptr<const Mesh>;
+
+class MeshRegistry {
+public:
+    using Builder = std::function<Mesh()>;
+
+    explicit MeshRegistry(std::size_t budgetBytes = app::kMeshCacheBudgetBytes);
+
+    MeshRegistry(const MeshRegistry&) = delete;
+    MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+    // Returns the shared mesh for these parameters, generating it on first
+    // use. A custom builder may supply prebuilt data for the same key.
+    MeshHandle tube(const meshgen::TubeParams& params, const Builder& build = {});
+    MeshHandle sphere(const meshgen::SphereParams& params, const Builder& build = {});
+
+    void setBudget(std::size_t budgetBytes);
+    void collectGarbage();
+    void clear();
+
+    [[nodiscard]] std::size_t residentBytes() const;
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    enum class Kind : std::uint32_t {
+        Tube,
+        Sphere,
+    };
+
+    struct Key {
+        Kind kind;
+        std::array<std::uint32_t, 4> words;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        std::shared_ptr<Mesh> mesh;
+        std::size_t bytes = 0;
+        std::uint64_t lastUse = 0;
+    };
+
+    MeshHandle acquire(const Key& key, const Builder& build);
+    void evictUnreferenced(std::size_t targetBytes);
+
+    std::unordered_map<Key, Entry, KeyHash> entries_;
+    std::size_t budgetBytes_ = 0;
+    std::size_t residentBytes_ = 0;
+    std::uint64_t useCounter_ = 0;
+};
@@ -0,0 +1,1067 @@
+#include "engine/MeshSimplify.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "app_config.hpp"
+#include "engine/Parallel.h"
+
+namespace meshgen {
+namespace {
+
+constexpr std::size_t kStride = app::kVertexStrideFloats;
+constexpr unsigned int kNone = std::numeric_limits<unsigned int>::max();
+// Border planes weigh this much more than surface planes, so open rims keep
+// their outline.
+constexpr double kBorderWeight = 10.0;
+// Collapses that turn a remaining triangle further than ~78 degrees count
+// as flips.
+constexpr float kMinFlipCosine = 0.2f;
+// Connected components larger than this are cut into patches simplified in
+// parallel.
+constexpr std::size_t kPatchTriangles = std::size_t{1} << 15;
+// Directions patches are cut across. The second pass uses a rotated set, so
+// its cuts cross the first pass's instead of running along them.
+constexpr float kCutDirections[2][3][3] = {
+    {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    {{0.57735f, 0.57735f, 0.57735f}, {0.70711f, -0.70711f, 0.0f}, {0.40825f, 0.40825f, -0.8165f}},
+};
+
+// Symmetric 4x4 plane quadric, upper triangle only, plus the accumulated
+// area used to turn its value into a mean squared distance.
+struct Quadric {
+    std::array<double, 10> q{};
+    double weight = 0.0;
+
+    void addPlane(const glm::dvec3& normal, double offset, double planeWeight) {
+        const double p[4] = {normal.x, normal.y, normal.z, offset};
+        std::size_t k = 0;
+        for (int i = 0; i < 4; ++i) {
+            for (int j = i; j < 4; ++j) {
+                q[k++] += planeWeight * p[i] * p[j];
+            }
+        }
+        weight += planeWeight;
+    }
+
+    void add(const Quadric& other) {
+        for (std::size_t i = 0; i < q.size(); ++i) {
+            q[i] += other.q[i];
+        }
+        weight += other.weight;
+    }
+
+    [[nodiscard]] double evaluate(const glm::vec3& point) const {
+        const double p[4] = {point.x, point.y, point.z, 1.0};
+        double result = 0.0;
+        std::size_t k = 0;
+        for (int i = 0; i < 4; ++i) {
+            for (int j = i; j < 4; ++j) {
+                result += (i == j ? 1.0 : 2.0) * q[k++] * p[i] * p[j];
+            }
+        }
+        return std::max(result, 0.0);
+    }
+};
+
+struct Collapse {
+    double cost = 0.0;
+    unsigned int from = kNone;
+    unsigned int to = kNone;
+    std::uint32_t version = 0;
+
+    bool operator>(const Collapse& other) const {
+        return cost > other.cost;
+    }
+};
+
+template <std::size_t Count>
+std::size_t hashFloats(const float* values) {
+    std::size_t hash = 1469598103934665603ull;
+    for (std::size_t i = 0; i < Count; ++i) {
+        std::uint32_t bits = 0;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        hash = (hash ^ bits) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Simplifies one connected component, or one patch of it. Vertex ids are
+// local; group[] maps every vertex to its position group, locked[] marks
+// seam vertices and pinned[] the vertices a patch shares with its
+// neighbours, which neither move nor receive a collapse.
+class ComponentSimplifier {
+public:
+    ComponentSimplifier(
+        std::vector<glm::vec3> positions,
+        std::vector<glm::vec3> normals,
+        std::vector<unsigned int> groups,
+        std::vector<bool> locked,
+        std::vector<bool> pinned,
+        std::vector<std::array<unsigned int, 3>> triangles
+    )
+        : positions_(std::move(positions)),
+          normals_(std::move(normals)),
+          group_(std::move(groups)),
+          locked_(std::move(locked)),
+          pinned_(std::move(pinned)),
+          triangles_(std::move(triangles)) {}
+
+    // Returns the surviving triangles. No collapse whose quadric error
+    // exceeds maxError is performed.
+    std::vector<std::array<unsigned int, 3>> run(std::size_t targetTriangles, float maxError) {
+        const std::size_t vertexCount = positions_.size();
+        const std::size_t groupCount = group_.empty() ? 0 : *std::max_element(group_.begin(), group_.end()) + 1;
+        alive_.assign(triangles_.size(), true);
+        removed_.assign(vertexCount, false);
+        border_.assign(vertexCount, false);
+        version_.assign(vertexCount, 0);
+        fans_.assign(vertexCount, {});
+        quadrics_.assign(groupCount, {});
+        members_.assign(groupCount, {});
+        for (unsigned int v = 0; v < vertexCount; ++v) {
+            members_[group_[v]].push_back(v);
+        }
+
+        for (unsigned int t = 0; t < triangles_.size(); ++t) {
+            for (const unsigned int v : triangles_[t]) {
+                fans_[v].push_back(t);
+            }
+            addTriangleQuadric(triangles_[t]);
+        }
+        for (unsigned int v = 0; v < vertexCount; ++v) {
+            addBorderQuadrics(v);
+        }
+
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+        for (unsigned int v = 0; v < vertexCount; ++v) {
+            pushBest(v, queue);
+        }
+
+        std::size_t liveTriangles = triangles_.size();
+        const double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+        while (!queue.empty() && liveTriangles > targetTriangles) {
+            const Collapse collapse = queue.top();
+            queue.pop();
+            if (removed_[collapse.from] || collapse.version != version_[collapse.from]) {
+                continue;
+            }
+            if (collapse.cost > maxCost) {
+                break;
+            }
+            if (removed_[collapse.to] || !valid(collapse.from, collapse.to)) {
+                ++version_[collapse.from];
+                pushBest(collapse.from, queue);
+                continue;
+            }
+
+            liveTriangles -= apply(collapse.from, collapse.to);
+
+            collectNeighbours(collapse.to, touched_);
+            touched_.push_back(collapse.to);
+            for (const unsigned int v : touched_) {
+                ++version_[v];
+                pushBest(v, queue);
+            }
+        }
+
+        std::vector<std::array<unsigned int, 3>> result;
+        result.reserve(liveTriangles);
+        for (std::size_t t = 0; t < triangles_.size(); ++t) {
+            if (alive_[t]) {
+                result.push_back(triangles_[t]);
+            }
+        }
+        return result;
+    }
+
+private:
+    [[nodiscard]] glm::vec3 faceNormal(const std::array<unsigned int, 3>& triangle) const {
+        const glm::vec3& a = positions_[triangle[0]];
+        return glm::cross(positions_[triangle[1]] - a, positions_[triangle[2]] - a);
+    }
+
+    void addTriangleQuadric(const std::array<unsigned int, 3>& triangle) {
+        const glm::dvec3 normal(faceNormal(triangle));
+        const double length = glm::length(normal);
+        if (length <= 0.0) {
+            return;
+        }
+
+        const glm::dvec3 unit = normal / length;
+        const double offset = -glm::dot(unit, glm::dvec3(positions_[triangle[0]]));
+        for (const unsigned int v : triangle) {
+            quadrics_[group_[v]].addPlane(unit, offset, 0.5 * length);
+        }
+    }
+
+    // Open edges are used by a single triangle; a plane through each one,
+    // perpendicular to its face, keeps the rim from drifting.
+    void addBorderQuadrics(unsigned int v) {
+        for (const unsigned int t : fans_[v]) {
+            const std::array<unsigned int, 3>& triangle = triangles_[t];
+            for (int corner = 0; corner < 3; ++corner) {
+                if (triangle[corner] != v) {
+                    continue;
+                }
+
+                // Edges along a patch cut only look open from inside it.
+                const unsigned int next = triangle[(corner + 1) % 3];
+                if ((pinned_[v] && pinned_[next]) || sharedTriangles(v, next) != 1) {
+                    continue;
+                }
+
+                const glm::dvec3 edge(positions_[next] - positions_[v]);
+                const glm::dvec3 plane = glm::cross(edge, glm::dvec3(faceNormal(triangle)));
+                const double length = glm::length(plane);
+                border_[v] = true;
+                border_[next] = true;
+                if (length <= 0.0) {
+                    continue;
+                }
+
+                const glm::dvec3 unit = plane / length;
+                const double offset = -glm::dot(unit, glm::dvec3(positions_[v]));
+                const double weight = kBorderWeight * glm::dot(edge, edge);
+                quadrics_[group_[v]].addPlane(unit, offset, weight);
+                quadrics_[group_[next]].addPlane(unit, offset, weight);
+            }
+        }
+    }
+
+    // Live triangles touching both positions, whichever wedges they use.
+    [[nodiscard]] std::size_t sharedTriangles(unsigned int v, unsigned int w) const {
+        std::size_t count = 0;
+        for (const unsigned int member : members_[group_[v]]) {
+            for (const unsigned int t : fans_[member]) {
+                if (!alive_[t]) {
+                    continue;
+                }
+                for (const unsigned int corner : triangles_[t]) {
+                    if (group_[corner] == group_[w]) {
+                        ++count;
+                        break;
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+    // The scratch vectors below are reused across calls; the queue loop
+    // asks for neighbourhoods millions of times.
+    void collectNeighbours(unsigned int v, std::vector<unsigned int>& result) const {
+        result.clear();
+        for (const unsigned int t : fans_[v]) {
+            if (!alive_[t]) {
+                continue;
+            }
+            for (const unsigned int corner : triangles_[t]) {
+                if (corner != v) {
+                    result.push_back(corner);
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+
+    void collectNeighbourGroups(unsigned int v, std::vector<unsigned int>& result) {
+        result.clear();
+        for (const unsigned int member : members_[group_[v]]) {
+            collectNeighbours(member, memberRing_);
+            for (const unsigned int w : memberRing_) {
+                result.push_back(group_[w]);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+
+    [[nodiscard]] bool valid(unsigned int from, unsigned int to) {
+        if (locked_[from] || pinned_[from] || pinned_[to] || group_[from] == group_[to]) {
+            return false;
+        }
+
+        const std::size_t shared = sharedTriangles(from, to);
+        if (shared == 0 || (border_[from] && shared != 1)) {
+            return false;
+        }
+
+        // Only one wedge of the target position may touch the source,
+        // otherwise the fan would be split across a seam.
+        collectNeighbours(from, around_);
+        std::size_t wedges = 0;
+        for (const unsigned int w : around_) {
+            wedges += group_[w] == group_[to] ? 1 : 0;
+        }
+        if (wedges != 1) {
+            return false;
+        }
+
+        // Link condition: the two rings may only meet at the vertices of the
+        // triangles that vanish, or the surface would pinch.
+        collectNeighbourGroups(from, fromRing_);
+        collectNeighbourGroups(to, toRing_);
+        common_.clear();
+        std::set_intersection(fromRing_.begin(), fromRing_.end(), toRing_.begin(), toRing_.end(), std::back_inserter(common_));
+        if (common_.size() != shared) {
+            return false;
+        }
+
+        for (const unsigned int t : fans_[from]) {
+            if (!alive_[t]) {
+                continue;
+            }
+
+            std::array<unsigned int, 3> moved = triangles_[t];
+            bool collapses = false;
+            for (unsigned int& corner : moved) {
+                collapses = collapses || group_[corner] == group_[to];
+                corner = corner == from ? to : corner;
+            }
+            if (collapses) {
+                continue;
+            }
+
+            // Checked against the face before this collapse and against the
+            // shading normals, so repeated small turns cannot add up to a flip.
+            // Faces already near perpendicular to their shading normals
+            // (caps sharing rim vertices) only need to avoid turning further.
+            const glm::vec3 before = faceNormal(triangles_[t]);
+            const glm::vec3 after = faceNormal(moved);
+            const float lengths = glm::length(before) * glm::length(after);
+            if (lengths <= 0.0f || glm::dot(before, after) < kMinFlipCosine * lengths) {
+                return false;
+            }
+            const glm::vec3 shading = normals_[moved[0]] + normals_[moved[1]] + normals_[moved[2]];
+            const float shadingLength = glm::length(shading);
+            if (shadingLength > 0.0f) {
+                const float beforeCosine = glm::dot(before, shading) / (glm::length(before) * shadingLength);
+                const float afterCosine = glm::dot(after, shading) / (glm::length(after) * shadingLength);
+                if (afterCosine < (beforeCosine > 0.1f ? 0.0f : beforeCosine - 0.5f)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void pushBest(unsigned int from, std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>>& queue) {
+        if (removed_[from] || locked_[from] || pinned_[from]) {
+            return;
+        }
+
+        // Candidates are validated cheapest first; the topology checks cost
+        // far more than evaluating the quadrics.
+        candidates_.clear();
+        collectNeighbours(from, around_);
+        for (const unsigned int to : around_) {
+            Quadric combined = quadrics_[group_[from]];
+            combined.add(quadrics_[group_[to]]);
+            const double cost = combined.evaluate(positions_[to]) / std::max(combined.weight, 1.0e-20);
+            candidates_.push_back({cost, from, to, version_[from]});
+        }
+        std::sort(candidates_.begin(), candidates_.end(), [](const Collapse& a, const Collapse& b) {
+            return a.cost < b.cost;
+        });
+
+        for (const Collapse& candidate : candidates_) {
+            if (valid(from, candidate.to)) {
+                queue.push(candidate);
+                return;
+            }
+        }
+    }
+
+    // Moves from onto to and returns how many triangles disappeared.
+    std::size_t apply(unsigned int from, unsigned int to) {
+        std::size_t vanished = 0;
+        for (const unsigned int t : fans_[from]) {
+            if (!alive_[t]) {
+                continue;
+            }
+
+            std::array<unsigned int, 3>& triangle = triangles_[t];
+            const bool collapses = std::any_of(triangle.begin(), triangle.end(), [&](unsigned int corner) {
+                return group_[corner] == group_[to];
+            });
+            if (collapses) {
+                alive_[t] = false;
+                ++vanished;
+                continue;
+            }
+
+            std::replace(triangle.begin(), triangle.end(), from, to);
+            fans_[to].push_back(t);
+        }
+
+        quadrics_[group_[to]].add(quadrics_[group_[from]]);
+        removed_[from] = true;
+        fans_[from].clear();
+        return vanished;
+    }
+
+    std::vector<glm::vec3> positions_;
+    std::vector<glm::vec3> normals_;
+    std::vector<unsigned int> group_;
+    std::vector<bool> locked_;
+    std::vector<bool> pinned_;
+    std::vector<std::array<unsigned int, 3>> triangles_;
+
+    std::vector<bool> alive_;
+    std::vector<bool> removed_;
+    std::vector<bool> border_;
+    std::vector<std::uint32_t> version_;
+    std::vector<std::vector<unsigned int>> fans_;
+    std::vector<std::vector<unsigned int>> members_;
+    std::vector<Quadric> quadrics_;
+
+    std::vector<unsigned int> around_;
+    std::vector<unsigned int> memberRing_;
+    std::vector<unsigned int> fromRing_;
+    std::vector<unsigned int> toRing_;
+    std::vector<unsigned int> common_;
+    std::vector<unsigned int> touched_;
+    std::vector<Collapse> candidates_;
+};
+
+unsigned int findRoot(std::vector<unsigned int>& parents, unsigned int v) {
+    while (parents[v] != v) {
+        parents[v] = parents[parents[v]];
+        v = parents[v];
+    }
+    return v;
+}
+
+glm::vec3 positionOf(const float* vertices, unsigned int v) {
+    const float* p = vertices + static_cast<std::size_t>(v) * kStride;
+    return {p[0], p[1], p[2]};
+}
+
+// Cuts triangles into patches of at most kPatchTriangles by recursive median
+// splits across whichever of the pass's directions spreads the centroids
+// most.
+std::vector<std::vector<std::array<unsigned int, 3>>> splitPatches(
+    const std::vector<std::array<unsigned int, 3>>& triangles,
+    const float* vertices,
+    int pass
+) {
+    std::vector<glm::vec3> centroids(triangles.size());
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        const std::array<unsigned int, 3>& triangle = triangles[t];
+        centroids[t] = (positionOf(vertices, triangle[0]) + positionOf(vertices, triangle[1]) + positionOf(vertices, triangle[2])) / 3.0f;
+    }
+
+    std::vector<unsigned int> order(triangles.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::vector<std::pair<std::size_t, std::size_t>> pending = {{0, order.size()}};
+    std::vector<std::vector<std::array<unsigned int, 3>>> patches;
+    while (!pending.empty()) {
+        const auto [begin, end] = pending.back();
+        pending.pop_back();
+        if (end - begin <= kPatchTriangles) {
+            patches.emplace_back();
+            patches.back().reserve(end - begin);
+            for (std::size_t i = begin; i < end; ++i) {
+                patches.back().push_back(triangles[order[i]]);
+            }
+            continue;
+        }
+
+        glm::vec3 direction(0.0f);
+        float widest = -1.0f;
+        for (const auto& axis : kCutDirections[pass]) {
+            const glm::vec3 candidate(axis[0], axis[1], axis[2]);
+            float low = std::numeric_limits<float>::max();
+            float high = std::numeric_limits<float>::lowest();
+            for (std::size_t i = begin; i < end; ++i) {
+                const float projection = glm::dot(centroids[order[i]], candidate);
+                low = std::min(low, projection);
+                high = std::max(high, projection);
+            }
+            if (high - low > widest) {
+                widest = high - low;
+                direction = candidate;
+            }
+        }
+
+        const std::size_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](unsigned int a, unsigned int b) {
+            return glm::dot(centroids[a], direction) < glm::dot(centroids[b], direction);
+        });
+        pending.emplace_back(begin, middle);
+        pending.emplace_back(middle, end);
+    }
+    return patches;
+}
+
+// Real-Time Collision Detection, 5.1.5.
+glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    const glm::vec3 ab = b - a;
+    const glm::vec3 ac = c - a;
+    const glm::vec3 ap = p - a;
+    const float d1 = glm::dot(ab, ap);
+    const float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        return a;
+    }
+
+    const glm::vec3 bp = p - b;
+    const float d3 = glm::dot(ab, bp);
+    const float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        return b;
+    }
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        return a + ab * (d1 / (d1 - d3));
+    }
+
+    const glm::vec3 cp = p - c;
+    const float d5 = glm::dot(ab, cp);
+    const float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        return c;
+    }
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        return a + ac * (d2 / (d2 - d6));
+    }
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+
+    const float sum = va + vb + vc;
+    if (sum <= 0.0f) {
+        return a;
+    }
+    return a + ab * (vb / sum) + ac * (vc / sum);
+}
+
+// Triangles bucketed into a sparse uniform grid for nearest-surface
+// queries. Only occupied cells are stored, sorted by key, so a thin shell
+// costs memory in proportion to its area rather than its bounding box.
+class SurfaceGrid {
+public:
+    SurfaceGrid(const float* vertices, const unsigned int* indices, std::size_t indexCount) {
+        const std::size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        corners_.resize(triangleCount * 3);
+        glm::vec3 low(std::numeric_limits<float>::max());
+        glm::vec3 high(std::numeric_limits<float>::lowest());
+        double area = 0.0;
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                corners_[t * 3 + corner] = positionOf(vertices, indices[t * 3 + corner]);
+                low = glm::min(low, corners_[t * 3 + corner]);
+                high = glm::max(high, corners_[t * 3 + corner]);
+            }
+            area += 0.5 * glm::length(glm::cross(corners_[t * 3 + 1] - corners_[t * 3], corners_[t * 3 + 2] - corners_[t * 3]));
+        }
+
+        // About two triangles across a cell, within the 21 bits per axis a
+        // key holds.
+        const float extent = std::max({high.x - low.x, high.y - low.y, high.z - low.z});
+        cellSize_ = 2.0f * static_cast<float>(std::sqrt(area / static_cast<double>(triangleCount)));
+        cellSize_ = std::max({cellSize_, extent / static_cast<float>(kMaxCells - 1), 1.0e-6f});
+        origin_ = low;
+        cells_ = glm::min(glm::ivec3((high - low) / cellSize_) + 1, glm::ivec3(kMaxCells));
+
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> entries;
+        entries.reserve(triangleCount * 4);
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            const glm::vec3* corner = &corners_[t * 3];
+            const glm::ivec3 first = cellOf(glm::min(corner[0], glm::min(corner[1], corner[2])));
+            const glm::ivec3 last = cellOf(glm::max(corner[0], glm::max(corner[1], corner[2])));
+            for (int z = first.z; z <= last.z; ++z) {
+                for (int y = first.y; y <= last.y; ++y) {
+                    for (int x = first.x; x <= last.x; ++x) {
+                        entries.emplace_back(key({x, y, z}), static_cast<std::uint32_t>(t));
+                    }
+                }
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+
+        triangles_.reserve(entries.size());
+        for (const auto& [cellKey, triangle] : entries) {
+            if (keys_.empty() || keys_.back() != cellKey) {
+                keys_.push_back(cellKey);
+                starts_.push_back(static_cast<std::uint32_t>(triangles_.size()));
+            }
+            triangles_.push_back(triangle);
+        }
+        starts_.push_back(static_cast<std::uint32_t>(triangles_.size()));
+    }
+
+    // Distance from point to the nearest triangle; zero for an empty grid.
+    [[nodiscard]] float distance(const glm::vec3& point) const {
+        if (keys_.empty()) {
+            return 0.0f;
+        }
+
+        const glm::ivec3 center = cellOf(point);
+        float best = std::numeric_limits<float>::max();
+        for (int ring = 0;; ++ring) {
+            // Once the rings would visit more cells than are occupied, every
+            // occupied cell is cheaper.
+            const double ringCells = std::pow(2.0 * ring + 1.0, 3.0);
+            if (ringCells > static_cast<double>(keys_.size())) {
+                for (std::size_t cell = 0; cell < keys_.size(); ++cell) {
+                    if (boxDistanceSquared(point, unpack(keys_[cell])) < best) {
+                        searchCell(cell, point, best);
+                    }
+                }
+                return std::sqrt(best);
+            }
+
+            for (int z = -ring; z <= ring; ++z) {
+                for (int y = -ring; y <= ring; ++y) {
+                    const bool inside = std::abs(z) != ring && std::abs(y) != ring;
+                    for (int x = -ring; x <= ring; x += inside && ring > 0 ? 2 * ring : 1) {
+                        const glm::ivec3 cell = center + glm::ivec3(x, y, z);
+                        if (glm::any(glm::lessThan(cell, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(cell, cells_))) {
+                            continue;
+                        }
+                        const auto found = std::lower_bound(keys_.begin(), keys_.end(), key(cell));
+                        if (found != keys_.end() && *found == key(cell)) {
+                            searchCell(static_cast<std::size_t>(found - keys_.begin()), point, best);
+                        }
+                    }
+                }
+            }
+
+            // Anything not yet searched lies outside the block of cells
+            // within ring, beyond whichever of its faces still has cells
+            // past it.
+            float margin = std::numeric_limits<float>::max();
+            for (int axis = 0; axis < 3; ++axis) {
+                if (center[axis] - ring > 0) {
+                    const float face = origin_[axis] + static_cast<float>(center[axis] - ring) * cellSize_;
+                    margin = std::min(margin, point[axis] - face);
+                }
+                if (center[axis] + ring < cells_[axis] - 1) {
+                    const float face = origin_[axis] + static_cast<float>(center[axis] + ring + 1) * cellSize_;
+                    margin = std::min(margin, face - point[axis]);
+                }
+            }
+            if (margin == std::numeric_limits<float>::max() || (margin > 0.0f && best <= margin * margin)) {
+                return std::sqrt(best);
+            }
+        }
+    }
+
+private:
+    static constexpr int kMaxCells = 1 << 21;
+
+    [[nodiscard]] glm::ivec3 cellOf(const glm::vec3& point) const {
+        return glm::clamp(glm::ivec3(glm::floor((point - origin_) / cellSize_)), glm::ivec3(0), cells_ - 1);
+    }
+
+    [[nodiscard]] static std::uint64_t key(const glm::ivec3& cell) {
+        return static_cast<std::uint64_t>(cell.x) | static_cast<std::uint64_t>(cell.y) << 21 | static_cast<std::uint64_t>(cell.z) << 42;
+    }
+
+    [[nodiscard]] static glm::ivec3 unpack(std::uint64_t cellKey) {
+        constexpr std::uint64_t mask = kMaxCells - 1;
+        return {static_cast<int>(cellKey & mask), static_cast<int>(cellKey >> 21 & mask), static_cast<int>(cellKey >> 42 & mask)};
+    }
+
+    [[nodiscard]] float boxDistanceSquared(const glm::vec3& point, const glm::ivec3& cell) const {
+        const glm::vec3 low = origin_ + glm::vec3(cell) * cellSize_;
+        const glm::vec3 outside = glm::max(glm::max(low - point, point - (low + cellSize_)), glm::vec3(0.0f));
+        return glm::dot(outside, outside);
+    }
+
+    void searchCell(std::size_t cell, const glm::vec3& point, float& best) const {
+        for (std::uint32_t i = starts_[cell]; i < starts_[cell + 1]; ++i) {
+            const glm::vec3* corner = &corners_[static_cast<std::size_t>(triangles_[i]) * 3];
+            const glm::vec3 offset = closestPointOnTriangle(point, corner[0], corner[1], corner[2]) - point;
+            best = std::min(best, glm::dot(offset, offset));
+        }
+    }
+
+    std::vector<glm::vec3> corners_;
+    glm::vec3 origin_{0.0f};
+    float cellSize_ = 1.0f;
+    glm::ivec3 cells_{1};
+    std::vector<std::uint64_t> keys_;
+    // Triangles of keys_[i] are triangles_[starts_[i]] to triangles_[starts_[i + 1]].
+    std::vector<std::uint32_t> starts_;
+    std::vector<std::uint32_t> triangles_;
+};
+
+// Largest distance from the mesh to the grid's surface, sampled at every
+// vertex and face centre of the mesh.
+float largestDistance(const float* vertices, const unsigned int* indices, std::size_t indexCount, const SurfaceGrid& surface) {
+    std::vector<glm::vec3> samples;
+    samples.reserve(indexCount + indexCount / 3);
+    std::vector<unsigned int> sorted(indices, indices + indexCount);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    for (const unsigned int v : sorted) {
+        samples.push_back(positionOf(vertices, v));
+    }
+    for (std::size_t i = 0; i + 2 < indexCount; i += 3) {
+        samples.push_back((positionOf(vertices, indices[i]) + positionOf(vertices, indices[i + 1]) + positionOf(vertices, indices[i + 2])) / 3.0f);
+    }
+
+    std::vector<float> distances(samples.size());
+    parallelFor(samples.size(), 4096, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            distances[i] = surface.distance(samples[i]);
+        }
+    });
+    return distances.empty() ? 0.0f : *std::max_element(distances.begin(), distances.end());
+}
+
+}  // namespace
+
+std::vector<unsigned int> simplifyMesh(
+    const float* vertices,
+    std::size_t vertexCount,
+    const unsigned int* indices,
+    std::size_t indexCount,
+    std::size_t targetIndexCount,
+    float maxError,
+    float* resultError
+) {
+    // Exact duplicates are merged; vertices that share only a position are
+    // wedges of a seam and are locked.
+    std::vector<unsigned int> canonical(vertexCount);
+    std::vector<unsigned int> weld(vertexCount);
+    std::vector<std::uint32_t> wedgeCount(vertexCount, 0);
+    {
+        std::unordered_multimap<std::size_t, unsigned int> exact;
+        std::unordered_multimap<std::size_t, unsigned int> byPosition;
+        exact.reserve(vertexCount);
+        byPosition.reserve(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; ++v) {
+            const float* data = vertices + v * kStride;
+
+            canonical[v] = v;
+            const std::size_t exactHash = hashFloats<kStride>(data);
+            for (auto [it, end] = exact.equal_range(exactHash); it != end; ++it) {
+                if (std::memcmp(vertices + it->second * kStride, data, kStride * sizeof(float)) == 0) {
+                    canonical[v] = it->second;
+                    break;
+                }
+            }
+            if (canonical[v] != v) {
+                weld[v] = weld[canonical[v]];
+                continue;
+            }
+            exact.emplace(exactHash, v);
+
+            weld[v] = v;
+            const std::size_t positionHash = hashFloats<3>(data);
+            for (auto [it, end] = byPosition.equal_range(positionHash); it != end; ++it) {
+                if (std::memcmp(vertices + it->second * kStride, data, 3 * sizeof(float)) == 0) {
+                    weld[v] = it->second;
+                    break;
+                }
+            }
+            if (weld[v] == v) {
+                byPosition.emplace(positionHash, v);
+            }
+            ++wedgeCount[weld[v]];
+        }
+    }
+
+    // Components over welded positions, so both sides of a seam stay
+    // together.
+    const std::size_t triangleCount = indexCount / 3;
+    std::vector<unsigned int> parents(vertexCount);
+    std::iota(parents.begin(), parents.end(), 0u);
+    std::vector<std::array<unsigned int, 3>> triangles;
+    triangles.reserve(triangleCount);
+    for (std::size_t t = 0; t < triangleCount; ++t) {
+        const std::array<unsigned int, 3> triangle = {
+            canonical[indices[t * 3]],
+            canonical[indices[t * 3 + 1]],
+            canonical[indices[t * 3 + 2]],
+        };
+        if (weld[triangle[0]] == weld[triangle[1]] || weld[triangle[1]] == weld[triangle[2]]
+            || weld[triangle[2]] == weld[triangle[0]]) {
+            continue;
+        }
+
+        triangles.push_back(triangle);
+        parents[findRoot(parents, weld[triangle[1]])] = findRoot(parents, weld[triangle[0]]);
+        parents[findRoot(parents, weld[triangle[2]])] = findRoot(parents, weld[triangle[0]]);
+    }
+
+    std::unordered_map<unsigned int, std::size_t> componentOf;
+    std::vector<std::vector<std::array<unsigned int, 3>>> components;
+    for (const std::array<unsigned int, 3>& triangle : triangles) {
+        const unsigned int root = findRoot(parents, weld[triangle[0]]);
+        const auto [it, inserted] = componentOf.emplace(root, components.size());
+        if (inserted) {
+            components.emplace_back();
+        }
+        components[it->second].push_back(triangle);
+    }
+
+    // A piece is a whole component or one patch of a large one. Patches of
+    // a pass are simplified side by side, so the vertices they share are
+    // pinned in place.
+    struct Piece {
+        std::size_t component = 0;
+        std::vector<std::array<unsigned int, 3>> triangles;
+        std::size_t target = 0;
+    };
+    const auto simplifyPieces = [&](std::vector<Piece>& pieces, const std::vector<bool>& pinnedWelds) {
+        parallelFor(pieces.size(), 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; ++p) {
+                Piece& piece = pieces[p];
+
+                std::unordered_map<unsigned int, unsigned int> local;
+                std::unordered_map<unsigned int, unsigned int> localGroup;
+                std::vector<glm::vec3> positions;
+                std::vector<glm::vec3> normals;
+                std::vector<unsigned int> groups;
+                std::vector<bool> locked;
+                std::vector<bool> pinned;
+                std::vector<unsigned int> globalIds;
+                std::vector<std::array<unsigned int, 3>> localTriangles;
+                localTriangles.reserve(piece.triangles.size());
+                for (const std::array<unsigned int, 3>& triangle : piece.triangles) {
+                    std::array<unsigned int, 3> mapped{};
+                    for (std::size_t corner = 0; corner < 3; ++corner) {
+                        const unsigned int v = triangle[corner];
+                        const auto [it, inserted] = local.emplace(v, static_cast<unsigned int>(positions.size()));
+                        if (inserted) {
+                            const auto group = localGroup.emplace(weld[v], static_cast<unsigned int>(localGroup.size()));
+                            positions.push_back(positionOf(vertices, v));
+                            normals.emplace_back(vertices[v * kStride + 3], vertices[v * kStride + 4], vertices[v * kStride + 5]);
+                            groups.push_back(group.first->second);
+                            locked.push_back(wedgeCount[weld[v]] > 1);
+                            pinned.push_back(pinnedWelds[weld[v]]);
+                            globalIds.push_back(v);
+                        }
+                        mapped[corner] = it->second;
+                    }
+                    localTriangles.push_back(mapped);
+                }
+
+                ComponentSimplifier simplifier(
+                    std::move(positions),
+                    std::move(normals),
+                    std::move(groups),
+                    std::move(locked),
+                    std::move(pinned),
+                    std::move(localTriangles)
+                );
+                piece.triangles = simplifier.run(piece.target, maxError);
+                for (std::array<unsigned int, 3>& triangle : piece.triangles) {
+                    for (unsigned int& corner : triangle) {
+                        corner = globalIds[corner];
+                    }
+                }
+            }
+        });
+    };
+    // Cuts every large component into patches for the pass and pins the
+    // welded positions that more than one patch uses.
+    const auto cutPatches = [&](std::vector<std::vector<std::array<unsigned int, 3>>>& sources,
+                                const std::vector<bool>& large,
+                                int pass,
+                                std::vector<Piece>& pieces,
+                                std::vector<bool>& pinnedWelds) {
+        std::vector<unsigned int> owner(vertexCount, kNone);
+        pinnedWelds.assign(vertexCount, false);
+        for (std::size_t c = 0; c < sources.size(); ++c) {
+            if (!large[c]) {
+                continue;
+            }
+            for (std::vector<std::array<unsigned int, 3>>& patch : splitPatches(sources[c], vertices, pass)) {
+                const auto id = static_cast<unsigned int>(pieces.size());
+                for (const std::array<unsigned int, 3>& triangle : patch) {
+                    for (const unsigned int v : triangle) {
+                        if (owner[weld[v]] == kNone) {
+                            owner[weld[v]] = id;
+                        } else if (owner[weld[v]] != id) {
+                            pinnedWelds[weld[v]] = true;
+                        }
+                    }
+                }
+                pieces.push_back({c, std::move(patch), 0});
+            }
+            sources[c].clear();
+        }
+    };
+
+    const double keep = triangles.empty() ? 1.0 : static_cast<double>(targetIndexCount / 3) / static_cast<double>(triangles.size());
+    std::vector<std::size_t> componentTargets(components.size());
+    std::vector<bool> large(components.size(), false);
+    std::vector<Piece> pieces;
+    std::vector<bool> pinnedWelds;
+    for (std::size_t c = 0; c < components.size(); ++c) {
+        componentTargets[c] = static_cast<std::size_t>(keep * static_cast<double>(components[c].size()));
+        large[c] = components[c].size() > kPatchTriangles;
+    }
+    cutPatches(components, large, 0, pieces, pinnedWelds);
+    for (std::size_t c = 0; c < components.size(); ++c) {
+        if (!large[c]) {
+            pieces.push_back({c, std::move(components[c]), componentTargets[c]});
+        }
+    }
+
+    // The first pass leaves the triangles around its cuts for the second,
+    // whose cuts run across them, so no region stays pinned throughout.
+    for (Piece& piece : pieces) {
+        if (!large[piece.component]) {
+            continue;
+        }
+        const auto band = static_cast<std::size_t>(std::count_if(piece.triangles.begin(), piece.triangles.end(), [&](const std::array<unsigned int, 3>& triangle) {
+            return pinnedWelds[weld[triangle[0]]] || pinnedWelds[weld[triangle[1]]] || pinnedWelds[weld[triangle[2]]];
+        }));
+        piece.target = static_cast<std::size_t>(keep * static_cast<double>(piece.triangles.size() - band)) + band;
+    }
+    simplifyPieces(pieces, pinnedWelds);
+
+    std::vector<std::vector<std::array<unsigned int, 3>>> results(components.size());
+    for (Piece& piece : pieces) {
+        std::vector<std::array<unsigned int, 3>>& result = results[piece.component];
+        result.insert(result.end(), piece.triangles.begin(), piece.triangles.end());
+    }
+
+    pieces.clear();
+    cutPatches(results, large, 1, pieces, pinnedWelds);
+    if (!pieces.empty()) {
+        std::vector<std::size_t> current(components.size(), 0);
+        for (const Piece& piece : pieces) {
+            current[piece.component] += piece.triangles.size();
+        }
+        for (Piece& piece : pieces) {
+            const double share = static_cast<double>(componentTargets[piece.component])
+                / static_cast<double>(std::max<std::size_t>(current[piece.component], 1));
+            piece.target = static_cast<std::size_t>(share * static_cast<double>(piece.triangles.size()));
+        }
+        simplifyPieces(pieces, pinnedWelds);
+        for (Piece& piece : pieces) {
+            std::vector<std::array<unsigned int, 3>>& result = results[piece.component];
+            result.insert(result.end(), piece.triangles.begin(), piece.triangles.end());
+        }
+    }
+
+    std::vector<unsigned int> simplified;
+    for (const std::vector<std::array<unsigned int, 3>>& result : results) {
+        for (const std::array<unsigned int, 3>& triangle : result) {
+            simplified.insert(simplified.end(), triangle.begin(), triangle.end());
+        }
+    }
+    if (resultError != nullptr) {
+        *resultError = surfaceDistance(vertices, indices, indexCount, vertices, simplified.data(), simplified.size());
+    }
+    return simplified;
+}
+
+float surfaceDistance(
+    const float* verticesA,
+    const unsigned int* indicesA,
+    std::size_t indexCountA,
+    const float* verticesB,
+    const unsigned int* indicesB,
+    std::size_t indexCountB
+) {
+    if (indexCountA < 3 || indexCountB < 3) {
+        return 0.0f;
+    }
+    const SurfaceGrid surfaceA(verticesA, indicesA, indexCountA);
+    const SurfaceGrid surfaceB(verticesB, indicesB, indexCountB);
+    return std::max(
+        largestDistance(verticesA, indicesA, indexCountA, surfaceB),
+        largestDistance(verticesB, indicesB, indexCountB, surfaceA)
+    );
+}
+
+std::vector<LodLevel> buildLodChain(
+    const float* vertices,
+    std::size_t vertexCount,
+    const unsigned int* indices,
+    std::size_t indexCount,
+    const LodChainOptions& options
+) {
+    glm::dvec3 centroid(0.0);
+    for (unsigned int v = 0; v < vertexCount; ++v) {
+        centroid += glm::dvec3(positionOf(vertices, v));
+    }
+    centroid /= static_cast<double>(std::max<std::size_t>(vertexCount, 1));
+    float radius = 0.0f;
+    for (unsigned int v = 0; v < vertexCount; ++v) {
+        radius = std::max(radius, glm::length(positionOf(vertices, v) - glm::vec3(centroid)));
+    }
+    const float maxError = options.maxRelativeError * radius;
+
+    std::vector<LodLevel> levels;
+    std::vector<float> sourceVertices(vertices, vertices + vertexCount * kStride);
+    std::vector<unsigned int> sourceIndices(indices, indices + indexCount);
+    const SurfaceGrid original(vertices, indices, indexCount);
+    float error = 0.0f;
+
+    // Each level starts from the previous one but is measured against the
+    // original, since the errors of successive steps do not simply add up.
+    while (levels.size() < options.maxLevels && sourceIndices.size() / 3 > options.minTriangles) {
+        const auto target = static_cast<std::size_t>(static_cast<float>(sourceIndices.size() / 3) * options.reduction) * 3;
+        std::vector<unsigned int> reduced = simplifyMesh(
+            sourceVertices.data(),
+            sourceVertices.size() / kStride,
+            sourceIndices.data(),
+            sourceIndices.size(),
+            std::max(target, options.minTriangles * 3),
+            maxError
+        );
+        // Levels that barely shrink cost memory without saving work.
+        if (reduced.empty() || reduced.size() > sourceIndices.size() * 9 / 10) {
+            break;
+        }
+
+        LodLevel level;
+        std::vector<unsigned int> remap(sourceVertices.size() / kStride, kNone);
+        level.indices.reserve(reduced.size());
+        for (const unsigned int v : reduced) {
+            if (remap[v] == kNone) {
+                remap[v] = static_cast<unsigned int>(level.vertices.size() / kStride);
+                level.vertices.insert(level.vertices.end(), &sourceVertices[v * kStride], &sourceVertices[v * kStride] + kStride);
+            }
+            level.indices.push_back(remap[v]);
+        }
+
+        // Kept non-decreasing, so a coarser level never claims to be closer.
+        const SurfaceGrid simplified(level.vertices.data(), level.indices.data(), level.indices.size());
+        error = std::max({
+            error,
+            largestDistance(level.vertices.data(), level.indices.data(), level.indices.size(), original),
+            largestDistance(vertices, indices, indexCount, simplified),
+        });
+        if (error > maxError) {
+            break;
+        }
+        level.error = error;
+
+        sourceVertices = level.vertices;
+        sourceIndices = level.indices;
+        levels.push_back(std::move(level));
+    }
+    return levels;
+}
+
+}  // namespace meshgen
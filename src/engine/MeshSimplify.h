@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace meshgen {
+
+struct LodLevel {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    // Largest distance, in mesh units, between this level and the source,
+    // as measured by surfaceDistance().
+    float error = 0.0f;
+};
+
+struct LodChainOptions {
+    std::size_t maxLevels = 4;
+    // Triangle count of each level relative to the previous one.
+    float reduction = 0.5f;
+    // Levels whose error exceeds this fraction of the bounding radius around
+    // the vertex centroid are dropped, which bounds the chain.
+    float maxRelativeError = 0.1f;
+    std::size_t minTriangles = 16;
+};
+
+// Quadric-error edge collapse (vertices only move onto existing neighbours,
+// so normals and texcoords stay exact). Vertices whose position is shared
+// by several attribute sets lie on a UV or normal seam and never move, and
+// open borders only collapse along themselves. Disconnected components are
+// simplified in parallel, and large ones are cut into patches that are, in
+// two passes whose cuts cross. Returns the reduced index list, referencing
+// the input vertices. maxError caps the quadric error of each collapse, an
+// area-weighted RMS distance to the planes the vertex has absorbed;
+// resultError receives the surfaceDistance() between input and result.
+[[nodiscard]] std::vector<unsigned int> simplifyMesh(
+    const float* vertices,
+    std::size_t vertexCount,
+    const unsigned int* indices,
+    std::size_t indexCount,
+    std::size_t targetIndexCount,
+    float maxError,
+    float* resultError = nullptr
+);
+
+// Largest distance between the two surfaces, sampled at every vertex and
+// face centre of each mesh against the other. Zero when either is empty.
+[[nodiscard]] float surfaceDistance(
+    const float* verticesA,
+    const unsigned int* indicesA,
+    std::size_t indexCountA,
+    const float* verticesB,
+    const unsigned int* indicesB,
+    std::size_t indexCountB
+);
+
+// Successively coarser, compacted levels (the source itself is not
+// included). Each level is measured against the source; the chain stops
+// when a level no longer shrinks or exceeds the error bound.
+[[nodiscard]] std::vector<LodLevel> buildLodChain(
+    const float* vertices,
+    std::size_t vertexCount,
+    const unsigned int* indices,
+    std::size_t indexCount,
+    const LodChainOptions& options = {}
+);
+
+}  // namespace meshgen
@@ -0,0 +1,152 @@
+#include "engine/Meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "app_config.hpp"
+
+namespace meshgen {
+
+std::vector<Meshlet> buildMeshlets(
+    const float* vertices,
+    std::size_t vertexCount,
+    unsigned int* indices,
+    std::size_t indexCount,
+    const MeshletOptions& options
+) {
+    const std::size_t triangleCount = indexCount / 3;
+    const std::size_t maxTriangles = std::max<std::size_t>(1, options.maxTriangles);
+    const float minSeedDot = std::cos(options.maxNormalAngle);
+    const auto position = [vertices](unsigned int vertex) {
+        const float* p = vertices + static_cast<std::size_t>(vertex) * app::kVertexStrideFloats;
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    // Degenerate triangles keep a zero normal and join any meshlet.
+    std::vector<glm::vec3> normals(triangleCount, glm::vec3(0.0f));
+    for (std::size_t t = 0; t < triangleCount; ++t) {
+        const glm::vec3 a = position(indices[t * 3]);
+        const glm::vec3 normal = glm::cross(position(indices[t * 3 + 1]) - a, position(indices[t * 3 + 2]) - a);
+        const float length = glm::length(normal);
+        if (length > 0.0f) {
+            normals[t] = normal / length;
+        }
+    }
+
+    // Vertex to triangle adjacency in compressed rows.
+    std::vector<std::size_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+        ++adjacencyOffsets[indices[i] + 1];
+    }
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    std::vector<std::size_t> adjacency(triangleCount * 3);
+    {
+        std::vector<std::size_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+            adjacency[cursor[indices[i]]++] = i / 3;
+        }
+    }
+
+    constexpr std::size_t kUnvisited = std::numeric_limits<std::size_t>::max();
+    std::vector<bool> assigned(triangleCount, false);
+    std::vector<std::size_t> visitedBy(triangleCount, kUnvisited);
+    std::vector<unsigned int> reordered;
+    reordered.reserve(triangleCount * 3);
+    std::vector<std::size_t> members;
+    std::vector<std::size_t> frontier;
+    std::vector<Meshlet> meshlets;
+
+    for (std::size_t seed = 0; seed < triangleCount; ++seed) {
+        if (assigned[seed]) {
+            continue;
+        }
+
+        const std::size_t meshletIndex = meshlets.size();
+        glm::vec3 seedNormal = normals[seed];
+        members.clear();
+        frontier.assign(1, seed);
+        visitedBy[seed] = meshletIndex;
+
+        // Breadth-first growth keeps meshlets compact.
+        for (std::size_t next = 0; next < frontier.size() && members.size() < maxTriangles; ++next) {
+            const std::size_t t = frontier[next];
+            const bool degenerate = normals[t] == glm::vec3(0.0f);
+            if (!degenerate && seedNormal != glm::vec3(0.0f) && glm::dot(normals[t], seedNormal) < minSeedDot) {
+                continue;
+            }
+            if (seedNormal == glm::vec3(0.0f)) {
+                seedNormal = normals[t];
+            }
+
+            assigned[t] = true;
+            members.push_back(t);
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                const unsigned int vertex = indices[t * 3 + corner];
+                for (std::size_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; ++a) {
+                    const std::size_t neighbour = adjacency[a];
+                    if (!assigned[neighbour] && visitedBy[neighbour] != meshletIndex) {
+                        visitedBy[neighbour] = meshletIndex;
+                        frontier.push_back(neighbour);
+                    }
+                }
+            }
+        }
+
+        Meshlet meshlet;
+        meshlet.firstIndex = reordered.size();
+        meshlet.indexCount = members.size() * 3;
+
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+        glm::vec3 normalSum(0.0f);
+        for (const std::size_t t : members) {
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                const unsigned int vertex = indices[t * 3 + corner];
+                reordered.push_back(vertex);
+                boundsMin = glm::min(boundsMin, position(vertex));
+                boundsMax = glm::max(boundsMax, position(vertex));
+            }
+            normalSum += normals[t];
+        }
+
+        meshlet.center = 0.5f * (boundsMin + boundsMax);
+        for (const std::size_t t : members) {
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                meshlet.radius = std::max(meshlet.radius, glm::length(position(indices[t * 3 + corner]) - meshlet.center));
+            }
+        }
+
+        // The cone must contain every normal; once it reaches a hemisphere
+        // no viewpoint sees only back faces and the test is disabled.
+        const float axisLength = glm::length(normalSum);
+        if (axisLength > 0.0f) {
+            meshlet.coneAxis = normalSum / axisLength;
+            float minDot = 1.0f;
+            for (const std::size_t t : members) {
+                if (normals[t] != glm::vec3(0.0f)) {
+                    minDot = std::min(minDot, glm::dot(normals[t], meshlet.coneAxis));
+                }
+            }
+            meshlet.coneCutoff = minDot > 0.0f ? std::sqrt(std::max(0.0f, 1.0f - minDot * minDot)) : 1.0f;
+        }
+
+        meshlets.push_back(meshlet);
+    }
+
+    std::copy(reordered.begin(), reordered.end(), indices);
+    return meshlets;
+}
+
+bool meshletBackfacing(const Meshlet& meshlet, const glm::vec3& cameraPosition) {
+    if (meshlet.coneCutoff >= 1.0f) {
+        return false;
+    }
+
+    const glm::vec3 toCenter = meshlet.center - cameraPosition;
+    return glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+}
+
+}  // namespace meshgen
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace meshgen {
+
+// A contiguous index range with a bounding sphere and a normal cone, tested
+// on the CPU before the range is submitted.
+struct Meshlet {
+    std::size_t firstIndex = 0;
+    std::size_t indexCount = 0;
+    glm::vec3 center{0.0f};
+    float radius = 0.0f;
+    glm::vec3 coneAxis{0.0f, 0.0f, 1.0f};
+    // Sine of the cone half-angle; 1 disables the backface test.
+    float coneCutoff = 1.0f;
+};
+
+struct MeshletOptions {
+    std::size_t maxTriangles = 256;
+    // Triangles turned further than this from a meshlet's seed start a new
+    // meshlet. Narrower cones reject more often but split meshes finer.
+    float maxNormalAngle = 0.45f;
+};
+
+// Grows meshlets over shared vertices and reorders indices so every meshlet
+// is one contiguous range. Vertices use app::kVertexStrideFloats floats and
+// triangles are counter-clockwise when seen from outside.
+[[nodiscard]] std::vector<Meshlet> buildMeshlets(
+    const float* vertices,
+    std::size_t vertexCount,
+    unsigned int* indices,
+    std::size_t indexCount,
+    const MeshletOptions& options = {}
+);
+
+// True when every triangle of the meshlet faces away from cameraPosition.
+[[nodiscard]] bool meshletBackfacing(const Meshlet& meshlet, const glm::vec3& cameraPosition);
+
+}  // namespace meshgen
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A pool of threads that also takes loose tasks, such as the texture
+// loader's workers. parallelFor on one of its threads hands the batches to
+// the pool instead of starting threads of its own, so the pool never runs
+// more threads than it has.
+class TaskPool {
+public:
+    // Runs task on one of the pool's threads when one is free.
+    virtual void submit(std::function<void()> task) = 0;
+
+protected:
+    ~TaskPool() = default;
+};
+
+// The pool the calling thread belongs to, or null.
+inline TaskPool*& currentPool() {
+    thread_local TaskPool* pool = nullptr;
+    return pool;
+}
+
+namespace parallel_detail {
+
+struct Batches {
+    std::size_t count = 0;
+    std::atomic<std::size_t> next{0};
+    std::size_t done = 0;
+    std::mutex mutex;
+    std::condition_variable finished;
+};
+
+// Claims and runs batches until none are left. A batch runs on whichever
+// thread claims it first, so tasks still queued after the caller ran out
+// of batches find nothing to do.
+template <typename Function>
+void runBatches(Batches& batches, std::size_t count, std::size_t batchSize, Function& function) {
+    for (;;) {
+        const std::size_t batch = batches.next.fetch_add(1);
+        if (batch >= batches.count) {
+            return;
+        }
+        const std::size_t begin = batch * batchSize;
+        function(begin, std::min(count, begin + batchSize));
+        {
+            std::lock_guard<std::mutex> lock(batches.mutex);
+            ++batches.done;
+        }
+        batches.finished.notify_all();
+    }
+}
+
+}  // namespace parallel_detail
+
+// Splits [0, count) into contiguous ranges and runs function(begin, end) on
+// worker threads. Ranges smaller than minBatch are never split further. On
+// a pool thread the ranges are offered to the pool's idle threads and the
+// caller runs every range nobody took, so it only ever waits for ranges
+// that are already running.
+template <typename Function>
+void parallelFor(std::size_t count, std::size_t minBatch, Function&& function) {
+    if (count == 0) {
+        return;
+    }
+
+    const std::size_t hardwareThreads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    const std::size_t maxBatches = std::max<std::size_t>(1, count / std::max<std::size_t>(1, minBatch));
+    const std::size_t batchCount = std::min(hardwareThreads, maxBatches);
+
+    if (batchCount == 1) {
+        function(std::size_t{0}, count);
+        return;
+    }
+
+    const std::size_t batchSize = (count + batchCount - 1) / batchCount;
+    if (TaskPool* pool = currentPool()) {
+        auto batches = std::make_shared<parallel_detail::Batches>();
+        batches->count = (count + batchSize - 1) / batchSize;
+        auto* callable = &function;
+        for (std::size_t batch = 1; batch < batches->count; ++batch) {
+            pool->submit([batches, count, batchSize, callable]() {
+                parallel_detail::runBatches(*batches, count, batchSize, *callable);
+            });
+        }
+        parallel_detail::runBatches(*batches, count, batchSize, function);
+
+        std::unique_lock<std::mutex> lock(batches->mutex);
+        batches->finished.wait(lock, [&batches]() {
+            return batches->done == batches->count;
+        });
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(batchCount - 1);
+
+    for (std::size_t batch = 1; batch < batchCount; ++batch) {
+        const std::size_t begin = batch * batchSize;
+        const std::size_t end = std::min(count, begin + batchSize);
+        if (begin >= end) {
+            break;
+        }
+        workers.emplace_back([&function, begin, end]() { function(begin, end); });
+    }
+
+    function(std::size_t{0}, std::min(count, batchSize));
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
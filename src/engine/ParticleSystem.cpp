@@ -3,6 +3,8 @@
 #include <cmath>
 #include <cstdlib>
 
+#include "engine/ShaderManager.h"
+
 namespace {
 
 constexpr float kPi = 3.14159265359f;
@@ -87,7 +89,7 @@ void ParticleSystem::initialize(int count) {
         resetParticle(p, emitterPosition_);
     }
 
-    shader_.loadFromFiles("shaders/particle_vertex.glsl", "shaders/particle_fragment.glsl");
+    ShaderManager::shared().load(shader_, "shaders/particle_vertex.glsl", "shaders/particle_fragment.glsl");
     glEnable(GL_PROGRAM_POINT_SIZE);
 
     glGenVertexArrays(1, &VAO_);
@@ -0,0 +1,326 @@
+#include "engine/PolylineStream.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <utility>
+
+#include "engine/Parallel.h"
+
+namespace {
+
+constexpr char kBinaryMagic[8] = {'T', 'U', 'B', 'E', 'P', 'L', '0', '1'};
+constexpr std::size_t kBinaryRecordBytes = 24;
+
+// Parses one comma-separated field and returns the position after its
+// separator, or nullptr when the field is missing or malformed.
+template <typename T>
+const char* parseField(const char* cursor, const char* end, T& value) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+        ++cursor;
+    }
+
+    const auto [next, error] = std::from_chars(cursor, end, value);
+    if (error != std::errc()) {
+        return nullptr;
+    }
+
+    cursor = next;
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+        ++cursor;
+    }
+    if (cursor == end) {
+        return end;
+    }
+    return *cursor == ',' ? cursor + 1 : nullptr;
+}
+
+}  // namespace
+
+PolylineStream::~PolylineStream() {
+    close();
+}
+
+void PolylineStream::open(const std::string& path, const PolylineStreamOptions& options) {
+    close();
+
+    file_ = MappedFile(path);
+    options_ = options;
+    options_.chunkBytes = std::max<std::size_t>(options_.chunkBytes, 64u * 1024u);
+    options_.chunksPerBatch = std::max<std::size_t>(options_.chunksPerBatch, 1);
+
+    binary_ = file_.size() >= sizeof(kBinaryMagic) && std::memcmp(file_.data(), kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+    dataBegin_ = binary_ ? sizeof(kBinaryMagic) : 0;
+    if (!binary_ && file_.size() >= 3 && std::memcmp(file_.data(), "\xEF\xBB\xBF", 3) == 0) {
+        dataBegin_ = 3;
+    }
+
+    stop_ = false;
+    done_ = false;
+    bytesParsed_ = dataBegin_;
+    segmentsParsed_ = 0;
+    worker_ = std::thread(&PolylineStream::run, this);
+}
+
+void PolylineStream::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    spaceAvailable_.notify_all();
+
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+
+    queue_.clear();
+    queueHead_ = 0;
+    queuedSegments_ = 0;
+    file_ = MappedFile();
+    done_ = false;
+}
+
+std::size_t PolylineStream::poll(std::vector<TubeSegment>& out, std::size_t maxSegments) {
+    std::size_t added = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (added < maxSegments && !queue_.empty()) {
+            const std::vector<TubeSegment>& front = queue_.front();
+            const std::size_t take = std::min(front.size() - queueHead_, maxSegments - added);
+            const auto first = front.begin() + static_cast<std::ptrdiff_t>(queueHead_);
+            out.insert(out.end(), first, first + static_cast<std::ptrdiff_t>(take));
+
+            added += take;
+            queueHead_ += take;
+            if (queueHead_ == front.size()) {
+                queue_.pop_front();
+                queueHead_ = 0;
+            }
+        }
+        queuedSegments_ -= added;
+    }
+
+    if (added > 0) {
+        spaceAvailable_.notify_one();
+    }
+    return added;
+}
+
+bool PolylineStream::active() const {
+    return worker_.joinable();
+}
+
+bool PolylineStream::finished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return done_ && queuedSegments_ == 0;
+}
+
+float PolylineStream::progress() const {
+    if (file_.size() == 0) {
+        return done_ ? 1.0f : 0.0f;
+    }
+    return static_cast<float>(bytesParsed_.load()) / static_cast<float>(file_.size());
+}
+
+std::size_t PolylineStream::segmentsParsed() const {
+    return segmentsParsed_;
+}
+
+void PolylineStream::run() {
+    const std::size_t end = binary_ ? dataBegin_ + (file_.size() - dataBegin_) / kBinaryRecordBytes * kBinaryRecordBytes
+                                    : file_.size();
+    std::size_t offset = dataBegin_;
+    Point previous;
+    bool hasPrevious = false;
+
+    while (!stop_ && offset < end) {
+        const std::vector<std::size_t> bounds = splitBatch(offset);
+        const std::size_t chunkCount = bounds.size() - 1;
+
+        std::vector<ParsedChunk> parsed(chunkCount);
+        parallelFor(chunkCount, 1, [&](std::size_t begin, std::size_t last) {
+            for (std::size_t i = begin; i < last; ++i) {
+                parsed[i] = binary_ ? parseBinary(bounds[i], bounds[i + 1]) : parseCsv(bounds[i], bounds[i + 1]);
+            }
+        });
+
+        // Chunks are stitched in file order so polylines crossing a chunk
+        // boundary stay connected.
+        std::size_t total = 0;
+        for (const ParsedChunk& chunk : parsed) {
+            total += chunk.segments.size() + 1;
+        }
+        std::vector<TubeSegment> segments;
+        segments.reserve(total);
+        for (ParsedChunk& chunk : parsed) {
+            if (!chunk.hasPoints) {
+                continue;
+            }
+            if (hasPrevious) {
+                connect(previous, chunk.first, segments);
+            }
+            segments.insert(segments.end(), chunk.segments.begin(), chunk.segments.end());
+            previous = chunk.last;
+            hasPrevious = true;
+        }
+
+        file_.discard(offset, bounds.back() - offset);
+        offset = bounds.back();
+        bytesParsed_ = offset;
+        publish(std::move(segments));
+    }
+
+    bytesParsed_ = file_.size();
+    done_ = true;
+}
+
+std::vector<std::size_t> PolylineStream::splitBatch(std::size_t begin) const {
+    std::vector<std::size_t> bounds{begin};
+
+    if (binary_) {
+        const std::size_t end = dataBegin_ + (file_.size() - dataBegin_) / kBinaryRecordBytes * kBinaryRecordBytes;
+        const std::size_t chunkBytes = std::max<std::size_t>(1, options_.chunkBytes / kBinaryRecordBytes) * kBinaryRecordBytes;
+        while (bounds.size() <= options_.chunksPerBatch && bounds.back() < end) {
+            bounds.push_back(std::min(end, bounds.back() + chunkBytes));
+        }
+        return bounds;
+    }
+
+    // CSV chunks end just past a newline so no line is split.
+    const char* data = file_.data();
+    const std::size_t size = file_.size();
+    while (bounds.size() <= options_.chunksPerBatch && bounds.back() < size) {
+        const std::size_t nominal = bounds.back() + options_.chunkBytes;
+        if (nominal >= size) {
+            bounds.push_back(size);
+            break;
+        }
+
+        const void* newline = std::memchr(data + nominal, '\n', size - nominal);
+        bounds.push_back(newline == nullptr ? size : static_cast<std::size_t>(static_cast<const char*>(newline) - data) + 1);
+    }
+    return bounds;
+}
+
+PolylineStream::ParsedChunk PolylineStream::parseBinary(std::size_t begin, std::size_t end) const {
+    ParsedChunk chunk;
+    const std::size_t count = (end - begin) / kBinaryRecordBytes;
+    if (count == 0) {
+        return chunk;
+    }
+    chunk.segments.reserve(count);
+
+    const char* record = file_.data() + begin;
+    Point previous;
+    for (std::size_t i = 0; i < count; ++i, record += kBinaryRecordBytes) {
+        // Records are little-endian like every platform this builds for.
+        Point point;
+        std::memcpy(&point.polyline, record, 4);
+        std::memcpy(&point.position, record + 4, 12);
+        std::memcpy(&point.radius, record + 16, 4);
+        std::memcpy(&point.color, record + 20, 4);
+
+        if (i == 0) {
+            chunk.first = point;
+        } else {
+            connect(previous, point, chunk.segments);
+        }
+        previous = point;
+    }
+
+    chunk.hasPoints = true;
+    chunk.last = previous;
+    return chunk;
+}
+
+PolylineStream::ParsedChunk PolylineStream::parseCsv(std::size_t begin, std::size_t end) const {
+    ParsedChunk chunk;
+    chunk.segments.reserve((end - begin) / 32);
+
+    const char* cursor = file_.data() + begin;
+    const char* const stop = file_.data() + end;
+    Point previous;
+    while (cursor < stop) {
+        const void* newline = std::memchr(cursor, '\n', static_cast<std::size_t>(stop - cursor));
+        const char* lineEnd = newline == nullptr ? stop : static_cast<const char*>(newline);
+        const char* next = newline == nullptr ? stop : lineEnd + 1;
+        if (lineEnd > cursor && lineEnd[-1] == '\r') {
+            --lineEnd;
+        }
+
+        Point point;
+        if (parseCsvLine(cursor, lineEnd, point)) {
+            if (!chunk.hasPoints) {
+                chunk.first = point;
+                chunk.hasPoints = true;
+            } else {
+                connect(previous, point, chunk.segments);
+            }
+            previous = point;
+        }
+        cursor = next;
+    }
+
+    chunk.last = previous;
+    return chunk;
+}
+
+bool PolylineStream::parseCsvLine(const char* begin, const char* end, Point& point) const {
+    const char* cursor = parseField(begin, end, point.polyline);
+    if (cursor == nullptr) {
+        return false;
+    }
+
+    for (int axis = 0; axis < 3; ++axis) {
+        cursor = cursor == end ? nullptr : parseField(cursor, end, point.position[axis]);
+        if (cursor == nullptr) {
+            return false;
+        }
+    }
+
+    // Radius and colour are optional; a malformed tail falls back to the
+    // defaults instead of dropping the point.
+    point.radius = options_.defaultRadius;
+    point.color = options_.defaultColor;
+    float radius = 0.0f;
+    cursor = cursor == end ? nullptr : parseField(cursor, end, radius);
+    if (cursor == nullptr) {
+        return true;
+    }
+    point.radius = radius;
+
+    glm::vec3 color(0.0f);
+    for (int channel = 0; channel < 3 && cursor != nullptr; ++channel) {
+        cursor = cursor == end ? nullptr : parseField(cursor, end, color[channel]);
+    }
+    if (cursor != nullptr) {
+        point.color = TubeNetwork::packColor(color);
+    }
+    return true;
+}
+
+void PolylineStream::connect(const Point& from, const Point& to, std::vector<TubeSegment>& out) {
+    if (from.polyline == to.polyline && from.position != to.position) {
+        out.push_back({from.position, 0.5f * (from.radius + to.radius), to.position, from.color});
+    }
+}
+
+void PolylineStream::publish(std::vector<TubeSegment> segments) {
+    if (segments.empty()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    // A batch larger than the whole budget is still let through once the
+    // queue has drained, otherwise it could never be delivered.
+    spaceAvailable_.wait(lock, [&]() {
+        return stop_ || queuedSegments_ == 0 || queuedSegments_ + segments.size() <= options_.maxQueuedSegments;
+    });
+    if (stop_) {
+        return;
+    }
+
+    segmentsParsed_ += segments.size();
+    queuedSegments_ += segments.size();
+    queue_.push_back(std::move(segments));
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine/MappedFile.h"
+#include "engine/TubeNetwork.h"
+
+// Streams polylines from disk as tube segments. Two formats are accepted:
+//
+// Binary: the 8-byte magic "TUBEPL01" followed by little-endian records of
+//   uint32 polyline, float x, y, z, float radius, uint32 RGBA8 colour.
+// CSV: one point per line, "polyline,x,y,z[,radius[,r,g,b]]" with colour
+//   channels in [0, 1]; blank lines, '#' comments and a header are skipped.
+//
+// Consecutive points sharing a polyline id become one segment. The file is
+// memory mapped and parsed on a background thread in batches of chunks that
+// are split across cores; parsed pages are dropped from memory and at most
+// maxQueuedSegments wait for the render thread, so memory stays bounded no
+// matter how large the file is.
+struct PolylineStreamOptions {
+    std::size_t chunkBytes = 4u * 1024u * 1024u;
+    std::size_t chunksPerBatch = 8;
+    std::size_t maxQueuedSegments = 1u << 20;
+    float defaultRadius = 0.05f;
+    std::uint32_t defaultColor = 0xffb0b0b0u;
+};
+
+class PolylineStream {
+public:
+    PolylineStream() = default;
+    ~PolylineStream();
+
+    // The worker thread refers back to the stream, so it stays in place.
+    PolylineStream(const PolylineStream&) = delete;
+    PolylineStream& operator=(const PolylineStream&) = delete;
+
+    void open(const std::string& path, const PolylineStreamOptions& options = {});
+    void close();
+
+    // Moves up to maxSegments parsed segments into out without blocking and
+    // returns how many were added.
+    std::size_t poll(std::vector<TubeSegment>& out, std::size_t maxSegments);
+
+    [[nodiscard]] bool active() const;
+    [[nodiscard]] bool finished() const;
+    [[nodiscard]] float progress() const;
+    [[nodiscard]] std::size_t segmentsParsed() const;
+
+private:
+    struct Point {
+        std::uint32_t polyline = 0;
+        glm::vec3 position{0.0f};
+        float radius = 0.0f;
+        std::uint32_t color = 0;
+    };
+
+    struct ParsedChunk {
+        std::vector<TubeSegment> segments;
+        bool hasPoints = false;
+        Point first;
+        Point last;
+    };
+
+    void run();
+    [[nodiscard]] std::vector<std::size_t> splitBatch(std::size_t begin) const;
+    [[nodiscard]] ParsedChunk parseBinary(std::size_t begin, std::size_t end) const;
+    [[nodiscard]] ParsedChunk parseCsv(std::size_t begin, std::size_t end) const;
+    [[nodiscard]] bool parseCsvLine(const char* begin, const char* end, Point& point) const;
+    static void connect(const Point& from, const Point& to, std::vector<TubeSegment>& out);
+    void publish(std::vector<TubeSegment> segments);
+
+    MappedFile file_;
+    PolylineStreamOptions options_;
+    bool binary_ = false;
+    std::size_t dataBegin_ = 0;
+
+    std::thread worker_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> done_{false};
+    std::atomic<std::size_t> bytesParsed_{0};
+    std::atomic<std::size_t> segmentsParsed_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable spaceAvailable_;
+    std::deque<std::vector<TubeSegment>> queue_;
+    std::size_t queueHead_ = 0;
+    std::size_t queuedSegments_ = 0;
+};
@@ -0,0 +1,219 @@
+#include "engine/ProgramCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "engine/GlUtil.h"
+#include "engine/MappedFile.h"
+
+namespace {
+
+// ARB_get_program_binary, which glad does not load.
+constexpr GLenum kProgramBinaryRetrievableHint = 0x8257;
+constexpr GLenum kProgramBinaryLength = 0x8741;
+constexpr GLenum kNumProgramBinaryFormats = 0x87FE;
+constexpr GLenum kProgramBinaryFormats = 0x87FF;
+
+constexpr char kMagic[8] = {'T', 'U', 'B', 'E', 'P', 'B', '0', '1'};
+// Magic, source hash, driver string length, binary format, binary length.
+constexpr std::size_t kHeaderBytes = 8 + 8 + 4 + 4 + 4;
+
+std::string glString(GLenum name) {
+    const auto* value = reinterpret_cast<const char*>(glGetString(name));
+    return value != nullptr ? value : "";
+}
+
+// FNV-1a over both sources, with the stage boundary mixed in so moving
+// text from one stage to the other changes the key.
+std::uint64_t hashSources(const std::string& vertexSource, const std::string& fragmentSource) {
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](const std::string& text) {
+        for (const char c : text) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        hash ^= 0xffu;
+        hash *= 1099511628211ull;
+    };
+    mix(vertexSource);
+    mix(fragmentSource);
+    return hash;
+}
+
+template <typename T>
+T readValue(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+void writeValue(std::ofstream& out, const void* value, std::size_t bytes) {
+    out.write(static_cast<const char*>(value), static_cast<std::streamsize>(bytes));
+}
+
+}  // namespace
+
+ProgramCache::ProgramCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+void ProgramCache::initialize(GLADloadfunc load) {
+    getProgramBinary_ = nullptr;
+    programBinary_ = nullptr;
+    programParameteri_ = nullptr;
+    formats_.clear();
+
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    const bool core = major > 4 || (major == 4 && minor >= 1);
+    if (!core && !glutil::hasExtension("GL_ARB_get_program_binary")) {
+        return;
+    }
+    // Drivers may expose the extension while offering no format to save.
+    GLint formats = 0;
+    glGetIntegerv(kNumProgramBinaryFormats, &formats);
+    if (formats <= 0) {
+        return;
+    }
+    std::vector<GLint> supported(static_cast<std::size_t>(formats));
+    glGetIntegerv(kProgramBinaryFormats, supported.data());
+
+    getProgramBinary_ = reinterpret_cast<GetProgramBinary>(load("glGetProgramBinary"));
+    programBinary_ = reinterpret_cast<ProgramBinary>(load("glProgramBinary"));
+    programParameteri_ = reinterpret_cast<ProgramParameteri>(load("glProgramParameteri"));
+    if (getProgramBinary_ == nullptr || programBinary_ == nullptr || programParameteri_ == nullptr) {
+        getProgramBinary_ = nullptr;
+        programBinary_ = nullptr;
+        programParameteri_ = nullptr;
+        return;
+    }
+    formats_.assign(supported.begin(), supported.end());
+    driver_ = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+}
+
+bool ProgramCache::enabled() const {
+    return getProgramBinary_ != nullptr;
+}
+
+GLuint ProgramCache::load(const std::string& vertexSource, const std::string& fragmentSource) const {
+    if (!enabled()) {
+        return 0;
+    }
+
+    const std::uint64_t sourceHash = hashSources(vertexSource, fragmentSource);
+    const std::string path = pathFor(sourceHash);
+    MappedFile file;
+    try {
+        file = MappedFile(path);
+    } catch (const std::runtime_error&) {
+        return 0;
+    }
+
+    const char* data = file.data();
+    const std::size_t size = file.size();
+    if (size < kHeaderBytes || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        return 0;
+    }
+    const auto storedHash = readValue<std::uint64_t>(data + 8);
+    const auto driverLength = readValue<std::uint32_t>(data + 16);
+    const auto format = readValue<std::uint32_t>(data + 20);
+    const auto binaryLength = readValue<std::uint32_t>(data + 24);
+    if (storedHash != sourceHash || size != kHeaderBytes + driverLength + binaryLength || binaryLength == 0 ||
+        driver_.compare(0, std::string::npos, data + kHeaderBytes, driverLength) != 0) {
+        return 0;
+    }
+    // An unknown format would raise GL_INVALID_ENUM rather than just fail
+    // the link, so it never reaches the driver.
+    if (std::find(formats_.begin(), formats_.end(), static_cast<GLenum>(format)) == formats_.end()) {
+        return 0;
+    }
+
+    const GLuint program = glCreateProgram();
+    programBinary_(program, format, data + kHeaderBytes + driverLength, static_cast<GLsizei>(binaryLength));
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::prepare(GLuint program) const {
+    if (enabled()) {
+        programParameteri_(program, kProgramBinaryRetrievableHint, GL_TRUE);
+    }
+}
+
+void ProgramCache::store(GLuint program, const std::string& vertexSource, const std::string& fragmentSource) const {
+    if (!enabled()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, kProgramBinaryLength, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    GLsizei written = 0;
+    GLenum format = 0;
+    getProgramBinary_(program, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        return;
+    }
+
+    // Written aside and renamed, so another instance never maps half a file.
+    const std::uint64_t sourceHash = hashSources(vertexSource, fragmentSource);
+    const std::string path = pathFor(sourceHash);
+    const std::string partial = path + ".tmp";
+    {
+        std::ofstream out(partial, std::ios::binary);
+        if (!out) {
+            return;
+        }
+        const auto driverLength = static_cast<std::uint32_t>(driver_.size());
+        const auto binaryFormat = static_cast<std::uint32_t>(format);
+        const auto binaryLength = static_cast<std::uint32_t>(written);
+        writeValue(out, kMagic, sizeof(kMagic));
+        writeValue(out, &sourceHash, 8);
+        writeValue(out, &driverLength, 4);
+        writeValue(out, &binaryFormat, 4);
+        writeValue(out, &binaryLength, 4);
+        writeValue(out, driver_.data(), driver_.size());
+        writeValue(out, binary.data(), binaryLength);
+        if (!out) {
+            out.close();
+            std::remove(partial.c_str());
+            return;
+        }
+    }
+    std::filesystem::rename(partial, path, error);
+    if (error) {
+        std::remove(partial.c_str());
+    }
+}
+
+std::string ProgramCache::pathFor(std::uint64_t sourceHash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.tpb", static_cast<unsigned long long>(sourceHash));
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+ProgramCache& ProgramCache::shared() {
+    static ProgramCache cache;
+    return cache;
+}
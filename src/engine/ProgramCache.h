@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "app_config.hpp"
+
+// Linked program binaries kept on disk between runs, one file per pair of
+// shader sources. Each file records the hash of the sources and the
+// driver that produced the binary; a file from another driver, or one the
+// driver refuses, is ignored and replaced by the next store(). Every
+// failure is silent, so callers simply compile from source when load()
+// returns 0. Needs GL 4.1 or ARB_get_program_binary, whose entry points
+// glad does not load; without them the cache stays disabled.
+class ProgramCache {
+public:
+    explicit ProgramCache(std::string directory = app::kProgramCacheDirectory);
+
+    ProgramCache(const ProgramCache&) = delete;
+    ProgramCache& operator=(const ProgramCache&) = delete;
+
+    // Call once the context is current.
+    void initialize(GLADloadfunc load);
+    [[nodiscard]] bool enabled() const;
+
+    // A linked program, or 0 when there is no usable binary.
+    [[nodiscard]] GLuint load(const std::string& vertexSource, const std::string& fragmentSource) const;
+    // Call between creating the program and linking it, so the driver
+    // keeps a binary to hand back.
+    void prepare(GLuint program) const;
+    void store(GLuint program, const std::string& vertexSource, const std::string& fragmentSource) const;
+
+    // The cache Shader loads through.
+    static ProgramCache& shared();
+
+private:
+    using GetProgramBinary = void(GLAD_API_PTR*)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+    using ProgramBinary = void(GLAD_API_PTR*)(GLuint, GLenum, const void*, GLsizei);
+    using ProgramParameteri = void(GLAD_API_PTR*)(GLuint, GLenum, GLint);
+
+    [[nodiscard]] std::string pathFor(std::uint64_t sourceHash) const;
+
+    std::string directory_;
+    // Vendor, renderer and version, which together name the driver build.
+    std::string driver_;
+    // Binary formats the driver accepts.
+    std::vector<GLenum> formats_;
+    GetProgramBinary getProgramBinary_ = nullptr;
+    ProgramBinary programBinary_ = nullptr;
+    ProgramParameteri programParameteri_ = nullptr;
+};
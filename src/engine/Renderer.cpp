@@ -1,38 +1,326 @@
 #include "engine/Renderer.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "app_config.hpp"
+#include "engine/ShaderManager.h"
+
+namespace {
+
+constexpr float kImpostorQuadVertices[] = {
+    -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+     1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,
+     1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,
+    -1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+};
+
+constexpr unsigned int kImpostorQuadIndices[] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+}  // namespace
+
 void Renderer::initialize() {
-    objectShader_ = Shader("shaders/object_vertex.glsl", "shaders/object_fragment.glsl");
-    lightShader_ = Shader("shaders/vertex.glsl", "shaders/fragment.glsl");
+    // Each sampler type gets its own unit, even when scalars are unused.
+    ShaderManager& shaders = ShaderManager::shared();
+    shaders.load(
+        objectShader_,
+        "shaders/object_vertex.glsl",
+        "shaders/object_fragment.glsl",
+        [](const Shader& shader) {
+            shader.setInt("texture1", 0);
+            shader.setInt("scalars", 1);
+            shader.setInt("colormap", 2);
+            shader.setInt("materialArray", 3);
+        }
+    );
+    shaders.load(lightShader_, "shaders/vertex.glsl", "shaders/fragment.glsl");
+    shaders.load(networkShader_, "shaders/tube_instance_vertex.glsl", "shaders/tube_instance_fragment.glsl");
+    shaders.load(impostorShader_, "shaders/tube_impostor_vertex.glsl", "shaders/tube_impostor_fragment.glsl");
+    shaders.load(lineShader_, "shaders/tube_line_vertex.glsl", "shaders/tube_line_fragment.glsl");
+    shaders.load(impostorBakeShader_, "shaders/impostor_bake_vertex.glsl", "shaders/impostor_bake_fragment.glsl");
+    shaders.load(
+        objectImpostorShader_,
+        "shaders/object_impostor_vertex.glsl",
+        "shaders/object_impostor_fragment.glsl",
+        [](const Shader& shader) {
+            shader.setInt("atlasColor", 0);
+            shader.setInt("atlasNormalDepth", 1);
+        }
+    );
+    shaders.load(
+        terrainShader_,
+        "shaders/terrain_vertex.glsl",
+        "shaders/object_fragment.glsl",
+        [](const Shader& shader) {
+            shader.setInt("texture1", 0);
+            shader.setInt("heights", 1);
+            shader.setInt("materialArray", 3);
+            shader.setInt("pageTable", 4);
+            shader.setInt("pageAtlas", 5);
+            shader.setInt("scalarMode", 0);
+        }
+    );
+    shaders.load(
+        terrainFeedbackShader_,
+        "shaders/terrain_vertex.glsl",
+        "shaders/virtual_feedback_fragment.glsl",
+        [](const Shader& shader) {
+            shader.setInt("heights", 1);
+            shader.setFloat("feedbackLodBias", std::log2(static_cast<float>(app::kVirtualFeedbackDivisor)));
+        }
+    );
+    impostorQuad_ = Mesh::createFromRaw(
+        kImpostorQuadVertices,
+        sizeof(kImpostorQuadVertices),
+        kImpostorQuadIndices,
+        sizeof(kImpostorQuadIndices),
+        false
+    );
+
+    materials_.initialize(app::kMaterialArrayLayers);
 }
 
 void Renderer::renderScene(
     const Camera& camera,
     const GameObject& tube,
-    const GameObject& ground,
-    const GameObject& lightSphere
+    const GameObject& lightSphere,
+    float timeSeconds
 ) {
+    timeSeconds_ = timeSeconds;
+
+    // Packing may replace arrays, so nothing bound before is trusted.
+    materials_.request(tube.texture);
+    materials_.update(app::kMaterialPacksPerFrame);
+    boundMaterialArray_ = 0;
+
     drawTexturedObject(objectShader_, camera, tube, lightSphere.position);
-    drawTexturedObject(objectShader_, camera, ground, lightSphere.position);
     drawLightObject(camera, lightSphere);
 }
 
-void Renderer::drawTexturedObject(
-    const Shader& shader,
+void Renderer::renderObjects(
+    const Camera& camera,
+    const std::vector<GameObject>& objects,
+    const glm::vec3& lightPos
+) {
+    std::vector<const GameObject*> order;
+    order.reserve(objects.size());
+    for (const GameObject& object : objects) {
+        materials_.request(object.texture);
+        order.push_back(&object);
+    }
+    std::stable_sort(order.begin(), order.end(), [this](const GameObject* a, const GameObject* b) {
+        return materials_.find(a->texture.get()).array < materials_.find(b->texture.get()).array;
+    });
+
+    for (const GameObject* object : order) {
+        drawTexturedObject(objectShader_, camera, *object, lightPos);
+    }
+}
+
+void Renderer::renderTerrain(
+    const Camera& camera,
+    const Terrain& terrain,
+    const Texture& texture,
+    const glm::vec3& lightPos,
+    const VirtualTexture* virtualTexture
+) const {
+    applyObjectUniforms(terrainShader_, camera, glm::mat4(1.0f), lightPos);
+    applyCullMode(CullMode::Back);
+    const bool useVirtualTexture = virtualTexture != nullptr && virtualTexture->opened();
+    terrainShader_.setBool("useVirtualTexture", useVirtualTexture);
+    if (useVirtualTexture) {
+        applyVirtualGround(terrainShader_, *virtualTexture);
+    } else {
+        terrainShader_.setFloat("texCoordScale", app::kGroundTexCoordScale);
+        terrainShader_.setVec2("texCoordOffset", glm::vec2(0.0f));
+        texture.bind(GL_TEXTURE0);
+    }
+    terrain.draw(terrainShader_, GL_TEXTURE1);
+}
+
+void Renderer::renderTerrainFeedback(
+    const Camera& camera,
+    const Terrain& terrain,
+    VirtualTexture& virtualTexture
+) const {
+    if (!virtualTexture.opened()) {
+        return;
+    }
+
+    virtualTexture.beginFeedback();
+    applyObjectUniforms(terrainFeedbackShader_, camera, glm::mat4(1.0f), glm::vec3(0.0f));
+    applyCullMode(CullMode::Back);
+    applyVirtualGround(terrainFeedbackShader_, virtualTexture);
+    terrain.draw(terrainFeedbackShader_, GL_TEXTURE1);
+    virtualTexture.endFeedback();
+}
+
+void Renderer::renderSweptTube(
+    const Camera& camera,
+    const AdaptiveTube& tube,
+    const Texture& texture,
+    const glm::vec3& lightPos,
+    const ScalarField* scalars
+) const {
+    const Frustum frustum = beginTubePass(camera, texture, lightPos);
+    if (scalars == nullptr || !scalars->ready()) {
+        tube.draw(frustum, camera.position());
+        return;
+    }
+
+    scalars->bind(GL_TEXTURE1, GL_TEXTURE2);
+    objectShader_.setInt("scalarMode", 2);
+    objectShader_.setVec2("scalarRange", glm::vec2(scalars->minValue(), scalars->maxValue()));
+    tube.draw(frustum, camera.position(), [this](std::size_t firstRing, int ringSize) {
+        objectShader_.setInt("scalarOffset", static_cast<int>(firstRing));
+        objectShader_.setInt("scalarRingSize", ringSize);
+    });
+    objectShader_.setInt("scalarMode", 0);
+}
+
+void Renderer::renderTubeNetwork(
     const Camera& camera,
+    TubeNetwork& network,
+    const TubeLodPolicy& policy,
+    const glm::vec3& lightPos
+) const {
+    network.selectLods(camera, Frustum(camera.projectionMatrix() * camera.viewMatrix()), policy);
+
+    applyObjectUniforms(networkShader_, camera, glm::mat4(1.0f), lightPos);
+    applyCullMode(CullMode::Back);
+    network.draw(TubeLod::Geometry);
+
+    // Proxy boxes keep only their far faces: one ray per covered pixel, and
+    // the tube stays visible when the camera is inside the box.
+    applyObjectUniforms(impostorShader_, camera, glm::mat4(1.0f), lightPos);
+    applyCullMode(CullMode::Front);
+    network.draw(TubeLod::Impostor);
+    network.drawAggregates();
+
+    applyObjectUniforms(lineShader_, camera, glm::mat4(1.0f), lightPos);
+    applyCullMode(CullMode::None);
+    lineShader_.setFloat("pixelsPerUnit", camera.pixelsPerUnit(1.0f));
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    network.draw(TubeLod::Lines);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
+
+void Renderer::bakeImpostor(
     const GameObject& object,
+    ImpostorAtlas& atlas,
+    const ImpostorAtlasOptions& options
+) const {
+    atlas.bake(*object.mesh, *object.texture, impostorBakeShader_, options);
+}
+
+Frustum Renderer::beginTubePass(
+    const Camera& camera,
+    const Texture& texture,
+    const glm::vec3& lightPos
+) const {
+    applyObjectUniforms(objectShader_, camera, glm::mat4(1.0f), lightPos);
+    applyDeformation(objectShader_, TubeDeformation{});
+    objectShader_.setInt("scalarMode", 0);
+    objectShader_.setBool("useMaterialArray", false);
+    applyCullMode(CullMode::Back);
+    texture.bind(GL_TEXTURE0);
+    return Frustum(camera.projectionMatrix() * camera.viewMatrix());
+}
+
+void Renderer::applyObjectUniforms(
+    const Shader& shader,
+    const Camera& camera,
+    const glm::mat4& model,
     const glm::vec3& lightPos
 ) const {
     shader.use();
-    shader.setMat4("model", object.modelMatrix());
+    shader.setMat4("model", model);
     shader.setMat4("view", camera.viewMatrix());
     shader.setMat4("projection", camera.projectionMatrix());
     shader.setVec3("lightPos", lightPos);
     shader.setVec3("viewPos", camera.position());
-    object.texture.bind(GL_TEXTURE0);
-    shader.setInt("texture1", 0);
-    object.mesh.draw();
+}
+
+void Renderer::applyDeformation(const Shader& shader, const TubeDeformation& deformation) const {
+    shader.setBool("deformation.enabled", deformation.enabled);
+    if (!deformation.enabled) {
+        return;
+    }
+
+    shader.setFloat("deformation.time", timeSeconds_);
+    shader.setFloat("deformation.pulseAmplitude", deformation.pulseAmplitude);
+    shader.setFloat("deformation.pulseWavelength", deformation.pulseWavelength);
+    shader.setFloat("deformation.pulseSpeed", deformation.pulseSpeed);
+    shader.setFloat("deformation.bendCurvature", deformation.bendCurvature);
+    shader.setFloat("deformation.twistRate", deformation.twistRate);
+}
+
+void Renderer::drawTexturedObject(
+    const Shader& shader,
+    const Camera& camera,
+    const GameObject& object,
+    const glm::vec3& lightPos
+) {
+    // Same screen-space test as the procedural tubes: the simplification
+    // error, projected at the nearest point of the bounds, must stay within
+    // the pixel budget.
+    const glm::mat4 model = object.modelMatrix();
+    const float scale = std::max({object.scale.x, object.scale.y, object.scale.z});
+    const float radius = object.mesh->boundingRadius() * scale;
+    const glm::vec3 center(model * glm::vec4(object.mesh->boundingCenter(), 1.0f));
+    const float distance = std::max(0.0f, glm::length(camera.position() - center) - radius);
+    const float pixelsPerUnit = camera.pixelsPerUnit(distance);
+
+    if (object.impostor != nullptr && object.impostor->baked() && !object.deformation.enabled
+        && radius * pixelsPerUnit < app::kImpostorPixels) {
+        drawImpostor(camera, object, lightPos);
+        return;
+    }
+
+    applyObjectUniforms(shader, camera, model, lightPos);
+    applyDeformation(shader, object.deformation);
+    shader.setInt("scalarMode", 0);
+    applyCullMode(object.cullMode);
+    const MaterialArrays::Slot slot = materials_.find(object.texture.get());
+    shader.setBool("useMaterialArray", slot.array != 0);
+    if (slot.array != 0) {
+        shader.setInt("materialLayer", slot.layer);
+        if (slot.array != boundMaterialArray_) {
+            glActiveTexture(GL_TEXTURE3);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, slot.array);
+            boundMaterialArray_ = slot.array;
+        }
+    } else if (object.texture != nullptr) {
+        object.texture->bind(GL_TEXTURE0);
+    } else {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    object.mesh->selectLod(pixelsPerUnit * scale, app::kLodPixelError).draw();
+}
+
+void Renderer::drawImpostor(
+    const Camera& camera,
+    const GameObject& object,
+    const glm::vec3& lightPos
+) const {
+    const ImpostorAtlas& atlas = *object.impostor;
+    applyObjectUniforms(objectImpostorShader_, camera, object.modelMatrix(), lightPos);
+    objectImpostorShader_.setVec3("boundsCenter", atlas.center());
+    objectImpostorShader_.setFloat("boundsRadius", atlas.radius());
+    objectImpostorShader_.setInt("framesPerSide", atlas.framesPerSide());
+    objectImpostorShader_.setBool("hemisphere", atlas.hemisphere());
+    applyCullMode(CullMode::None);
+    atlas.bind(GL_TEXTURE0, GL_TEXTURE1);
+    impostorQuad_.draw();
 }
 
 void Renderer::drawLightObject(const Camera& camera, const GameObject& lightSphere) const {
@@ -41,5 +329,25 @@ void Renderer::drawLightObject(const Camera& camera, const GameObject& lightSphe
     lightShader_.setMat4("view", camera.viewMatrix());
     lightShader_.setMat4("projection", camera.projectionMatrix());
     lightShader_.setVec3("lightColor", glm::vec3(1.0f, 0.72f, 0.2f));
-    lightSphere.mesh.draw();
+    applyCullMode(lightSphere.cullMode);
+    lightSphere.mesh->draw();
+}
+
+void Renderer::applyVirtualGround(const Shader& shader, const VirtualTexture& virtualTexture) const {
+    // The image is centred on the origin, kVirtualGroundTexelSpacing world
+    // units per texel, like a heightmap of the same size.
+    const float worldSize = static_cast<float>(virtualTexture.virtualSize()) * app::kVirtualGroundTexelSpacing;
+    shader.setFloat("texCoordScale", 1.0f / worldSize);
+    shader.setVec2("texCoordOffset", 0.5f * virtualTexture.imageExtent());
+    virtualTexture.bind(shader, GL_TEXTURE4, GL_TEXTURE5);
+}
+
+void Renderer::applyCullMode(CullMode mode) const {
+    if (mode == CullMode::None) {
+        glDisable(GL_CULL_FACE);
+        return;
+    }
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(mode == CullMode::Back ? GL_BACK : GL_FRONT);
 }
@@ -1,8 +1,19 @@
 #pragma once
 
+#include "engine/AdaptiveTube.h"
 #include "engine/Camera.h"
+#include <vector>
+
+#include "engine/Frustum.h"
+#include "engine/ScalarField.h"
 #include "engine/GameObject.h"
+#include "engine/ImpostorAtlas.h"
+#include "engine/MaterialArrays.h"
 #include "engine/Shader.h"
+#include "engine/Terrain.h"
+#include "engine/Texture.h"
+#include "engine/TubeNetwork.h"
+#include "engine/VirtualTexture.h"
 
 class Renderer {
 public:
@@ -10,19 +21,95 @@ public:
     void renderScene(
         const Camera& camera,
         const GameObject& tube,
-        const GameObject& ground,
-        const GameObject& lightSphere
+        const GameObject& lightSphere,
+        float timeSeconds
+    );
+    // Objects whose textures are packed into material arrays are drawn
+    // grouped by array.
+    void renderObjects(
+        const Camera& camera,
+        const std::vector<GameObject>& objects,
+        const glm::vec3& lightPos
     );
+    // With an opened virtual texture the ground samples it, centred on the
+    // origin, instead of tiling texture.
+    void renderTerrain(
+        const Camera& camera,
+        const Terrain& terrain,
+        const Texture& texture,
+        const glm::vec3& lightPos,
+        const VirtualTexture* virtualTexture = nullptr
+    ) const;
+    // Renders the pages of virtualTexture the terrain needs into its
+    // feedback target. The terrain is the only surface sampling it; another
+    // one would have to be drawn here too, or its pages are never asked for.
+    void renderTerrainFeedback(
+        const Camera& camera,
+        const Terrain& terrain,
+        VirtualTexture& virtualTexture
+    ) const;
+    void renderSweptTube(
+        const Camera& camera,
+        const AdaptiveTube& tube,
+        const Texture& texture,
+        const glm::vec3& lightPos,
+        const ScalarField* scalars = nullptr
+    ) const;
+    void renderTubeNetwork(
+        const Camera& camera,
+        TubeNetwork& network,
+        const TubeLodPolicy& policy,
+        const glm::vec3& lightPos
+    ) const;
+
+    // Bakes the object's undeformed mesh and texture into atlas.
+    void bakeImpostor(
+        const GameObject& object,
+        ImpostorAtlas& atlas,
+        const ImpostorAtlasOptions& options = {}
+    ) const;
 
 private:
+    [[nodiscard]] Frustum beginTubePass(
+        const Camera& camera,
+        const Texture& texture,
+        const glm::vec3& lightPos
+    ) const;
+    void applyObjectUniforms(
+        const Shader& shader,
+        const Camera& camera,
+        const glm::mat4& model,
+        const glm::vec3& lightPos
+    ) const;
+    void applyDeformation(const Shader& shader, const TubeDeformation& deformation) const;
     void drawTexturedObject(
         const Shader& shader,
         const Camera& camera,
         const GameObject& object,
         const glm::vec3& lightPos
+    );
+    void drawImpostor(
+        const Camera& camera,
+        const GameObject& object,
+        const glm::vec3& lightPos
     ) const;
     void drawLightObject(const Camera& camera, const GameObject& lightSphere) const;
+    void applyVirtualGround(const Shader& shader, const VirtualTexture& virtualTexture) const;
+    void applyCullMode(CullMode mode) const;
+
+    float timeSeconds_ = 0.0f;
 
     Shader objectShader_;
     Shader lightShader_;
+    Shader networkShader_;
+    Shader impostorShader_;
+    Shader lineShader_;
+    Shader impostorBakeShader_;
+    Shader objectImpostorShader_;
+    Shader terrainShader_;
+    Shader terrainFeedbackShader_;
+    Mesh impostorQuad_;
+    MaterialArrays materials_;
+    // Array on GL_TEXTURE3 since the last materials_.update().
+    GLuint boundMaterialArray_ = 0;
 };
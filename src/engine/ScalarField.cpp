@@ -0,0 +1,193 @@
+#include "engine/ScalarField.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+constexpr int kColormapSize = 256;
+
+// Viridis sampled at five stops; intermediate texels are linear blends.
+GLuint createColormap() {
+    constexpr float kStops[][3] = {
+        {0.267f, 0.005f, 0.329f},
+        {0.229f, 0.322f, 0.546f},
+        {0.128f, 0.567f, 0.551f},
+        {0.369f, 0.789f, 0.383f},
+        {0.993f, 0.906f, 0.144f},
+    };
+    constexpr int kLastStop = static_cast<int>(sizeof(kStops) / sizeof(kStops[0])) - 1;
+
+    unsigned char texels[kColormapSize * 3];
+    for (int i = 0; i < kColormapSize; ++i) {
+        const float position = static_cast<float>(i) / static_cast<float>(kColormapSize - 1) * kLastStop;
+        const int stop = std::min(static_cast<int>(position), kLastStop - 1);
+        const float t = position - static_cast<float>(stop);
+
+        for (int channel = 0; channel < 3; ++channel) {
+            const float value = kStops[stop][channel] + (kStops[stop + 1][channel] - kStops[stop][channel]) * t;
+            texels[i * 3 + channel] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+        }
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, kColormapSize, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return texture;
+}
+
+}  // namespace
+
+ScalarField::~ScalarField() {
+    release();
+}
+
+ScalarField::ScalarField(ScalarField&& other) noexcept
+    : buffers_(other.buffers_),
+      textures_(other.textures_),
+      colormap_(other.colormap_),
+      front_(other.front_),
+      valueCount_(other.valueCount_),
+      minValue_(other.minValue_),
+      maxValue_(other.maxValue_),
+      hasFront_(other.hasFront_),
+      timesteps_(std::move(other.timesteps_)) {
+    other.buffers_ = {};
+    other.textures_ = {};
+    other.colormap_ = 0;
+    other.valueCount_ = 0;
+    other.hasFront_ = false;
+}
+
+ScalarField& ScalarField::operator=(ScalarField&& other) noexcept {
+    if (this != &other) {
+        release();
+        buffers_ = other.buffers_;
+        textures_ = other.textures_;
+        colormap_ = other.colormap_;
+        front_ = other.front_;
+        valueCount_ = other.valueCount_;
+        minValue_ = other.minValue_;
+        maxValue_ = other.maxValue_;
+        hasFront_ = other.hasFront_;
+        timesteps_ = std::move(other.timesteps_);
+
+        other.buffers_ = {};
+        other.textures_ = {};
+        other.colormap_ = 0;
+        other.valueCount_ = 0;
+        other.hasFront_ = false;
+    }
+    return *this;
+}
+
+void ScalarField::initialize(std::size_t valueCount, float minValue, float maxValue) {
+    release();
+
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if (static_cast<std::size_t>(maxTexels) < valueCount) {
+        std::cerr << "Campo escalar excede GL_MAX_TEXTURE_BUFFER_SIZE: " << valueCount << " > " << maxTexels << '\n';
+    }
+
+    valueCount_ = valueCount;
+    setRange(minValue, maxValue);
+
+    glGenBuffers(2, buffers_.data());
+    glGenTextures(2, textures_.data());
+    for (std::size_t i = 0; i < 2; ++i) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers_[i]);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(valueCount * sizeof(float)), nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, textures_[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, buffers_[i]);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    colormap_ = createColormap();
+}
+
+void ScalarField::setRange(float minValue, float maxValue) {
+    minValue_ = minValue;
+    maxValue_ = maxValue > minValue ? maxValue : minValue + 1.0f;
+}
+
+void ScalarField::submit(std::vector<float> values) {
+    values.resize(std::min(values.size(), valueCount_));
+    timesteps_.submit(std::move(values));
+}
+
+void ScalarField::pump(std::size_t budgetBytes) {
+    const ScalarTimesteps::Slice slice = timesteps_.next(budgetBytes / sizeof(float));
+    if (slice.count == 0) {
+        return;
+    }
+
+    const std::size_t back = 1 - front_;
+    glBindBuffer(GL_TEXTURE_BUFFER, buffers_[back]);
+    glBufferSubData(
+        GL_TEXTURE_BUFFER,
+        static_cast<GLintptr>(slice.offset * sizeof(float)),
+        static_cast<GLsizeiptr>(slice.count * sizeof(float)),
+        slice.values
+    );
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    if (timesteps_.advance(slice.count)) {
+        front_ = back;
+        hasFront_ = true;
+    }
+}
+
+void ScalarField::bind(GLenum valuesUnit, GLenum colormapUnit) const {
+    glActiveTexture(valuesUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, textures_[front_]);
+    glActiveTexture(colormapUnit);
+    glBindTexture(GL_TEXTURE_2D, colormap_);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+bool ScalarField::ready() const {
+    return hasFront_;
+}
+
+bool ScalarField::uploading() const {
+    return timesteps_.busy();
+}
+
+std::size_t ScalarField::valueCount() const {
+    return valueCount_;
+}
+
+float ScalarField::minValue() const {
+    return minValue_;
+}
+
+float ScalarField::maxValue() const {
+    return maxValue_;
+}
+
+void ScalarField::release() {
+    if (buffers_[0] != 0) {
+        glDeleteBuffers(2, buffers_.data());
+        buffers_ = {};
+    }
+    if (textures_[0] != 0) {
+        glDeleteTextures(2, textures_.data());
+        textures_ = {};
+    }
+    if (colormap_ != 0) {
+        glDeleteTextures(1, &colormap_);
+        colormap_ = 0;
+    }
+    hasFront_ = false;
+    timesteps_.clear();
+}
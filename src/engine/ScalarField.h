@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "engine/ScalarTimesteps.h"
+
+// Per-vertex or per-ring scalars kept in a pair of texture buffer objects.
+// The renderer samples the front buffer while new timesteps are streamed
+// into the back one in slices; the two swap once a timestep is complete, so
+// geometry is never re-uploaded. Timesteps submitted while one is uploading
+// wait behind it, newest only (see ScalarTimesteps).
+class ScalarField {
+public:
+    ScalarField() = default;
+    ~ScalarField();
+
+    ScalarField(const ScalarField&) = delete;
+    ScalarField& operator=(const ScalarField&) = delete;
+    ScalarField(ScalarField&& other) noexcept;
+    ScalarField& operator=(ScalarField&& other) noexcept;
+
+    void initialize(std::size_t valueCount, float minValue, float maxValue);
+    void setRange(float minValue, float maxValue);
+
+    // Queues values after the timestep in flight, replacing any that was
+    // waiting. Only the first valueCount values are used.
+    void submit(std::vector<float> values);
+    // Uploads at most budgetBytes of the pending timestep.
+    void pump(std::size_t budgetBytes);
+
+    void bind(GLenum valuesUnit, GLenum colormapUnit) const;
+
+    [[nodiscard]] bool ready() const;
+    [[nodiscard]] bool uploading() const;
+    [[nodiscard]] std::size_t valueCount() const;
+    [[nodiscard]] float minValue() const;
+    [[nodiscard]] float maxValue() const;
+
+private:
+    void release();
+
+    std::array<GLuint, 2> buffers_{};
+    std::array<GLuint, 2> textures_{};
+    GLuint colormap_ = 0;
+    std::size_t front_ = 0;
+    std::size_t valueCount_ = 0;
+    float minValue_ = 0.0f;
+    float maxValue_ = 1.0f;
+    bool hasFront_ = false;
+
+    ScalarTimesteps timesteps_;
+};
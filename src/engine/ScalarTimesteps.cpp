@@ -0,0 +1,45 @@
+#include "engine/ScalarTimesteps.h"
+
+#include <algorithm>
+#include <utility>
+
+void ScalarTimesteps::submit(std::vector<float> values) {
+    if (values.empty()) {
+        return;
+    }
+    if (current_.empty()) {
+        current_ = std::move(values);
+        uploaded_ = 0;
+        return;
+    }
+    newest_ = std::move(values);
+}
+
+ScalarTimesteps::Slice ScalarTimesteps::next(std::size_t maxCount) {
+    if (current_.empty()) {
+        return {};
+    }
+    return {uploaded_, std::min(current_.size() - uploaded_, std::max<std::size_t>(1, maxCount)), current_.data() + uploaded_};
+}
+
+bool ScalarTimesteps::advance(std::size_t count) {
+    uploaded_ = std::min(uploaded_ + count, current_.size());
+    if (current_.empty() || uploaded_ < current_.size()) {
+        return false;
+    }
+
+    current_ = std::move(newest_);
+    newest_.clear();
+    uploaded_ = 0;
+    return true;
+}
+
+void ScalarTimesteps::clear() {
+    current_.clear();
+    newest_.clear();
+    uploaded_ = 0;
+}
+
+bool ScalarTimesteps::busy() const {
+    return !current_.empty();
+}
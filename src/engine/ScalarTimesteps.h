@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Timesteps waiting to be uploaded, kept apart from the GL buffers so the
+// scheduling can be tested on its own. The timestep in flight is kept until
+// all of it is uploaded; of those submitted meanwhile only the newest is
+// kept, and it starts once the current one completes. A producer faster
+// than the upload therefore skips timesteps instead of starving the swap.
+class ScalarTimesteps {
+public:
+    struct Slice {
+        std::size_t offset = 0;
+        std::size_t count = 0;
+        const float* values = nullptr;
+    };
+
+    // Empty timesteps are ignored.
+    void submit(std::vector<float> values);
+    // The next at most maxCount values of the timestep in flight, or an
+    // empty slice when there is none.
+    [[nodiscard]] Slice next(std::size_t maxCount);
+    // Marks count values of the slice from next() as uploaded; returns true
+    // when that completes the timestep.
+    bool advance(std::size_t count);
+    void clear();
+
+    [[nodiscard]] bool busy() const;
+
+private:
+    std::vector<float> current_;
+    std::vector<float> newest_;
+    std::size_t uploaded_ = 0;
+};
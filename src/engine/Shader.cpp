@@ -1,41 +1,45 @@
 #include "engine/Shader.h"
 
-#include <fstream>
-#include <sstream>
 #include <stdexcept>
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include "engine/GlUtil.h"
+#include "engine/ProgramCache.h"
+
 namespace {
 
-std::string readTextFile(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        throw std::runtime_error("Nao foi possivel abrir o arquivo: " + path);
+GLuint compileShader(GLenum type, const std::string& source) {
+    const GLuint shader = glutil::issueShader(type, source);
+    const std::string error = glutil::shaderError(shader);
+    if (error.empty()) {
+        return shader;
     }
 
-    std::ostringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    glDeleteShader(shader);
+    throw std::runtime_error(error);
 }
 
-GLuint compileShader(GLenum type, const std::string& source) {
-    const char* shaderSource = source.c_str();
-    const GLuint shader = glCreateShader(type);
+GLuint linkProgram(const std::string& vertexSource, const std::string& fragmentSource) {
+    const GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    const GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    const GLuint program = glCreateProgram();
 
-    glShaderSource(shader, 1, &shaderSource, nullptr);
-    glCompileShader(shader);
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    ProgramCache::shared().prepare(program);
+    glLinkProgram(program);
 
-    GLint success = GL_FALSE;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (success == GL_TRUE) {
-        return shader;
-    }
+    const std::string error = glutil::programError(program);
 
-    char log[512];
-    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
-    glDeleteShader(shader);
-    throw std::runtime_error(std::string("Erro ao compilar shader:\n") + log);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    if (!error.empty()) {
+        glDeleteProgram(program);
+        throw std::runtime_error(error);
+    }
+    return program;
 }
 
 }  // namespace
@@ -66,31 +70,21 @@ Shader& Shader::operator=(Shader&& other) noexcept {
 }
 
 void Shader::loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath) {
-    const std::string vertexSource = readTextFile(vertexPath);
-    const std::string fragmentSource = readTextFile(fragmentPath);
-
-    const GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
-    const GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
-    const GLuint program = glCreateProgram();
-
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-
-    GLint success = GL_FALSE;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    if (success != GL_TRUE) {
-        char log[512];
-        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
-        glDeleteProgram(program);
-        throw std::runtime_error(std::string("Erro ao linkar programa:\n") + log);
+    const std::string vertexSource = glutil::readTextFile(vertexPath);
+    const std::string fragmentSource = glutil::readTextFile(fragmentPath);
+
+    const ProgramCache& cache = ProgramCache::shared();
+    GLuint program = cache.load(vertexSource, fragmentSource);
+    if (program == 0) {
+        program = linkProgram(vertexSource, fragmentSource);
+        cache.store(program, vertexSource, fragmentSource);
     }
 
-    if (program_ != 0) {
+    adopt(program);
+}
+
+void Shader::adopt(GLuint program) {
+    if (program_ != 0 && program_ != program) {
         glDeleteProgram(program_);
     }
 
@@ -105,6 +99,10 @@ void Shader::setMat4(const std::string& name, const glm::mat4& value) const {
     glUniformMatrix4fv(glGetUniformLocation(program_, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
 }
 
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
+    glUniform2fv(glGetUniformLocation(program_, name.c_str()), 1, glm::value_ptr(value));
+}
+
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
     glUniform3fv(glGetUniformLocation(program_, name.c_str()), 1, glm::value_ptr(value));
 }
@@ -112,3 +110,11 @@ void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
 void Shader::setInt(const std::string& name, int value) const {
     glUniform1i(glGetUniformLocation(program_, name.c_str()), value);
 }
+
+void Shader::setFloat(const std::string& name, float value) const {
+    glUniform1f(glGetUniformLocation(program_, name.c_str()), value);
+}
+
+void Shader::setBool(const std::string& name, bool value) const {
+    glUniform1i(glGetUniformLocation(program_, name.c_str()), value ? 1 : 0);
+}
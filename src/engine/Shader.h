@@ -18,10 +18,15 @@ public:
     Shader& operator=(Shader&& other) noexcept;
 
     void loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath);
+    // Takes ownership of a linked program, deleting the current one.
+    void adopt(GLuint program);
     void use() const;
     void setMat4(const std::string& name, const glm::mat4& value) const;
+    void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
     void setInt(const std::string& name, int value) const;
+    void setFloat(const std::string& name, float value) const;
+    void setBool(const std::string& name, bool value) const;
 
 private:
     GLuint program_ = 0;
@@ -0,0 +1,244 @@
+#include "engine/ShaderManager.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "engine/GlUtil.h"
+#include "engine/ProgramCache.h"
+
+namespace {
+
+// KHR_parallel_shader_compile, which glad does not load.
+constexpr GLenum kCompletionStatus = 0x91B1;
+constexpr GLuint kDriverChoosesThreads = 0xFFFFFFFFu;
+
+// Without a trailing separator, so "shaders/" matches "shaders".
+std::string normalDirectory(const std::string& path) {
+    const std::filesystem::path normal = std::filesystem::path(path).lexically_normal();
+    return (normal.has_filename() ? normal : normal.parent_path()).string();
+}
+
+}  // namespace
+
+ShaderManager::~ShaderManager() {
+#ifdef __linux__
+    if (inotify_ >= 0) {
+        close(inotify_);
+    }
+#endif
+}
+
+void ShaderManager::initialize(GLADloadfunc load, const std::string& directory) {
+    directory_ = normalDirectory(directory);
+
+    parallelCompile_ = false;
+    auto maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(load("glMaxShaderCompilerThreadsKHR"));
+    if (maxThreads == nullptr) {
+        maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(load("glMaxShaderCompilerThreadsARB"));
+    }
+    if (maxThreads != nullptr &&
+        (glutil::hasExtension("GL_KHR_parallel_shader_compile") || glutil::hasExtension("GL_ARB_parallel_shader_compile"))) {
+        maxThreads(kDriverChoosesThreads);
+        parallelCompile_ = true;
+    }
+
+#ifdef __linux__
+    if (inotify_ < 0) {
+        inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+    if (inotify_ >= 0) {
+        if (watch_ >= 0) {
+            inotify_rm_watch(inotify_, watch_);
+        }
+        // Editors either rewrite the file or rename a new one over it.
+        watch_ = inotify_add_watch(inotify_, directory_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch_ < 0) {
+            std::cerr << "Nao foi possivel observar os shaders em: " << directory_ << '\n';
+        }
+    }
+#endif
+}
+
+void ShaderManager::load(Shader& shader, const std::string& vertexPath, const std::string& fragmentPath, Setup setup) {
+    auto found = std::find_if(entries_.begin(), entries_.end(), [&shader](const Entry& entry) {
+        return entry.shader == &shader;
+    });
+    if (found == entries_.end()) {
+        entries_.push_back({});
+        found = std::prev(entries_.end());
+        found->shader = &shader;
+    }
+    found->vertexPath = vertexPath;
+    found->fragmentPath = fragmentPath;
+    found->setup = std::move(setup);
+    start(*found);
+}
+
+void ShaderManager::finish() {
+    for (Entry& entry : entries_) {
+        if (entry.build.program == 0) {
+            continue;
+        }
+        while (parallelCompile_ && !done(entry.build)) {
+            std::this_thread::yield();
+        }
+        const std::string error = collect(entry);
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+}
+
+void ShaderManager::update() {
+    drainEvents();
+
+    for (Entry& entry : entries_) {
+        if (entry.build.program != 0) {
+            ++entry.build.age;
+            if (!done(entry.build)) {
+                continue;
+            }
+            const std::string error = collect(entry);
+            if (!error.empty()) {
+                std::cerr << entry.vertexPath << " + " << entry.fragmentPath << ":\n" << error << '\n';
+            }
+        }
+        if (entry.stale) {
+            try {
+                start(entry);
+            } catch (const std::runtime_error& error) {
+                // Saved mid-rename; the next event retries.
+                std::cerr << error.what() << '\n';
+                entry.stale = false;
+            }
+        }
+    }
+}
+
+bool ShaderManager::parallelCompile() const {
+    return parallelCompile_;
+}
+
+bool ShaderManager::watching() const {
+    return watch_ >= 0;
+}
+
+void ShaderManager::start(Entry& entry) {
+    std::string vertexSource = glutil::readTextFile(entry.vertexPath);
+    std::string fragmentSource = glutil::readTextFile(entry.fragmentPath);
+    entry.stale = false;
+
+    Build& build = entry.build;
+    if (build.program != 0) {
+        glDeleteShader(build.vertex);
+        glDeleteShader(build.fragment);
+        glDeleteProgram(build.program);
+        build = {};
+    }
+
+    const ProgramCache& cache = ProgramCache::shared();
+    const GLuint cached = cache.load(vertexSource, fragmentSource);
+    if (cached != 0) {
+        adopt(entry, cached);
+        return;
+    }
+
+    build.vertex = glutil::issueShader(GL_VERTEX_SHADER, vertexSource);
+    build.fragment = glutil::issueShader(GL_FRAGMENT_SHADER, fragmentSource);
+    build.program = glCreateProgram();
+    glAttachShader(build.program, build.vertex);
+    glAttachShader(build.program, build.fragment);
+    cache.prepare(build.program);
+    glLinkProgram(build.program);
+    build.vertexSource = std::move(vertexSource);
+    build.fragmentSource = std::move(fragmentSource);
+}
+
+bool ShaderManager::done(const Build& build) const {
+    if (!parallelCompile_) {
+        return build.age > 0;
+    }
+    GLint complete = GL_FALSE;
+    glGetProgramiv(build.program, kCompletionStatus, &complete);
+    return complete == GL_TRUE;
+}
+
+std::string ShaderManager::collect(Entry& entry) {
+    Build build = std::move(entry.build);
+    entry.build = {};
+
+    std::string error = glutil::shaderError(build.vertex);
+    if (error.empty()) {
+        error = glutil::shaderError(build.fragment);
+    }
+    glDeleteShader(build.vertex);
+    glDeleteShader(build.fragment);
+
+    if (error.empty()) {
+        error = glutil::programError(build.program);
+    }
+    if (!error.empty()) {
+        glDeleteProgram(build.program);
+        return error;
+    }
+
+    ProgramCache::shared().store(build.program, build.vertexSource, build.fragmentSource);
+    adopt(entry, build.program);
+    return {};
+}
+
+void ShaderManager::adopt(Entry& entry, GLuint program) {
+    entry.shader->adopt(program);
+    if (entry.setup) {
+        entry.shader->use();
+        entry.setup(*entry.shader);
+    }
+}
+
+void ShaderManager::drainEvents() {
+#ifdef __linux__
+    if (inotify_ < 0 || watch_ < 0) {
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        const ssize_t length = read(inotify_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->wd != watch_ || event->len == 0) {
+                continue;
+            }
+            for (Entry& entry : entries_) {
+                if (watches(entry.vertexPath, event->name) || watches(entry.fragmentPath, event->name)) {
+                    entry.stale = true;
+                }
+            }
+        }
+    }
+#endif
+}
+
+bool ShaderManager::watches(const std::string& path, const std::string& name) const {
+    const std::filesystem::path file(path);
+    return file.filename() == name && normalDirectory(file.parent_path().string()) == directory_;
+}
+
+ShaderManager& ShaderManager::shared() {
+    static ShaderManager manager;
+    return manager;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "app_config.hpp"
+#include "engine/Shader.h"
+
+// Builds shader programs without waiting on each one. load() only issues
+// the compile and link, so every program at startup compiles at once on
+// drivers that spread the work over threads, and finish() collects them.
+// With KHR_parallel_shader_compile, update() asks whether a build is done
+// before touching its status, so it never blocks; without it a build is
+// collected a frame after it was issued, which hides most of the cost.
+//
+// Where inotify exists, sources saved in the watched directory are
+// rebuilt in the background and swapped into their Shader only after a
+// successful link; a failed reload is logged and the old program stays.
+// Uniforms set once, such as sampler units, belong in the setup passed to
+// load(), which runs with the program bound each time one is swapped in.
+// Registered shaders must stay at the same address. All calls belong on
+// the GL thread.
+class ShaderManager {
+public:
+    ShaderManager() = default;
+    ~ShaderManager();
+
+    using Setup = std::function<void(const Shader&)>;
+
+    ShaderManager(const ShaderManager&) = delete;
+    ShaderManager& operator=(const ShaderManager&) = delete;
+
+    // Call once the context is current.
+    void initialize(GLADloadfunc load, const std::string& directory = app::kShaderDirectory);
+
+    // Starts building shader; it keeps its current program until the build
+    // is collected. Throws when a source cannot be read.
+    void load(Shader& shader, const std::string& vertexPath, const std::string& fragmentPath, Setup setup = {});
+    // Waits for every build in flight. Throws on the first that fails.
+    void finish();
+    // Starts rebuilds for changed sources and swaps in finished builds.
+    void update();
+
+    [[nodiscard]] bool parallelCompile() const;
+    [[nodiscard]] bool watching() const;
+
+    // The manager the renderer and particles build through.
+    static ShaderManager& shared();
+
+private:
+    struct Build {
+        GLuint vertex = 0;
+        GLuint fragment = 0;
+        GLuint program = 0;
+        std::string vertexSource;
+        std::string fragmentSource;
+        // Frames since the build was issued.
+        int age = 0;
+    };
+
+    struct Entry {
+        Shader* shader = nullptr;
+        std::string vertexPath;
+        std::string fragmentPath;
+        Setup setup;
+        Build build;
+        // A source changed while the build in flight was issued.
+        bool stale = false;
+    };
+
+    using MaxShaderCompilerThreads = void(GLAD_API_PTR*)(GLuint);
+
+    void start(Entry& entry);
+    [[nodiscard]] bool done(const Build& build) const;
+    // Swaps the build in, or returns why it failed.
+    [[nodiscard]] std::string collect(Entry& entry);
+    void adopt(Entry& entry, GLuint program);
+    void drainEvents();
+    [[nodiscard]] bool watches(const std::string& path, const std::string& name) const;
+
+    std::vector<Entry> entries_;
+    std::string directory_;
+    bool parallelCompile_ = false;
+    int inotify_ = -1;
+    int watch_ = -1;
+};
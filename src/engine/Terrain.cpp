@@ -0,0 +1,363 @@
+#include "engine/Terrain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "app_config.hpp"
+
+namespace {
+
+constexpr char kHeightmapMagic[8] = {'T', 'U', 'B', 'E', 'H', 'M', '0', '1'};
+constexpr std::size_t kHeightmapHeaderBytes = 28;
+
+float smoothStep(float edge0, float edge1, float x) {
+    const float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+}  // namespace
+
+struct Terrain::TileCache {
+    Terrain& terrain;
+
+    int find(const TileKey& key) {
+        return terrain.findTile(key);
+    }
+
+    int load(const TileKey& key) {
+        return terrain.loadTile(key);
+    }
+
+    [[nodiscard]] glm::vec2 heights(std::size_t layer) const {
+        const Tile& tile = terrain.tiles_[layer];
+        return {tile.minHeight, tile.maxHeight};
+    }
+};
+
+Terrain::~Terrain() {
+    release();
+}
+
+Terrain::Terrain(Terrain&& other) noexcept
+    : options_(other.options_),
+      layout_(other.layout_),
+      grid_(std::move(other.grid_)),
+      heights_(other.heights_),
+      tileSize_(other.tileSize_),
+      file_(std::move(other.file_)),
+      samples_(other.samples_),
+      heightScale_(other.heightScale_),
+      heightOffset_(other.heightOffset_),
+      tiles_(std::move(other.tiles_)),
+      lookup_(std::move(other.lookup_)),
+      requests_(std::move(other.requests_)),
+      nodes_(std::move(other.nodes_)),
+      frame_(other.frame_) {
+    other.heights_ = 0;
+    other.samples_ = nullptr;
+}
+
+Terrain& Terrain::operator=(Terrain&& other) noexcept {
+    if (this != &other) {
+        release();
+        options_ = other.options_;
+        layout_ = other.layout_;
+        grid_ = std::move(other.grid_);
+        heights_ = other.heights_;
+        tileSize_ = other.tileSize_;
+        file_ = std::move(other.file_);
+        samples_ = other.samples_;
+        heightScale_ = other.heightScale_;
+        heightOffset_ = other.heightOffset_;
+        tiles_ = std::move(other.tiles_);
+        lookup_ = std::move(other.lookup_);
+        requests_ = std::move(other.requests_);
+        nodes_ = std::move(other.nodes_);
+        frame_ = other.frame_;
+
+        other.heights_ = 0;
+        other.samples_ = nullptr;
+    }
+    return *this;
+}
+
+void Terrain::initialize(const TerrainOptions& options) {
+    release();
+
+    // Morphing folds odd vertices onto even ones, so the grid must be even.
+    options_ = options;
+    options_.gridSize = std::max(2, options_.gridSize / 2 * 2);
+    options_.levels = std::max(1, options_.levels);
+    layout_ = {options_.gridSize, options_.levels, options_.sampleSpacing, options_.rangeFactor};
+    file_ = MappedFile();
+    samples_ = nullptr;
+    tileSize_ = options_.gridSize + 3;
+
+    const int gridSize = options_.gridSize;
+    const std::size_t side = static_cast<std::size_t>(gridSize) + 1;
+    std::vector<float> vertices;
+    vertices.reserve(side * side * app::kVertexStrideFloats);
+    for (int j = 0; j <= gridSize; ++j) {
+        for (int i = 0; i <= gridSize; ++i) {
+            const float u = static_cast<float>(i) / static_cast<float>(gridSize);
+            const float v = static_cast<float>(j) / static_cast<float>(gridSize);
+            vertices.insert(vertices.end(), {static_cast<float>(i), 0.0f, static_cast<float>(j), 0.0f, 1.0f, 0.0f, u, v});
+        }
+    }
+
+    std::vector<unsigned int> indices;
+    indices.reserve(static_cast<std::size_t>(gridSize) * gridSize * 6);
+    for (int j = 0; j < gridSize; ++j) {
+        for (int i = 0; i < gridSize; ++i) {
+            const auto a = static_cast<unsigned int>(j * side + i);
+            const auto b = a + 1;
+            const auto c = a + static_cast<unsigned int>(side);
+            const auto d = c + 1;
+            indices.insert(indices.end(), {a, c, b, b, c, d});
+        }
+    }
+    grid_ = Mesh::createFromRaw(
+        vertices.data(),
+        vertices.size() * sizeof(float),
+        indices.data(),
+        indices.size() * sizeof(unsigned int),
+        false
+    );
+
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    options_.cacheTiles = std::clamp<std::size_t>(options_.cacheTiles, 1, static_cast<std::size_t>(std::max(maxLayers, 1)));
+
+    glGenTextures(1, &heights_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, heights_);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        0,
+        GL_R32F,
+        tileSize_,
+        tileSize_,
+        static_cast<GLsizei>(options_.cacheTiles),
+        0,
+        GL_RED,
+        GL_FLOAT,
+        nullptr
+    );
+
+    tiles_.assign(options_.cacheTiles, Tile{});
+    lookup_.clear();
+    nodes_.clear();
+}
+
+void Terrain::open(const std::string& path) {
+    // Tiles are paged wherever the camera goes, so read-ahead only wastes
+    // memory and I/O.
+    MappedFile file(path, MappedFile::Access::Random);
+    if (file.size() < kHeightmapHeaderBytes || std::memcmp(file.data(), kHeightmapMagic, sizeof(kHeightmapMagic)) != 0) {
+        throw std::runtime_error("Arquivo de altura invalido: " + path);
+    }
+
+    std::uint32_t width = 0;
+    std::uint32_t depth = 0;
+    float spacing = 0.0f;
+    float heightScale = 0.0f;
+    float heightOffset = 0.0f;
+    std::memcpy(&width, file.data() + 8, 4);
+    std::memcpy(&depth, file.data() + 12, 4);
+    std::memcpy(&spacing, file.data() + 16, 4);
+    std::memcpy(&heightScale, file.data() + 20, 4);
+    std::memcpy(&heightOffset, file.data() + 24, 4);
+
+    const std::size_t sampleBytes = static_cast<std::size_t>(width) * depth * sizeof(std::uint16_t);
+    if (width < 2 || depth < 2 || !(spacing > 0.0f) || file.size() - kHeightmapHeaderBytes < sampleBytes) {
+        throw std::runtime_error("Arquivo de altura invalido: " + path);
+    }
+
+    file_ = std::move(file);
+    samples_ = file_.data() + kHeightmapHeaderBytes;
+    heightScale_ = heightScale;
+    heightOffset_ = heightOffset;
+    layout_.width = width;
+    layout_.depth = depth;
+    layout_.spacing = spacing;
+    layout_.origin = -0.5f * spacing * glm::vec2(static_cast<float>(width - 1), static_cast<float>(depth - 1));
+
+    // Cached tiles still hold the procedural heights.
+    for (Tile& tile : tiles_) {
+        tile.resident = false;
+    }
+    lookup_.clear();
+    nodes_.clear();
+}
+
+void Terrain::update(const Camera& camera) {
+    if (heights_ == 0) {
+        return;
+    }
+
+    ++frame_;
+    nodes_.clear();
+    requests_.clear();
+
+    const Frustum frustum(camera.projectionMatrix() * camera.viewMatrix());
+    TileCache cache{*this};
+    selectTerrainNodes(layout_, camera.position(), frustum, cache, nodes_, requests_);
+
+    // Coarse tiles first: when the budget runs out, the detail that is
+    // still missing is then at most one level away.
+    std::sort(requests_.begin(), requests_.end(), [](const TileKey& a, const TileKey& b) {
+        return a.level > b.level;
+    });
+    std::size_t loaded = 0;
+    for (const TileKey& key : requests_) {
+        if (loaded == options_.tilesPerFrame) {
+            break;
+        }
+        if (findTile(key) >= 0) {
+            continue;
+        }
+        if (loadTile(key) < 0) {
+            break;
+        }
+        ++loaded;
+    }
+}
+
+void Terrain::draw(const Shader& shader, GLenum heightsUnit) const {
+    if (nodes_.empty()) {
+        return;
+    }
+
+    glActiveTexture(heightsUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, heights_);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setFloat("tileSize", static_cast<float>(tileSize_));
+
+    for (const TerrainNode& node : nodes_) {
+        const std::int64_t samples = layout_.nodeSamples(node.key.level);
+        const float levelRange = layout_.range(node.key.level);
+        shader.setVec2("nodeOrigin", layout_.sampleToWorld(node.key.x * samples, node.key.z * samples));
+        shader.setFloat("nodeSpacing", static_cast<float>(samples / options_.gridSize) * layout_.spacing);
+        shader.setVec2("morphRange", glm::vec2(options_.morphStart * levelRange, levelRange));
+        shader.setFloat("tileLayer", static_cast<float>(node.layer));
+        grid_.draw();
+    }
+}
+
+std::size_t Terrain::nodeCount() const {
+    return nodes_.size();
+}
+
+std::size_t Terrain::residentTiles() const {
+    return lookup_.size();
+}
+
+std::size_t Terrain::gpuBytes() const {
+    const std::size_t tileBytes = static_cast<std::size_t>(tileSize_) * static_cast<std::size_t>(tileSize_) * sizeof(float);
+    return grid_.gpuBytes() + (heights_ != 0 ? tiles_.size() * tileBytes : 0);
+}
+
+void Terrain::release() {
+    if (heights_ != 0) {
+        glDeleteTextures(1, &heights_);
+        heights_ = 0;
+    }
+}
+
+int Terrain::findTile(const TileKey& key) {
+    const auto found = lookup_.find(key);
+    if (found == lookup_.end()) {
+        return -1;
+    }
+    tiles_[found->second].lastUsed = frame_;
+    return static_cast<int>(found->second);
+}
+
+int Terrain::loadTile(const TileKey& key) {
+    // Least recently used slot, never one already drawn this frame.
+    std::size_t slot = tiles_.size();
+    std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+    for (std::size_t i = 0; i < tiles_.size(); ++i) {
+        if (!tiles_[i].resident) {
+            slot = i;
+            break;
+        }
+        if (tiles_[i].lastUsed != frame_ && tiles_[i].lastUsed < oldest) {
+            oldest = tiles_[i].lastUsed;
+            slot = i;
+        }
+    }
+    if (slot == tiles_.size()) {
+        return -1;
+    }
+
+    // Point sampling keeps every coarse sample equal to the finer one at
+    // the same spot, which is what lets the morphed edges line up. The
+    // border sample on each side feeds the shader's normals.
+    const auto size = static_cast<std::size_t>(tileSize_);
+    const std::int64_t step = layout_.nodeSamples(key.level) / options_.gridSize;
+    const std::int64_t firstI = key.x * layout_.nodeSamples(key.level) - step;
+    const std::int64_t firstJ = key.z * layout_.nodeSamples(key.level) - step;
+    std::vector<float> heights(size * size);
+    float minHeight = std::numeric_limits<float>::max();
+    float maxHeight = std::numeric_limits<float>::lowest();
+    for (std::size_t j = 0; j < size; ++j) {
+        for (std::size_t i = 0; i < size; ++i) {
+            const float height = sampleHeight(
+                firstI + static_cast<std::int64_t>(i) * step,
+                firstJ + static_cast<std::int64_t>(j) * step
+            );
+            heights[j * size + i] = height;
+            minHeight = std::min(minHeight, height);
+            maxHeight = std::max(maxHeight, height);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, heights_);
+    glTexSubImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        0,
+        0,
+        0,
+        static_cast<GLint>(slot),
+        tileSize_,
+        tileSize_,
+        1,
+        GL_RED,
+        GL_FLOAT,
+        heights.data()
+    );
+
+    Tile& tile = tiles_[slot];
+    if (tile.resident) {
+        lookup_.erase(tile.key);
+    }
+    tile = {key, minHeight, maxHeight, frame_, true};
+    lookup_[key] = slot;
+    return static_cast<int>(slot);
+}
+
+float Terrain::sampleHeight(std::int64_t i, std::int64_t j) const {
+    if (samples_ == nullptr) {
+        const glm::vec2 p = layout_.sampleToWorld(i, j);
+        const float hills = 12.0f * std::sin(p.x * 0.011f) * std::cos(p.y * 0.013f)
+                            + 5.0f * std::sin((p.x + p.y) * 0.031f)
+                            + 1.5f * std::sin(p.x * 0.11f - p.y * 0.07f);
+        const float blend = smoothStep(options_.flatRadius, options_.flatRadius * 2.5f + 1.0f, glm::length(p));
+        return options_.baseHeight + blend * hills;
+    }
+
+    // Outside the map the edge samples repeat.
+    i = std::clamp<std::int64_t>(i, 0, layout_.width - 1);
+    j = std::clamp<std::int64_t>(j, 0, layout_.depth - 1);
+    std::uint16_t sample = 0;
+    std::memcpy(&sample, samples_ + static_cast<std::size_t>(j * layout_.width + i) * sizeof(std::uint16_t), sizeof(sample));
+    return heightOffset_ + heightScale_ * static_cast<float>(sample);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "engine/Camera.h"
+#include "engine/Frustum.h"
+#include "engine/MappedFile.h"
+#include "engine/Mesh.h"
+#include "engine/Shader.h"
+#include "engine/TerrainQuadtree.h"
+
+// Heightmap file: the 8-byte magic "TUBEHM01", then little-endian uint32
+// width and depth in samples, float sample spacing, height scale and height
+// offset, followed by width * depth uint16 samples row by row (x fastest).
+// A sample s is at height offset + scale * s, and the map is centred on the
+// world origin.
+struct TerrainOptions {
+    // Quads along one side of every node; all nodes share one grid mesh.
+    int gridSize = 32;
+    int levels = 7;
+    // The procedural fallback: rolling hills around baseHeight that flatten
+    // out within flatRadius of the origin. Files carry their own spacing.
+    float sampleSpacing = 1.0f;
+    float baseHeight = 0.0f;
+    float flatRadius = 0.0f;
+    // A node is split while the camera is within rangeFactor of its size.
+    float rangeFactor = 2.0f;
+    // Fraction of a level's range after which its vertices start to morph
+    // towards the next coarser grid.
+    float morphStart = 0.7f;
+    // Clamped to GL_MAX_ARRAY_TEXTURE_LAYERS, which is at least 256.
+    std::size_t cacheTiles = 256;
+    std::size_t tilesPerFrame = 16;
+};
+
+// Chunked quadtree (CDLOD) terrain centred on the camera. Each selected node
+// draws the same grid; the vertex shader reads heights from the node's tile
+// in a texture array and morphs vertices towards the coarser level near the
+// edge of its range, so neighbouring levels meet without cracks. Tiles are
+// point-sampled from the memory-mapped heightmap on demand into a fixed
+// cache, so memory and triangle count do not depend on the terrain extent.
+class Terrain {
+public:
+    Terrain() = default;
+    ~Terrain();
+
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+    Terrain(Terrain&& other) noexcept;
+    Terrain& operator=(Terrain&& other) noexcept;
+
+    void initialize(const TerrainOptions& options = {});
+    // Switches from procedural heights to a heightmap file.
+    void open(const std::string& path);
+
+    // Selects the nodes for this view and pages in at most tilesPerFrame
+    // missing tiles; nodes whose children are not resident yet draw whole.
+    void update(const Camera& camera);
+    // Expects shader in use with the camera uniforms already set.
+    void draw(const Shader& shader, GLenum heightsUnit) const;
+
+    [[nodiscard]] std::size_t nodeCount() const;
+    [[nodiscard]] std::size_t residentTiles() const;
+    [[nodiscard]] std::size_t gpuBytes() const;
+
+private:
+    using TileKey = TerrainTileKey;
+
+    struct Tile {
+        TileKey key;
+        float minHeight = 0.0f;
+        float maxHeight = 0.0f;
+        std::uint64_t lastUsed = 0;
+        bool resident = false;
+    };
+
+    // The cache as selectTerrainNodes() sees it.
+    struct TileCache;
+
+    void release();
+    // Resident layer of key, marked as used this frame, or -1.
+    [[nodiscard]] int findTile(const TileKey& key);
+    [[nodiscard]] int loadTile(const TileKey& key);
+
+    [[nodiscard]] float sampleHeight(std::int64_t i, std::int64_t j) const;
+
+    TerrainOptions options_;
+    TerrainLayout layout_;
+    Mesh grid_;
+    GLuint heights_ = 0;
+    int tileSize_ = 0;
+
+    MappedFile file_;
+    const char* samples_ = nullptr;
+    float heightScale_ = 1.0f;
+    float heightOffset_ = 0.0f;
+
+    std::vector<Tile> tiles_;
+    std::unordered_map<TileKey, std::size_t, TerrainTileKeyHash> lookup_;
+    std::vector<TileKey> requests_;
+    std::vector<TerrainNode> nodes_;
+    std::uint64_t frame_ = 0;
+};
@@ -0,0 +1,35 @@
+#include "engine/TerrainQuadtree.h"
+
+#include <functional>
+
+std::size_t TerrainTileKeyHash::operator()(const TerrainTileKey& key) const {
+    std::size_t hash = std::hash<std::int64_t>()(key.x);
+    hash ^= std::hash<std::int64_t>()(key.z) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>()(key.level) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+std::int64_t TerrainLayout::nodeSamples(int level) const {
+    return static_cast<std::int64_t>(gridSize) << level;
+}
+
+float TerrainLayout::range(int level) const {
+    return rangeFactor * static_cast<float>(nodeSamples(level)) * spacing;
+}
+
+glm::vec2 TerrainLayout::sampleToWorld(std::int64_t i, std::int64_t j) const {
+    return origin + spacing * glm::vec2(static_cast<float>(i), static_cast<float>(j));
+}
+
+bool TerrainLayout::insideMap(const TerrainTileKey& key) const {
+    if (width == 0 || depth == 0) {
+        return true;
+    }
+
+    const std::int64_t samples = nodeSamples(key.level);
+    return key.x * samples < width && (key.x + 1) * samples > 0 && key.z * samples < depth && (key.z + 1) * samples > 0;
+}
+
+TerrainTileKey TerrainLayout::child(const TerrainTileKey& key, int index) const {
+    return {key.level - 1, key.x * 2 + (index & 1), key.z * 2 + (index >> 1)};
+}
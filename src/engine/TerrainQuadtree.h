@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "engine/Frustum.h"
+
+// Node (level, x, z) of the quadtree covers samples [x, x + 1) * n by
+// [z, z + 1) * n, with n = gridSize << level.
+struct TerrainTileKey {
+    int level = 0;
+    std::int64_t x = 0;
+    std::int64_t z = 0;
+
+    bool operator==(const TerrainTileKey& other) const {
+        return level == other.level && x == other.x && z == other.z;
+    }
+};
+
+struct TerrainTileKeyHash {
+    std::size_t operator()(const TerrainTileKey& key) const;
+};
+
+// Where the quadtree's nodes lie and how far each level reaches.
+struct TerrainLayout {
+    int gridSize = 32;
+    int levels = 7;
+    float spacing = 1.0f;
+    float rangeFactor = 2.0f;
+    // World position of sample (0, 0).
+    glm::vec2 origin{0.0f};
+    // Map size in samples; zero for unbounded procedural terrain.
+    std::int64_t width = 0;
+    std::int64_t depth = 0;
+
+    [[nodiscard]] std::int64_t nodeSamples(int level) const;
+    // A node of level + 1 splits while the camera is within range(level).
+    [[nodiscard]] float range(int level) const;
+    [[nodiscard]] glm::vec2 sampleToWorld(std::int64_t i, std::int64_t j) const;
+    [[nodiscard]] bool insideMap(const TerrainTileKey& key) const;
+    [[nodiscard]] TerrainTileKey child(const TerrainTileKey& key, int index) const;
+};
+
+struct TerrainNode {
+    TerrainTileKey key;
+    std::size_t layer = 0;
+};
+
+// CDLOD selection, kept apart from the GL tile cache so it can be tested on
+// its own. Tiles provides find(key), the resident layer or -1; load(key),
+// which pages a tile in now and returns its layer or -1 when the cache is
+// full; and heights(layer), the tile's (min, max) height. Roots within
+// reach are loaded at once so the terrain never has holes. A node splits
+// while the finer level's range reaches it, but only once all four children
+// are resident; until then it draws whole and the missing children are
+// appended to requests.
+template <typename Tiles>
+void selectTerrainNodes(
+    const TerrainLayout& layout,
+    const glm::vec3& eye,
+    const Frustum& frustum,
+    Tiles& tiles,
+    std::vector<TerrainNode>& nodes,
+    std::vector<TerrainTileKey>& requests
+) {
+    const auto visit = [&](const auto& self, const TerrainTileKey& key, std::size_t layer) -> void {
+        const glm::vec2 heights = tiles.heights(layer);
+        const std::int64_t samples = layout.nodeSamples(key.level);
+        const glm::vec2 low = layout.sampleToWorld(key.x * samples, key.z * samples);
+        const glm::vec2 high = layout.sampleToWorld((key.x + 1) * samples, (key.z + 1) * samples);
+        const glm::vec3 boundsMin(low.x, heights.x, low.y);
+        const glm::vec3 boundsMax(high.x, heights.y, high.y);
+        if (!frustum.intersectsBox(boundsMin, boundsMax)) {
+            return;
+        }
+
+        if (key.level > 0 && glm::length(eye - glm::clamp(eye, boundsMin, boundsMax)) < layout.range(key.level - 1)) {
+            std::array<int, 4> children{};
+            bool ready = true;
+            for (int child = 0; child < 4; ++child) {
+                const TerrainTileKey childKey = layout.child(key, child);
+                children[child] = layout.insideMap(childKey) ? tiles.find(childKey) : std::numeric_limits<int>::min();
+                if (children[child] == -1) {
+                    requests.push_back(childKey);
+                    ready = false;
+                }
+            }
+
+            if (ready) {
+                for (int child = 0; child < 4; ++child) {
+                    if (children[child] >= 0) {
+                        self(self, layout.child(key, child), static_cast<std::size_t>(children[child]));
+                    }
+                }
+                return;
+            }
+        }
+
+        nodes.push_back({key, layer});
+    };
+
+    const int top = layout.levels - 1;
+    const float rootExtent = static_cast<float>(layout.nodeSamples(top)) * layout.spacing;
+    const float reach = layout.range(top);
+    const auto rootIndex = [rootExtent](float world, float origin) {
+        return static_cast<std::int64_t>(std::floor((world - origin) / rootExtent));
+    };
+    for (std::int64_t z = rootIndex(eye.z - reach, layout.origin.y); z <= rootIndex(eye.z + reach, layout.origin.y); ++z) {
+        for (std::int64_t x = rootIndex(eye.x - reach, layout.origin.x); x <= rootIndex(eye.x + reach, layout.origin.x); ++x) {
+            const TerrainTileKey key{top, x, z};
+            if (!layout.insideMap(key)) {
+                continue;
+            }
+
+            int layer = tiles.find(key);
+            if (layer < 0) {
+                layer = tiles.load(key);
+            }
+            if (layer >= 0) {
+                visit(visit, key, static_cast<std::size_t>(layer));
+            }
+        }
+    }
+}
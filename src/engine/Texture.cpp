@@ -1,36 +1,68 @@
 #include "engine/Texture.h"
 
-#include <iostream>
+#include "engine/TextureLoader.h"
+#include "engine/TextureStreamer.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include <utility>
 
 Texture::Texture(const std::string& imagePath) {
     load(imagePath);
 }
 
 Texture::~Texture() {
-    if (texture_ != 0) {
-        glDeleteTextures(1, &texture_);
-    }
+    release();
 }
 
-Texture::Texture(Texture&& other) noexcept : texture_(other.texture_) {
+Texture::Texture(Texture&& other) noexcept
+    : texture_(other.texture_),
+      requested_(other.requested_),
+      streamed_(other.streamed_) {
     other.texture_ = 0;
+    other.requested_ = false;
+    other.streamed_ = false;
 }
 
 Texture& Texture::operator=(Texture&& other) noexcept {
     if (this != &other) {
-        if (texture_ != 0) {
-            glDeleteTextures(1, &texture_);
-        }
+        release();
         texture_ = other.texture_;
+        requested_ = other.requested_;
+        streamed_ = other.streamed_;
         other.texture_ = 0;
+        other.requested_ = false;
+        other.streamed_ = false;
     }
     return *this;
 }
 
 void Texture::load(const std::string& imagePath) {
+    create();
+    if (streamed_) {
+        TextureStreamer::shared().close(texture_);
+        streamed_ = false;
+    }
+    TextureLoader::shared().request(texture_, imagePath);
+    requested_ = true;
+}
+
+bool Texture::stream(const std::string& cookedPath) {
+    Texture streamed;
+    streamed.create();
+    if (!TextureStreamer::shared().open(streamed.texture_, cookedPath)) {
+        return false;
+    }
+    streamed.streamed_ = true;
+    *this = std::move(streamed);
+    return true;
+}
+
+void Texture::requestDetail(float uvPerPixel) const {
+    if (streamed_) {
+        TextureStreamer::shared().request(texture_, uvPerPixel);
+    }
+}
+
+void Texture::create() {
     if (texture_ == 0) {
         glGenTextures(1, &texture_);
     }
@@ -41,25 +73,91 @@ void Texture::load(const std::string& imagePath) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    int width = 0;
-    int height = 0;
-    int channels = 0;
-    unsigned char* data = stbi_load(imagePath.c_str(), &width, &height, &channels, 0);
-
-    if (data != nullptr) {
-        const GLenum format = channels == 4 ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cerr << "Erro ao carregar textura: " << imagePath << '\n';
-        const unsigned char whitePixel[] = {255, 255, 255, 255};
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
-    }
-
-    stbi_image_free(data);
+    // White until the decoded image is uploaded, and for good if it fails.
+    const unsigned char whitePixel[] = {255, 255, 255, 255};
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
 }
 
 void Texture::bind(GLenum textureUnit) const {
     glActiveTexture(textureUnit);
     glBindTexture(GL_TEXTURE_2D, texture_);
 }
+
+GLuint Texture::id() const {
+    return texture_;
+}
+
+bool Texture::ready() const {
+    if (streamed_) {
+        return TextureStreamer::shared().ready(texture_);
+    }
+    return !requested_ || !TextureLoader::shared().pending(texture_);
+}
+
+bool Texture::complete() const {
+    if (streamed_) {
+        return TextureStreamer::shared().residentLevel(texture_) == 0;
+    }
+    return ready();
+}
+
+bool Texture::streamed() const {
+    return streamed_;
+}
+
+std::size_t Texture::gpuBytes() const {
+    if (texture_ == 0) {
+        return 0;
+    }
+
+    // Streamed textures keep stale or empty levels above the base.
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    GLint baseLevel = 0;
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &baseLevel);
+    std::size_t bytes = 0;
+    for (GLint level = baseLevel;; ++level) {
+        GLint width = 0;
+        GLint height = 0;
+        GLint compressed = GL_FALSE;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED, &compressed);
+        if (width <= 0 || height <= 0) {
+            break;
+        }
+
+        if (compressed == GL_TRUE) {
+            GLint size = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+            bytes += static_cast<std::size_t>(size);
+        } else {
+            // Drivers store three-channel texels padded to four bytes.
+            bytes += static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4u;
+        }
+        if (width == 1 && height == 1) {
+            break;
+        }
+    }
+    return bytes;
+}
+
+void Texture::release() {
+    if (texture_ == 0) {
+        return;
+    }
+
+    // The name may be reused by the next glGenTextures, so a decode still
+    // in flight must not land on it.
+    if (requested_) {
+        TextureLoader::shared().cancel(texture_);
+    }
+    if (streamed_) {
+        TextureStreamer::shared().close(texture_);
+    }
+    glDeleteTextures(1, &texture_);
+    texture_ = 0;
+    requested_ = false;
+    streamed_ = false;
+}
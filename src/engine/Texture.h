@@ -2,11 +2,14 @@
 
 #include <glad/gl.h>
 
+#include <cstddef>
 #include <string>
 
 class Texture {
 public:
     Texture() = default;
+    // Usable at once as a white texel; the image, or its cooked sibling,
+    // is loaded by TextureLoader::shared() and swapped in by its pump().
     explicit Texture(const std::string& imagePath);
     ~Texture();
 
@@ -16,8 +19,30 @@ public:
     Texture& operator=(Texture&& other) noexcept;
 
     void load(const std::string& imagePath);
+    // Streams the mip levels of a cooked file through
+    // TextureStreamer::shared(). False, leaving the texture untouched, when
+    // the file cannot be streamed.
+    bool stream(const std::string& cookedPath);
+    // For streamed textures, asks for the detail a pixel spanning
+    // uvPerPixel texture coordinates needs this frame.
+    void requestDetail(float uvPerPixel) const;
     void bind(GLenum textureUnit) const;
+    [[nodiscard]] GLuint id() const;
+
+    // False while the image is still being decoded or waits for upload.
+    [[nodiscard]] bool ready() const;
+    // True once level 0 can be sampled; a streamed texture may be ready()
+    // long before, with only its coarse tail resident.
+    [[nodiscard]] bool complete() const;
+    [[nodiscard]] bool streamed() const;
+    // Storage of the levels from the base level down, as reported by GL.
+    [[nodiscard]] std::size_t gpuBytes() const;
 
 private:
+    void create();
+    void release();
+
     GLuint texture_ = 0;
+    bool requested_ = false;
+    bool streamed_ = false;
 };
@@ -0,0 +1,539 @@
+#include "engine/TextureCook.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace texcook {
+
+namespace {
+
+constexpr char kMagic[8] = {'T', 'U', 'B', 'E', 'T', 'X', '0', '1'};
+constexpr std::size_t kHeaderBytes = 24;
+constexpr std::size_t kLevelEntryBytes = 24;
+constexpr std::size_t kAlignment = 16;
+constexpr std::uint32_t kMaxLevels = 32;
+constexpr char kPagedMagic[8] = {'T', 'U', 'B', 'E', 'V', 'T', '0', '1'};
+constexpr std::size_t kPagedHeaderBytes = 32;
+// Keeps page coordinates within the 12 bits the feedback pass encodes.
+constexpr int kMaxPagedLevels = 13;
+
+std::size_t align(std::size_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Offsets for every level of a width x height texture, packed from zero.
+Layout layoutFor(Format format, int width, int height) {
+    Layout layout;
+    layout.format = format;
+    std::size_t offset = 0;
+    for (;;) {
+        const std::size_t size = levelBytes(format, width, height);
+        layout.levels.push_back({width, height, offset, size});
+        offset = align(offset + size);
+        if (width == 1 && height == 1) {
+            break;
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return layout;
+}
+
+std::size_t totalBytes(const Layout& layout) {
+    const Level& last = layout.levels.back();
+    return align(last.offset + last.size);
+}
+
+const std::array<float, 256>& srgbToLinear() {
+    static const std::array<float, 256> table = []() {
+        std::array<float, 256> values{};
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            const float c = static_cast<float>(i) / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+unsigned char linearToSrgb(float value) {
+    value = std::clamp(value, 0.0f, 1.0f);
+    const float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<unsigned char>(c * 255.0f + 0.5f);
+}
+
+std::uint16_t pack565(const float* color) {
+    const auto quantize = [](float value, int maximum) {
+        return static_cast<std::uint16_t>(std::clamp(static_cast<int>(value / 255.0f * maximum + 0.5f), 0, maximum));
+    };
+    return static_cast<std::uint16_t>(quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 | quantize(color[2], 31));
+}
+
+void unpack565(std::uint16_t packed, int* color) {
+    const int r = packed >> 11 & 31;
+    const int g = packed >> 5 & 63;
+    const int b = packed & 31;
+    color[0] = r << 3 | r >> 2;
+    color[1] = g << 2 | g >> 4;
+    color[2] = b << 3 | b >> 2;
+}
+
+// Endpoints span the block's bounding box along whichever diagonal follows
+// the colour trend, pulled in slightly so the extremes round better.
+void encodeColorBlock(const unsigned char (&texels)[16][4], unsigned char* out) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    float low[3] = {255.0f, 255.0f, 255.0f};
+    float high[3] = {0.0f, 0.0f, 0.0f};
+    for (const auto& texel : texels) {
+        for (int c = 0; c < 3; ++c) {
+            mean[c] += texel[c] / 16.0f;
+            low[c] = std::min(low[c], static_cast<float>(texel[c]));
+            high[c] = std::max(high[c], static_cast<float>(texel[c]));
+        }
+    }
+
+    float redGreen = 0.0f;
+    float blueGreen = 0.0f;
+    for (const auto& texel : texels) {
+        const float green = texel[1] - mean[1];
+        redGreen += (texel[0] - mean[0]) * green;
+        blueGreen += (texel[2] - mean[2]) * green;
+    }
+    if (redGreen < 0.0f) {
+        std::swap(low[0], high[0]);
+    }
+    if (blueGreen < 0.0f) {
+        std::swap(low[2], high[2]);
+    }
+    for (int c = 0; c < 3; ++c) {
+        const float inset = (high[c] - low[c]) / 16.0f;
+        high[c] -= inset;
+        low[c] += inset;
+    }
+
+    std::uint16_t color0 = pack565(high);
+    std::uint16_t color1 = pack565(low);
+    // color0 > color1 selects the four-colour mode.
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    int palette[4][3];
+    unpack565(color0, palette[0]);
+    unpack565(color1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    std::uint32_t indices = 0;
+    if (color0 != color1) {
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            int bestDistance = std::numeric_limits<int>::max();
+            for (int p = 0; p < 4; ++p) {
+                int distance = 0;
+                for (int c = 0; c < 3; ++c) {
+                    const int d = texels[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<std::uint32_t>(best) << (2 * i);
+        }
+    }
+
+    std::memcpy(out, &color0, 2);
+    std::memcpy(out + 2, &color1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+void encodeAlphaBlock(const unsigned char (&texels)[16][4], unsigned char* out) {
+    int alpha0 = 0;
+    int alpha1 = 255;
+    for (const auto& texel : texels) {
+        alpha0 = std::max<int>(alpha0, texel[3]);
+        alpha1 = std::min<int>(alpha1, texel[3]);
+    }
+
+    // alpha0 > alpha1 selects eight interpolated values.
+    int palette[8] = {alpha0, alpha1};
+    for (int i = 1; i < 7; ++i) {
+        palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+    }
+
+    std::uint64_t indices = 0;
+    if (alpha0 != alpha1) {
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            for (int p = 1; p < 8; ++p) {
+                if (std::abs(texels[i][3] - palette[p]) < std::abs(texels[i][3] - palette[best])) {
+                    best = p;
+                }
+            }
+            indices |= static_cast<std::uint64_t>(best) << (3 * i);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(alpha0);
+    out[1] = static_cast<unsigned char>(alpha1);
+    std::memcpy(out + 2, &indices, 6);
+}
+
+void writeValue(std::ofstream& out, const void* value, std::size_t bytes) {
+    out.write(static_cast<const char*>(value), static_cast<std::streamsize>(bytes));
+}
+
+}  // namespace
+
+bool compressed(Format format) {
+    return format == Format::Bc1 || format == Format::Bc3;
+}
+
+int bytesPerPixel(Format format) {
+    return format == Format::Rgb8 ? 3 : 4;
+}
+
+int blockBytes(Format format) {
+    return format == Format::Bc1 ? 8 : 16;
+}
+
+std::size_t levelBytes(Format format, int width, int height) {
+    if (compressed(format)) {
+        const auto blocks = static_cast<std::size_t>((width + 3) / 4) * static_cast<std::size_t>((height + 3) / 4);
+        return blocks * static_cast<std::size_t>(blockBytes(format));
+    }
+    return static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * static_cast<std::size_t>(bytesPerPixel(format));
+}
+
+MipChain buildMipChain(const unsigned char* pixels, int width, int height, int channels) {
+    MipChain chain;
+    chain.layout = layoutFor(channels == 4 ? Format::Rgba8 : Format::Rgb8, width, height);
+    chain.pixels.resize(totalBytes(chain.layout));
+    std::memcpy(chain.pixels.data(), pixels, chain.layout.levels.front().size);
+
+    // Filtering runs on flat float arrays, one level into the next.
+    const std::array<float, 256>& decode = srgbToLinear();
+    std::vector<float> current(chain.layout.levels.front().size);
+    for (std::size_t i = 0; i < current.size(); ++i) {
+        const bool alpha = channels == 4 && i % 4 == 3;
+        current[i] = alpha ? pixels[i] / 255.0f : decode[pixels[i]];
+    }
+
+    std::vector<float> next;
+    for (std::size_t l = 1; l < chain.layout.levels.size(); ++l) {
+        const Level& source = chain.layout.levels[l - 1];
+        const Level& level = chain.layout.levels[l];
+        next.assign(level.size, 0.0f);
+
+        const auto sourceRow = static_cast<std::size_t>(source.width) * channels;
+        const auto row = static_cast<std::size_t>(level.width) * channels;
+        for (int y = 0; y < level.height; ++y) {
+            const float* row0 = current.data() + std::min(2 * y, source.height - 1) * sourceRow;
+            const float* row1 = current.data() + std::min(2 * y + 1, source.height - 1) * sourceRow;
+            float* target = next.data() + y * row;
+            for (int x = 0; x < level.width; ++x) {
+                const std::size_t x0 = static_cast<std::size_t>(std::min(2 * x, source.width - 1)) * channels;
+                const std::size_t x1 = static_cast<std::size_t>(std::min(2 * x + 1, source.width - 1)) * channels;
+                for (int c = 0; c < channels; ++c) {
+                    target[x * channels + c] = 0.25f * (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]);
+                }
+            }
+        }
+
+        unsigned char* out = chain.pixels.data() + level.offset;
+        for (std::size_t i = 0; i < next.size(); ++i) {
+            const bool alpha = channels == 4 && i % 4 == 3;
+            out[i] = alpha ? static_cast<unsigned char>(std::clamp(next[i], 0.0f, 1.0f) * 255.0f + 0.5f) : linearToSrgb(next[i]);
+        }
+        current.swap(next);
+    }
+    return chain;
+}
+
+MipChain compress(const MipChain& chain) {
+    const int channels = bytesPerPixel(chain.layout.format);
+    const Level& base = chain.layout.levels.front();
+
+    MipChain result;
+    result.layout = layoutFor(channels == 4 ? Format::Bc3 : Format::Bc1, base.width, base.height);
+    result.pixels.resize(totalBytes(result.layout));
+
+    for (std::size_t l = 0; l < chain.layout.levels.size(); ++l) {
+        const Level& source = chain.layout.levels[l];
+        const unsigned char* pixels = chain.pixels.data() + source.offset;
+        unsigned char* out = result.pixels.data() + result.layout.levels[l].offset;
+
+        // Blocks past the edge of small levels repeat the last row and column.
+        unsigned char texels[16][4];
+        for (int by = 0; by < source.height; by += 4) {
+            for (int bx = 0; bx < source.width; bx += 4) {
+                for (int i = 0; i < 16; ++i) {
+                    const int x = std::min(bx + i % 4, source.width - 1);
+                    const int y = std::min(by + i / 4, source.height - 1);
+                    const unsigned char* texel = pixels + (static_cast<std::size_t>(y) * source.width + x) * channels;
+                    texels[i][0] = texel[0];
+                    texels[i][1] = texel[1];
+                    texels[i][2] = texel[2];
+                    texels[i][3] = channels == 4 ? texel[3] : 255;
+                }
+                if (channels == 4) {
+                    encodeAlphaBlock(texels, out);
+                    out += 8;
+                }
+                encodeColorBlock(texels, out);
+                out += 8;
+            }
+        }
+    }
+    return result;
+}
+
+std::string cookedPath(const std::string& sourcePath) {
+    const std::size_t slash = sourcePath.find_last_of("/\\");
+    const std::size_t dot = sourcePath.find_last_of('.');
+    const bool extension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    return sourcePath.substr(0, extension ? dot : sourcePath.size()) + ".ttx";
+}
+
+void write(const std::string& path, const MipChain& chain) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Erro ao criar arquivo: " + path);
+    }
+
+    const Level& base = chain.layout.levels.front();
+    const auto format = static_cast<std::uint32_t>(chain.layout.format);
+    const auto width = static_cast<std::uint32_t>(base.width);
+    const auto height = static_cast<std::uint32_t>(base.height);
+    const auto levelCount = static_cast<std::uint32_t>(chain.layout.levels.size());
+    writeValue(out, kMagic, sizeof(kMagic));
+    writeValue(out, &format, 4);
+    writeValue(out, &width, 4);
+    writeValue(out, &height, 4);
+    writeValue(out, &levelCount, 4);
+
+    const std::size_t dataStart = align(kHeaderBytes + kLevelEntryBytes * chain.layout.levels.size());
+    for (const Level& level : chain.layout.levels) {
+        const std::uint64_t offset = dataStart + level.offset;
+        const std::uint64_t size = level.size;
+        const auto levelWidth = static_cast<std::uint32_t>(level.width);
+        const auto levelHeight = static_cast<std::uint32_t>(level.height);
+        writeValue(out, &offset, 8);
+        writeValue(out, &size, 8);
+        writeValue(out, &levelWidth, 4);
+        writeValue(out, &levelHeight, 4);
+    }
+
+    const std::vector<char> padding(dataStart - kHeaderBytes - kLevelEntryBytes * chain.layout.levels.size(), 0);
+    writeValue(out, padding.data(), padding.size());
+    writeValue(out, chain.pixels.data(), chain.pixels.size());
+    if (!out) {
+        throw std::runtime_error("Erro ao gravar arquivo: " + path);
+    }
+}
+
+bool isCooked(const char* data, std::size_t size) {
+    return size >= kHeaderBytes && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+Layout parse(const char* data, std::size_t size, const std::string& path) {
+    if (!isCooked(data, size)) {
+        throw std::runtime_error("Textura cozida invalida: " + path);
+    }
+
+    std::uint32_t format = 0;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t levelCount = 0;
+    std::memcpy(&format, data + 8, 4);
+    std::memcpy(&width, data + 12, 4);
+    std::memcpy(&height, data + 16, 4);
+    std::memcpy(&levelCount, data + 20, 4);
+    if (format > static_cast<std::uint32_t>(Format::Bc3) || levelCount == 0 || levelCount > kMaxLevels || width == 0 || height == 0 ||
+        width > 65536 || height > 65536 || size < kHeaderBytes + kLevelEntryBytes * levelCount) {
+        throw std::runtime_error("Textura cozida invalida: " + path);
+    }
+
+    Layout layout;
+    layout.format = static_cast<Format>(format);
+    auto expectedWidth = static_cast<int>(width);
+    auto expectedHeight = static_cast<int>(height);
+    for (std::uint32_t i = 0; i < levelCount; ++i) {
+        const char* entry = data + kHeaderBytes + kLevelEntryBytes * i;
+        std::uint64_t offset = 0;
+        std::uint64_t levelSize = 0;
+        std::uint32_t levelWidth = 0;
+        std::uint32_t levelHeight = 0;
+        std::memcpy(&offset, entry, 8);
+        std::memcpy(&levelSize, entry + 8, 8);
+        std::memcpy(&levelWidth, entry + 16, 4);
+        std::memcpy(&levelHeight, entry + 20, 4);
+
+        if (static_cast<int>(levelWidth) != expectedWidth || static_cast<int>(levelHeight) != expectedHeight ||
+            levelSize != levelBytes(layout.format, expectedWidth, expectedHeight) || offset > size || levelSize > size - offset) {
+            throw std::runtime_error("Textura cozida invalida: " + path);
+        }
+        layout.levels.push_back({expectedWidth, expectedHeight, static_cast<std::size_t>(offset), static_cast<std::size_t>(levelSize)});
+        expectedWidth = std::max(1, expectedWidth / 2);
+        expectedHeight = std::max(1, expectedHeight / 2);
+    }
+    return layout;
+}
+
+int PageLayout::pagesPerSide(int level) const {
+    return 1 << (levelCount - 1 - level);
+}
+
+int PageLayout::virtualSize() const {
+    return pageSize << (levelCount - 1);
+}
+
+int PageLayout::storedSize() const {
+    return pageSize + 2 * border;
+}
+
+std::size_t PageLayout::pageBytes() const {
+    return static_cast<std::size_t>(storedSize()) * static_cast<std::size_t>(storedSize()) * 4u;
+}
+
+std::size_t PageLayout::pageOffset(int level, int x, int y) const {
+    std::size_t pages = 0;
+    for (int l = 0; l < level; ++l) {
+        pages += static_cast<std::size_t>(pagesPerSide(l)) * static_cast<std::size_t>(pagesPerSide(l));
+    }
+    pages += static_cast<std::size_t>(y) * static_cast<std::size_t>(pagesPerSide(level)) + static_cast<std::size_t>(x);
+    return kPagedHeaderBytes + pages * pageBytes();
+}
+
+std::size_t PageLayout::fileBytes() const {
+    return pageOffset(levelCount - 1, 0, 0) + pageBytes();
+}
+
+void writePages(
+    const std::string& path,
+    const unsigned char* pixels,
+    int width,
+    int height,
+    int channels,
+    int pageSize,
+    int border
+) {
+    PageLayout layout{pageSize, border, width, height, 1};
+    while (layout.virtualSize() < std::max(width, height)) {
+        ++layout.levelCount;
+    }
+    if (layout.levelCount > kMaxPagedLevels) {
+        throw std::runtime_error("Imagem grande demais para paginar: " + path);
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Erro ao criar arquivo: " + path);
+    }
+    const std::uint32_t header[6] = {
+        static_cast<std::uint32_t>(pageSize),
+        static_cast<std::uint32_t>(border),
+        static_cast<std::uint32_t>(width),
+        static_cast<std::uint32_t>(height),
+        static_cast<std::uint32_t>(layout.levelCount),
+        0,
+    };
+    writeValue(out, kPagedMagic, sizeof(kPagedMagic));
+    writeValue(out, header, sizeof(header));
+
+    // The current level as RGBA; texels past the image repeat its edge.
+    std::vector<unsigned char> level(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4u);
+    for (std::size_t i = 0; i < static_cast<std::size_t>(width) * static_cast<std::size_t>(height); ++i) {
+        for (int c = 0; c < 4; ++c) {
+            level[i * 4 + c] = c < channels ? pixels[i * channels + c] : 255;
+        }
+    }
+
+    const int stored = layout.storedSize();
+    std::vector<unsigned char> page(layout.pageBytes());
+    const std::array<float, 256>& decode = srgbToLinear();
+    for (int l = 0; l < layout.levelCount; ++l) {
+        const int pages = layout.pagesPerSide(l);
+        for (int py = 0; py < pages; ++py) {
+            for (int px = 0; px < pages; ++px) {
+                for (int y = 0; y < stored; ++y) {
+                    const int sy = std::clamp(py * pageSize + y - border, 0, height - 1);
+                    for (int x = 0; x < stored; ++x) {
+                        const int sx = std::clamp(px * pageSize + x - border, 0, width - 1);
+                        std::memcpy(&page[(static_cast<std::size_t>(y) * stored + x) * 4], &level[(static_cast<std::size_t>(sy) * width + sx) * 4], 4);
+                    }
+                }
+                writeValue(out, page.data(), page.size());
+            }
+        }
+
+        const int nextWidth = std::max(1, width / 2);
+        const int nextHeight = std::max(1, height / 2);
+        std::vector<unsigned char> next(static_cast<std::size_t>(nextWidth) * static_cast<std::size_t>(nextHeight) * 4u);
+        for (int y = 0; y < nextHeight; ++y) {
+            const std::size_t row0 = static_cast<std::size_t>(std::min(2 * y, height - 1)) * width;
+            const std::size_t row1 = static_cast<std::size_t>(std::min(2 * y + 1, height - 1)) * width;
+            for (int x = 0; x < nextWidth; ++x) {
+                const std::size_t x0 = static_cast<std::size_t>(std::min(2 * x, width - 1));
+                const std::size_t x1 = static_cast<std::size_t>(std::min(2 * x + 1, width - 1));
+                const unsigned char* texels[4] = {
+                    &level[(row0 + x0) * 4],
+                    &level[(row0 + x1) * 4],
+                    &level[(row1 + x0) * 4],
+                    &level[(row1 + x1) * 4],
+                };
+                unsigned char* target = &next[(static_cast<std::size_t>(y) * nextWidth + x) * 4];
+                for (int c = 0; c < 3; ++c) {
+                    target[c] = linearToSrgb(0.25f * (decode[texels[0][c]] + decode[texels[1][c]] + decode[texels[2][c]] + decode[texels[3][c]]));
+                }
+                target[3] = static_cast<unsigned char>((texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2) / 4);
+            }
+        }
+        level.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+    if (!out) {
+        throw std::runtime_error("Erro ao gravar arquivo: " + path);
+    }
+}
+
+bool isPaged(const char* data, std::size_t size) {
+    return size >= kPagedHeaderBytes && std::memcmp(data, kPagedMagic, sizeof(kPagedMagic)) == 0;
+}
+
+PageLayout parsePages(const char* data, std::size_t size, const std::string& path) {
+    if (!isPaged(data, size)) {
+        throw std::runtime_error("Textura paginada invalida: " + path);
+    }
+
+    std::uint32_t header[5] = {};
+    std::memcpy(header, data + 8, sizeof(header));
+    if (header[0] == 0 || header[0] > 4096 || header[1] > header[0] || header[2] == 0 || header[3] == 0 || header[4] == 0 ||
+        header[4] > static_cast<std::uint32_t>(kMaxPagedLevels)) {
+        throw std::runtime_error("Textura paginada invalida: " + path);
+    }
+
+    PageLayout layout;
+    layout.pageSize = static_cast<int>(header[0]);
+    layout.border = static_cast<int>(header[1]);
+    layout.imageWidth = static_cast<int>(header[2]);
+    layout.imageHeight = static_cast<int>(header[3]);
+    layout.levelCount = static_cast<int>(header[4]);
+    if (layout.imageWidth > layout.virtualSize() || layout.imageHeight > layout.virtualSize() || size < layout.fileBytes()) {
+        throw std::runtime_error("Textura paginada invalida: " + path);
+    }
+    return layout;
+}
+
+}  // namespace texcook
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cooked texture file: the 8-byte magic "TUBETX01", then little-endian
+// uint32 format, level-0 width and height and level count, then one entry
+// per level, level 0 first: uint64 offset and size in bytes, uint32 width
+// and height. Level data starts at 16-byte aligned offsets and is stored
+// exactly as glTexImage2D or glCompressedTexImage2D takes it, RGB rows
+// tightly packed.
+namespace texcook {
+
+enum class Format : std::uint32_t {
+    Rgb8 = 0,
+    Rgba8 = 1,
+    // 8 bytes per 4x4 block, opaque.
+    Bc1 = 2,
+    // 16 bytes per 4x4 block, with interpolated alpha.
+    Bc3 = 3,
+};
+
+struct Level {
+    int width = 0;
+    int height = 0;
+    std::size_t offset = 0;
+    std::size_t size = 0;
+};
+
+struct Layout {
+    Format format = Format::Rgba8;
+    // Level 0 first, each next one half the size down to 1x1.
+    std::vector<Level> levels;
+};
+
+// A layout together with the bytes its offsets point into.
+struct MipChain {
+    Layout layout;
+    std::vector<unsigned char> pixels;
+};
+
+[[nodiscard]] bool compressed(Format format);
+[[nodiscard]] int bytesPerPixel(Format format);
+[[nodiscard]] int blockBytes(Format format);
+[[nodiscard]] std::size_t levelBytes(Format format, int width, int height);
+
+// Box-filters 3- or 4-channel 8-bit texels down to 1x1. Colour is averaged
+// in linear light and stored as sRGB again, so mips keep their brightness;
+// alpha is averaged as is.
+MipChain buildMipChain(const unsigned char* pixels, int width, int height, int channels);
+// BC1 for RGB chains, BC3 for RGBA ones.
+MipChain compress(const MipChain& chain);
+
+// "wall.jpg" is cooked to "wall.ttx" next to it.
+[[nodiscard]] std::string cookedPath(const std::string& sourcePath);
+
+void write(const std::string& path, const MipChain& chain);
+[[nodiscard]] bool isCooked(const char* data, std::size_t size);
+// Throws when the header or level table does not fit the data.
+Layout parse(const char* data, std::size_t size, const std::string& path);
+
+// Paged texture file, for virtual texturing: the 8-byte magic "TUBEVT01",
+// then little-endian uint32 page size, border, image width and height and
+// level count, padding to 32 bytes and the pages. Level 0 is square,
+// pageSize << (levelCount - 1) texels on a side with the image in its
+// top-left corner, and every next level halves it down to a single page.
+// Pages are stored level 0 first, row by row, each one RGBA8 texels of
+// pageSize + 2 * border on a side, the border repeating its neighbours so
+// bilinear filtering never reads another page.
+struct PageLayout {
+    int pageSize = 0;
+    int border = 0;
+    int imageWidth = 0;
+    int imageHeight = 0;
+    int levelCount = 0;
+
+    [[nodiscard]] int pagesPerSide(int level) const;
+    // Level 0 texels on a side.
+    [[nodiscard]] int virtualSize() const;
+    // Texels on a side of a stored page.
+    [[nodiscard]] int storedSize() const;
+    [[nodiscard]] std::size_t pageBytes() const;
+    [[nodiscard]] std::size_t pageOffset(int level, int x, int y) const;
+    [[nodiscard]] std::size_t fileBytes() const;
+};
+
+// Cuts a 3- or 4-channel 8-bit image and its sRGB-correct mips into pages,
+// holding only one level in memory at a time.
+void writePages(
+    const std::string& path,
+    const unsigned char* pixels,
+    int width,
+    int height,
+    int channels,
+    int pageSize,
+    int border
+);
+[[nodiscard]] bool isPaged(const char* data, std::size_t size);
+// Throws when the header does not fit the data.
+PageLayout parsePages(const char* data, std::size_t size, const std::string& path);
+
+}  // namespace texcook
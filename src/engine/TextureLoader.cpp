@@ -0,0 +1,243 @@
+#include "engine/TextureLoader.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "app_config.hpp"
+#include "engine/ImageDecoder.h"
+#include "engine/MappedFile.h"
+#include "engine/TextureCook.h"
+
+namespace {
+
+void assignLevels(TextureUploader::Job& job, const texcook::Layout& layout, const unsigned char* data, std::shared_ptr<const void> storage) {
+    TextureUploader::Job levels = TextureUploader::cookedJob(layout, data, std::move(storage), 0, layout.levels.size());
+    levels.texture = job.texture;
+    levels.generation = job.generation;
+    job = std::move(levels);
+}
+
+// The mapped levels go to the GPU as stored, without a copy.
+bool loadCooked(const std::string& path, bool compressedFormats, TextureUploader::Job& job) {
+    std::shared_ptr<MappedFile> file;
+    try {
+        file = std::make_shared<MappedFile>(path);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    if (!texcook::isCooked(file->data(), file->size())) {
+        return false;
+    }
+
+    try {
+        const texcook::Layout layout = texcook::parse(file->data(), file->size(), path);
+        if (texcook::compressed(layout.format) && !compressedFormats) {
+            std::cerr << "Textura comprimida sem suporte a S3TC: " << path << '\n';
+            return false;
+        }
+        const auto* data = reinterpret_cast<const unsigned char*>(file->data());
+        assignLevels(job, layout, data, std::move(file));
+        return true;
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << '\n';
+        return false;
+    }
+}
+
+void decode(const std::string& path, TextureUploader::Job& job) {
+    DecodedImage image;
+    if (!ImageDecoders::shared().decode(path, image)) {
+        return;
+    }
+
+    auto chain = std::make_shared<texcook::MipChain>(texcook::buildMipChain(image.pixels.data(), image.width, image.height, image.channels));
+    assignLevels(job, chain->layout, chain->pixels.data(), chain);
+}
+
+}  // namespace
+
+TextureLoader::TextureLoader(std::size_t workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&TextureLoader::run, this);
+    }
+}
+
+TextureLoader::~TextureLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    jobAvailable_.notify_all();
+
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void TextureLoader::request(GLuint texture, const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Requests come from the GL thread, so this is where to ask.
+        if (!formatsChecked_) {
+            s3tc_ = TextureUploader::supports(texcook::Format::Bc1);
+            formatsChecked_ = true;
+        }
+        const std::uint64_t generation = nextGeneration_++;
+        requests_[texture] = generation;
+        jobs_.push_back({texture, generation, path});
+    }
+    jobAvailable_.notify_one();
+}
+
+void TextureLoader::cancel(GLuint texture) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.erase(texture);
+}
+
+void TextureLoader::pump(std::size_t budgetBytes, double budgetSeconds) {
+    if (!uploader_.initialized()) {
+        uploader_.initialize(app::kTextureUploadBuffers, app::kTextureUploadBufferBytes);
+    }
+
+    std::deque<Image> images;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        images.swap(images_);
+    }
+    for (Image& image : images) {
+        // A failed decode keeps the white placeholder.
+        if (image.job.levels.empty()) {
+            std::cerr << "Erro ao carregar textura: " << image.path << '\n';
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto found = requests_.find(image.job.texture);
+            if (found != requests_.end() && found->second == image.job.generation) {
+                requests_.erase(found);
+            }
+            continue;
+        }
+        uploader_.enqueue(std::move(image.job));
+    }
+
+    uploader_.pump(
+        budgetBytes,
+        budgetSeconds,
+        [this](const TextureUploader::Job& job) {
+            return current(job.texture, job.generation);
+        },
+        [this](const TextureUploader::Job& job) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto found = requests_.find(job.texture);
+            if (found != requests_.end() && found->second == job.generation) {
+                requests_.erase(found);
+            }
+        }
+    );
+}
+
+void TextureLoader::finish() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            imageAvailable_.wait(lock, [this]() {
+                return requests_.empty() || !images_.empty() || !uploader_.idle();
+            });
+            if (requests_.empty()) {
+                return;
+            }
+        }
+        pump();
+        // Every buffer may still be in flight; let the GPU catch up.
+        if (!uploader_.idle()) {
+            glFinish();
+        }
+    }
+}
+
+bool TextureLoader::pending(GLuint texture) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_.count(texture) != 0;
+}
+
+std::size_t TextureLoader::pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_.size();
+}
+
+bool TextureLoader::current(GLuint texture, std::uint64_t generation) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto found = requests_.find(texture);
+    return found != requests_.end() && found->second == generation;
+}
+
+TextureLoader& TextureLoader::shared() {
+    static TextureLoader loader;
+    return loader;
+}
+
+void TextureLoader::run() {
+    currentPool() = this;
+    for (;;) {
+        Job job;
+        std::function<void()> task;
+        bool compressedFormats = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobAvailable_.wait(lock, [this]() {
+                return stop_ || !jobs_.empty() || !tasks_.empty();
+            });
+            if (stop_) {
+                return;
+            }
+            // Another worker is waiting on these, so they go first.
+            if (!tasks_.empty()) {
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            } else {
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+                compressedFormats = s3tc_;
+
+                // Superseded or cancelled before a worker got to it.
+                const auto found = requests_.find(job.texture);
+                if (found == requests_.end() || found->second != job.generation) {
+                    continue;
+                }
+            }
+        }
+        if (task) {
+            task();
+            continue;
+        }
+
+        Image image;
+        image.path = std::move(job.path);
+        image.job.texture = job.texture;
+        image.job.generation = job.generation;
+        const std::string cooked = texcook::cookedPath(image.path);
+        if (!loadCooked(cooked, compressedFormats, image.job) && cooked != image.path) {
+            decode(image.path, image.job);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            images_.push_back(std::move(image));
+        }
+        imageAvailable_.notify_all();
+    }
+}
+
+void TextureLoader::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    jobAvailable_.notify_one();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/Parallel.h"
+#include "engine/TextureUploader.h"
+
+// Decodes image files and builds their mip chains on a pool of worker
+// threads, one per core. A cooked sibling ("wall.ttx" for "wall.jpg") is
+// memory-mapped and used as stored instead. Decoded images wait until
+// pump() streams them into the texture they were requested for through a
+// TextureUploader, which has to happen on the thread that owns the GL
+// context. The workers are a TaskPool: a decode that splits its work with
+// parallelFor, such as the restart-interval JPEG decoder, shares it with
+// whichever workers are idle, and idle workers take those tasks before new
+// files.
+class TextureLoader : private TaskPool {
+public:
+    // A workerCount of zero uses every hardware thread.
+    explicit TextureLoader(std::size_t workerCount = 0);
+    ~TextureLoader();
+
+    // Workers refer back to the loader, so it stays in place.
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Replaces any request still outstanding for texture.
+    void request(GLuint texture, const std::string& path);
+    // Drops the outstanding request, if any; call before deleting texture.
+    void cancel(GLuint texture);
+
+    // Streams decoded images to the GPU within the given budgets.
+    void pump(
+        std::size_t budgetBytes = std::numeric_limits<std::size_t>::max(),
+        double budgetSeconds = std::numeric_limits<double>::infinity()
+    );
+    // Blocks until every outstanding request has been uploaded.
+    void finish();
+
+    [[nodiscard]] bool pending(GLuint texture) const;
+    [[nodiscard]] std::size_t pendingCount() const;
+
+    // The pool Texture loads through.
+    static TextureLoader& shared();
+
+private:
+    struct Job {
+        GLuint texture = 0;
+        std::uint64_t generation = 0;
+        std::string path;
+    };
+
+    struct Image {
+        std::string path;
+        // No levels when decoding failed.
+        TextureUploader::Job job;
+    };
+
+    void run();
+    void submit(std::function<void()> task) override;
+    [[nodiscard]] bool current(GLuint texture, std::uint64_t generation) const;
+
+    mutable std::mutex mutex_;
+    std::condition_variable jobAvailable_;
+    std::condition_variable imageAvailable_;
+    std::deque<Job> jobs_;
+    std::deque<std::function<void()>> tasks_;
+    std::deque<Image> images_;
+    // Latest generation requested per texture; results of older or
+    // cancelled requests are discarded.
+    std::unordered_map<GLuint, std::uint64_t> requests_;
+    std::uint64_t nextGeneration_ = 1;
+    bool formatsChecked_ = false;
+    bool s3tc_ = false;
+    bool stop_ = false;
+    std::vector<std::thread> workers_;
+
+    TextureUploader uploader_;
+};
@@ -0,0 +1,120 @@
+#include "engine/TextureRegistry.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+#include "engine/TextureCook.h"
+#include "engine/TextureStreamer.h"
+
+namespace {
+
+std::string canonicalPath(const std::string& path) {
+    std::error_code error;
+    const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    if (error) {
+        return std::filesystem::path(path).lexically_normal().string();
+    }
+    return canonical.string();
+}
+
+}  // namespace
+
+TextureRegistry::TextureRegistry(std::size_t budgetBytes) : budgetBytes_(budgetBytes) {}
+
+TextureHandle TextureRegistry::load(const std::string& path) {
+    const std::string key = canonicalPath(path);
+    const auto found = entries_.find(key);
+    if (found != entries_.end()) {
+        found->second.lastUse = ++useCounter_;
+        return found->second.texture;
+    }
+
+    // A cooked sibling is streamed level by level; anything else is loaded
+    // whole. Only the placeholder is resident until the image arrives; its
+    // real size is counted by collectGarbage().
+    auto texture = std::make_shared<Texture>();
+    if (!texture->stream(texcook::cookedPath(key))) {
+        texture->load(key);
+    }
+    const std::size_t bytes = texture->gpuBytes();
+    entries_.emplace(key, Entry{texture, bytes, ++useCounter_, false});
+    residentBytes_ += bytes;
+    return texture;
+}
+
+void TextureRegistry::setBudget(std::size_t budgetBytes) {
+    budgetBytes_ = budgetBytes;
+    collectGarbage();
+}
+
+void TextureRegistry::collectGarbage() {
+    refreshSizes();
+    evictUnreferenced(budgetBytes_);
+}
+
+void TextureRegistry::clear() {
+    entries_.clear();
+    residentBytes_ = 0;
+}
+
+std::size_t TextureRegistry::residentBytes() const {
+    return residentBytes_;
+}
+
+std::size_t TextureRegistry::bytes(const std::string& path) const {
+    const auto found = entries_.find(canonicalPath(path));
+    return found != entries_.end() ? found->second.bytes : 0;
+}
+
+std::size_t TextureRegistry::size() const {
+    return entries_.size();
+}
+
+void TextureRegistry::refreshSizes() {
+    for (auto& [key, entry] : entries_) {
+        if (entry.texture->streamed()) {
+            // Never settles: levels come and go with the camera.
+            const std::size_t bytes = TextureStreamer::shared().residentBytes(entry.texture->id());
+            residentBytes_ = residentBytes_ - entry.bytes + bytes;
+            entry.bytes = bytes;
+            continue;
+        }
+        if (entry.settled || !entry.texture->ready()) {
+            continue;
+        }
+
+        const std::size_t bytes = entry.texture->gpuBytes();
+        residentBytes_ = residentBytes_ - entry.bytes + bytes;
+        entry.bytes = bytes;
+        entry.settled = true;
+    }
+}
+
+void TextureRegistry::evictUnreferenced(std::size_t targetBytes) {
+    if (residentBytes_ <= targetBytes) {
+        return;
+    }
+
+    std::vector<std::pair<std::uint64_t, std::string>> candidates;
+    for (const auto& [key, entry] : entries_) {
+        if (entry.texture.use_count() == 1) {
+            candidates.emplace_back(entry.lastUse, key);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    for (const auto& candidate : candidates) {
+        if (residentBytes_ <= targetBytes) {
+            break;
+        }
+
+        const auto entry = entries_.find(candidate.second);
+        residentBytes_ -= entry->second.bytes;
+        entries_.erase(entry);
+    }
+}
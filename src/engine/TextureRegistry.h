@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "app_config.hpp"
+#include "engine/Texture.h"
+
+using TextureHandle = std::shared_ptr<const Texture>;
+
+// Shares one GL texture per image file. Paths are canonicalized, so
+// "./wall.jpg" and "wall.jpg" load once. Textures nobody holds a handle to
+// stay cached until the resident set exceeds the budget, and are then
+// dropped least recently requested first.
+class TextureRegistry {
+public:
+    explicit TextureRegistry(std::size_t budgetBytes = app::kTextureCacheBudgetBytes);
+
+    TextureRegistry(const TextureRegistry&) = delete;
+    TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+    TextureHandle load(const std::string& path);
+
+    void setBudget(std::size_t budgetBytes);
+    // Picks up the real size of textures that finished loading since the
+    // last call, then evicts. Call once per frame on the GL thread.
+    void collectGarbage();
+    void clear();
+
+    [[nodiscard]] std::size_t residentBytes() const;
+    [[nodiscard]] std::size_t bytes(const std::string& path) const;
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<Texture> texture;
+        std::size_t bytes = 0;
+        std::uint64_t lastUse = 0;
+        // Whether bytes reflects the loaded image rather than the
+        // placeholder.
+        bool settled = false;
+    };
+
+    void refreshSizes();
+    void evictUnreferenced(std::size_t targetBytes);
+
+    std::unordered_map<std::string, Entry> entries_;
+    std::size_t budgetBytes_ = 0;
+    std::size_t residentBytes_ = 0;
+    std::uint64_t useCounter_ = 0;
+};
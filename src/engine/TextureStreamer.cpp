@@ -0,0 +1,218 @@
+#include "engine/TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+TextureStreamer::TextureStreamer(std::size_t budgetBytes, int tailSize)
+    : budgetBytes_(budgetBytes),
+      tailSize_(std::max(1, tailSize)) {}
+
+bool TextureStreamer::open(GLuint texture, const std::string& path) {
+    std::shared_ptr<MappedFile> file;
+    try {
+        file = std::make_shared<MappedFile>(path);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    if (!texcook::isCooked(file->data(), file->size())) {
+        return false;
+    }
+
+    Stream stream;
+    try {
+        stream.layout = texcook::parse(file->data(), file->size(), path);
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << '\n';
+        return false;
+    }
+    if (!TextureUploader::supports(stream.layout.format)) {
+        return false;
+    }
+    stream.file = std::move(file);
+
+    const auto levelCount = static_cast<int>(stream.layout.levels.size());
+    stream.tailLevel = levelCount - 1;
+    while (stream.tailLevel > 0) {
+        const texcook::Level& finer = stream.layout.levels[static_cast<std::size_t>(stream.tailLevel - 1)];
+        if (std::max(finer.width, finer.height) > tailSize_) {
+            break;
+        }
+        --stream.tailLevel;
+    }
+    stream.residentLevel = levelCount;
+    stream.wantedLevel = stream.tailLevel;
+
+    close(texture);
+    Stream& added = streams_.emplace(texture, std::move(stream)).first->second;
+    enqueue(texture, added, added.tailLevel);
+    return true;
+}
+
+void TextureStreamer::close(GLuint texture) {
+    const auto found = streams_.find(texture);
+    if (found == streams_.end()) {
+        return;
+    }
+    residentBytes_ -= found->second.residentBytes;
+    streams_.erase(found);
+}
+
+void TextureStreamer::request(GLuint texture, float uvPerPixel) {
+    const auto found = streams_.find(texture);
+    if (found == streams_.end()) {
+        return;
+    }
+
+    // Level l has 2^-l of level 0's texels along each axis.
+    Stream& stream = found->second;
+    const texcook::Level& base = stream.layout.levels.front();
+    const float texelsPerPixel = uvPerPixel * static_cast<float>(std::max(base.width, base.height));
+    const int level = texelsPerPixel > 1.0f ? static_cast<int>(std::floor(std::log2(texelsPerPixel))) : 0;
+    stream.wantedLevel = std::min(stream.wantedLevel, std::clamp(level, 0, stream.tailLevel));
+    stream.lastUse = frame_;
+}
+
+void TextureStreamer::update(std::size_t uploadBudgetBytes, double uploadBudgetSeconds) {
+    if (!uploader_.initialized()) {
+        uploader_.initialize(app::kTextureUploadBuffers, app::kTextureUploadBufferBytes);
+    }
+
+    // One level per texture at a time, furthest from what it needs first.
+    std::vector<std::pair<int, GLuint>> starving;
+    for (const auto& [texture, stream] : streams_) {
+        if (stream.loadingLevel < 0 && stream.wantedLevel < stream.residentLevel) {
+            starving.emplace_back(stream.residentLevel - stream.wantedLevel, texture);
+        }
+    }
+    std::sort(starving.begin(), starving.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+    for (const auto& [gap, texture] : starving) {
+        Stream& stream = streams_.at(texture);
+        const int level = stream.residentLevel - 1;
+        if (!makeRoom(stream.layout.levels[static_cast<std::size_t>(level)].size, texture)) {
+            break;
+        }
+        enqueue(texture, stream, level);
+    }
+
+    for (auto& [texture, stream] : streams_) {
+        stream.wantedLevel = stream.tailLevel;
+    }
+    ++frame_;
+
+    uploader_.pump(
+        uploadBudgetBytes,
+        uploadBudgetSeconds,
+        [this](const TextureUploader::Job& job) {
+            const auto found = streams_.find(job.texture);
+            return found != streams_.end() && found->second.generation == job.generation;
+        },
+        [this](const TextureUploader::Job& job) {
+            Stream& stream = streams_.at(job.texture);
+            stream.residentLevel = stream.loadingLevel;
+            stream.loadingLevel = -1;
+        }
+    );
+}
+
+void TextureStreamer::setBudget(std::size_t budgetBytes) {
+    budgetBytes_ = budgetBytes;
+}
+
+bool TextureStreamer::ready(GLuint texture) const {
+    const auto found = streams_.find(texture);
+    return found != streams_.end() && found->second.residentLevel <= found->second.tailLevel;
+}
+
+bool TextureStreamer::streamed(GLuint texture) const {
+    return streams_.count(texture) != 0;
+}
+
+int TextureStreamer::residentLevel(GLuint texture) const {
+    const auto found = streams_.find(texture);
+    if (found == streams_.end() || found->second.residentLevel > found->second.tailLevel) {
+        return -1;
+    }
+    return found->second.residentLevel;
+}
+
+std::size_t TextureStreamer::residentBytes(GLuint texture) const {
+    const auto found = streams_.find(texture);
+    return found != streams_.end() ? found->second.residentBytes : 0;
+}
+
+std::size_t TextureStreamer::residentBytes() const {
+    return residentBytes_;
+}
+
+TextureStreamer& TextureStreamer::shared() {
+    static TextureStreamer streamer;
+    return streamer;
+}
+
+void TextureStreamer::enqueue(GLuint texture, Stream& stream, int firstLevel) {
+    // The tail goes up as one job down to 1x1, finer levels one at a time.
+    const auto first = static_cast<std::size_t>(firstLevel);
+    const std::size_t count = firstLevel == stream.tailLevel && stream.residentLevel > stream.tailLevel
+        ? stream.layout.levels.size() - first
+        : 1;
+    const auto* data = reinterpret_cast<const unsigned char*>(stream.file->data());
+    TextureUploader::Job job = TextureUploader::cookedJob(stream.layout, data, stream.file, first, count);
+    job.texture = texture;
+    job.generation = nextGeneration_++;
+
+    // Bytes are counted from the moment they are scheduled, so the budget
+    // also covers uploads in flight.
+    for (const TextureUploader::Level& level : job.levels) {
+        stream.residentBytes += level.bytes;
+        residentBytes_ += level.bytes;
+    }
+    stream.generation = job.generation;
+    stream.loadingLevel = firstLevel;
+    uploader_.enqueue(std::move(job));
+}
+
+bool TextureStreamer::makeRoom(std::size_t bytes, GLuint exclude) {
+    while (residentBytes_ + bytes > budgetBytes_) {
+        // Textures asked for this frame only give up levels finer than
+        // they asked for.
+        GLuint victim = 0;
+        Stream* victimStream = nullptr;
+        for (auto& [texture, stream] : streams_) {
+            if (texture == exclude || stream.loadingLevel >= 0 || stream.residentLevel >= stream.tailLevel) {
+                continue;
+            }
+            if (stream.lastUse == frame_ && stream.residentLevel >= stream.wantedLevel) {
+                continue;
+            }
+            if (victimStream == nullptr || stream.lastUse < victimStream->lastUse) {
+                victim = texture;
+                victimStream = &stream;
+            }
+        }
+        if (victimStream == nullptr) {
+            return false;
+        }
+        dropLevel(victim, *victimStream);
+    }
+    return true;
+}
+
+void TextureStreamer::dropLevel(GLuint texture, Stream& stream) {
+    // Sampling moves to the next coarser level first; redefining the old
+    // one as empty then releases its storage.
+    const int level = stream.residentLevel;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    const std::size_t bytes = stream.layout.levels[static_cast<std::size_t>(level)].size;
+    stream.residentBytes -= bytes;
+    residentBytes_ -= bytes;
+    stream.residentLevel = level + 1;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "app_config.hpp"
+#include "engine/MappedFile.h"
+#include "engine/TextureCook.h"
+#include "engine/TextureUploader.h"
+
+// Keeps only the mip levels of cooked textures that are actually visible
+// resident. Opening a texture uploads its coarse tail, the levels no larger
+// than tailSize. Each frame callers report how many texture coordinates a
+// pixel spans for every texture they draw; textures then gain finer levels
+// one at a time, the most starved first, straight from the memory-mapped
+// file. When the next level would exceed the budget, the finest level of
+// the least recently needed texture that has more detail than it uses is
+// dropped first, and the load waits if there is none. The tail is never
+// dropped. All calls belong on the GL thread.
+class TextureStreamer {
+public:
+    explicit TextureStreamer(
+        std::size_t budgetBytes = app::kTextureStreamBudgetBytes,
+        int tailSize = app::kTextureStreamTailSize
+    );
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Takes over texture's storage. False when path is not a cooked file
+    // this context can sample.
+    bool open(GLuint texture, const std::string& path);
+    // Forgets texture; call before deleting it.
+    void close(GLuint texture);
+
+    // Asks for the level that keeps one texel per pixel when a pixel
+    // spans uvPerPixel texture coordinates. Valid until the next update().
+    void request(GLuint texture, float uvPerPixel);
+    // Schedules loads and drops for this frame's requests, then streams
+    // within the given upload budgets.
+    void update(std::size_t uploadBudgetBytes, double uploadBudgetSeconds);
+
+    void setBudget(std::size_t budgetBytes);
+
+    // True once the tail has arrived.
+    [[nodiscard]] bool ready(GLuint texture) const;
+    [[nodiscard]] bool streamed(GLuint texture) const;
+    // Finest level sampled, or -1 before the tail has arrived.
+    [[nodiscard]] int residentLevel(GLuint texture) const;
+    [[nodiscard]] std::size_t residentBytes(GLuint texture) const;
+    // Includes levels still being uploaded.
+    [[nodiscard]] std::size_t residentBytes() const;
+
+    // The streamer Texture streams through.
+    static TextureStreamer& shared();
+
+private:
+    struct Stream {
+        std::shared_ptr<MappedFile> file;
+        texcook::Layout layout;
+        // Levels from here to the last are always resident.
+        int tailLevel = 0;
+        // Finest level uploaded; the level count while the tail loads.
+        int residentLevel = 0;
+        int loadingLevel = -1;
+        std::uint64_t generation = 0;
+        // Finest level asked for since the last update().
+        int wantedLevel = 0;
+        std::uint64_t lastUse = 0;
+        std::size_t residentBytes = 0;
+    };
+
+    void enqueue(GLuint texture, Stream& stream, int firstLevel);
+    [[nodiscard]] bool makeRoom(std::size_t bytes, GLuint exclude);
+    void dropLevel(GLuint texture, Stream& stream);
+
+    std::unordered_map<GLuint, Stream> streams_;
+    std::size_t budgetBytes_ = 0;
+    int tailSize_ = 1;
+    std::size_t residentBytes_ = 0;
+    std::uint64_t frame_ = 1;
+    std::uint64_t nextGeneration_ = 1;
+    TextureUploader uploader_;
+};
@@ -0,0 +1,340 @@
+#include "engine/TextureUploader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "engine/GlUtil.h"
+
+namespace {
+
+// GL_EXT_texture_compression_s3tc, which glad does not load.
+constexpr GLenum kCompressedRgbS3tcDxt1 = 0x83F0;
+constexpr GLenum kCompressedRgbaS3tcDxt5 = 0x83F3;
+
+// Bytes in one slice row: a row of texels, or of 4x4 blocks.
+std::size_t sliceRowBytes(const TextureUploader::Job& job, const TextureUploader::Level& level) {
+    if (job.blockBytes > 0) {
+        return static_cast<std::size_t>((level.width + 3) / 4) * static_cast<std::size_t>(job.blockBytes);
+    }
+    return static_cast<std::size_t>(level.width) * static_cast<std::size_t>(job.bytesPerPixel);
+}
+
+int sliceRows(const TextureUploader::Job& job, const TextureUploader::Level& level) {
+    return job.blockBytes > 0 ? (level.height + 3) / 4 : level.height;
+}
+
+int texelRows(const TextureUploader::Job& job) {
+    return job.blockBytes > 0 ? 4 : 1;
+}
+
+}  // namespace
+
+TextureUploader::~TextureUploader() {
+    release();
+}
+
+TextureUploader::TextureUploader(TextureUploader&& other) noexcept
+    : buffers_(std::move(other.buffers_)),
+      bufferBytes_(other.bufferBytes_),
+      nextBuffer_(other.nextBuffer_),
+      jobs_(std::move(other.jobs_)),
+      queuedBytes_(other.queuedBytes_),
+      started_(other.started_),
+      level_(other.level_),
+      row_(other.row_) {
+    other.buffers_.clear();
+    other.queuedBytes_ = 0;
+    other.started_ = false;
+}
+
+TextureUploader& TextureUploader::operator=(TextureUploader&& other) noexcept {
+    if (this != &other) {
+        release();
+        buffers_ = std::move(other.buffers_);
+        bufferBytes_ = other.bufferBytes_;
+        nextBuffer_ = other.nextBuffer_;
+        jobs_ = std::move(other.jobs_);
+        queuedBytes_ = other.queuedBytes_;
+        started_ = other.started_;
+        level_ = other.level_;
+        row_ = other.row_;
+
+        other.buffers_.clear();
+        other.queuedBytes_ = 0;
+        other.started_ = false;
+    }
+    return *this;
+}
+
+void TextureUploader::initialize(std::size_t bufferCount, std::size_t bufferBytes) {
+    release();
+
+    // Slices are whole rows, so a buffer must hold the widest possible one.
+    bufferBytes_ = std::max<std::size_t>(bufferBytes, 16384u * 4u);
+    buffers_.resize(std::max<std::size_t>(bufferCount, 2));
+    for (Buffer& buffer : buffers_) {
+        glGenBuffers(1, &buffer.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bufferBytes_), nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    nextBuffer_ = 0;
+}
+
+void TextureUploader::enqueue(Job job) {
+    for (const Level& level : job.levels) {
+        queuedBytes_ += level.bytes;
+    }
+    jobs_.push_back(std::move(job));
+}
+
+void TextureUploader::pump(
+    std::size_t budgetBytes,
+    double budgetSeconds,
+    const std::function<bool(const Job&)>& current,
+    const std::function<void(const Job&)>& finished
+) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto elapsed = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::size_t uploaded = 0;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    while (!jobs_.empty() && !buffers_.empty() && uploaded < budgetBytes && elapsed() < budgetSeconds) {
+        Job& job = jobs_.front();
+        if (job.levels.empty() || !current(job)) {
+            // Levels finer than level_ are still queued, coarser ones gone.
+            for (std::size_t i = 0; i < job.levels.size(); ++i) {
+                if (!started_ || i < level_) {
+                    queuedBytes_ -= job.levels[i].bytes;
+                } else if (i == level_) {
+                    queuedBytes_ -= job.levels[i].bytes - sliceRowBytes(job, job.levels[i]) * static_cast<std::size_t>(row_);
+                }
+            }
+            jobs_.pop_front();
+            started_ = false;
+            continue;
+        }
+
+        if (!acquireBuffer()) {
+            break;
+        }
+
+        if (!started_) {
+            if (!job.subImage) {
+                beginJob(job);
+            }
+            started_ = true;
+            level_ = job.levels.size() - 1;
+            row_ = 0;
+        }
+
+        // As many whole rows of the current level as fit in one buffer.
+        const Level& level = job.levels[level_];
+        const std::size_t rowBytes = sliceRowBytes(job, level);
+        const int levelRows = sliceRows(job, level);
+        const int rows = std::clamp(
+            static_cast<int>(std::min(bufferBytes_, budgetBytes - uploaded) / rowBytes),
+            1,
+            std::max(1, static_cast<int>(bufferBytes_ / rowBytes))
+        );
+        const int rowCount = std::min(rows, levelRows - row_);
+        const std::size_t bytes = rowBytes * static_cast<std::size_t>(rowCount);
+
+        Buffer& buffer = buffers_[nextBuffer_];
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+        void* mapped = glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER,
+            0,
+            static_cast<GLsizeiptr>(bytes),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+        );
+        if (mapped == nullptr) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            break;
+        }
+        std::memcpy(mapped, level.pixels + rowBytes * static_cast<std::size_t>(row_), bytes);
+        const bool intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+
+        // A lost store leaves the slice undefined; it is simply sent again.
+        if (intact) {
+            const int y = row_ * texelRows(job);
+            const int height = std::min(rowCount * texelRows(job), level.height - y);
+            glBindTexture(GL_TEXTURE_2D, job.texture);
+            if (job.blockBytes > 0) {
+                glCompressedTexSubImage2D(
+                    GL_TEXTURE_2D,
+                    job.firstLevel + static_cast<GLint>(level_),
+                    job.offsetX,
+                    job.offsetY + y,
+                    level.width,
+                    height,
+                    job.format,
+                    static_cast<GLsizei>(bytes),
+                    nullptr
+                );
+            } else {
+                glTexSubImage2D(
+                    GL_TEXTURE_2D,
+                    job.firstLevel + static_cast<GLint>(level_),
+                    job.offsetX,
+                    job.offsetY + y,
+                    level.width,
+                    height,
+                    job.format,
+                    GL_UNSIGNED_BYTE,
+                    nullptr
+                );
+            }
+            buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            row_ += rowCount;
+            queuedBytes_ -= bytes;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        nextBuffer_ = (nextBuffer_ + 1) % buffers_.size();
+        uploaded += bytes;
+
+        if (row_ < levelRows) {
+            continue;
+        }
+
+        // The finished level becomes the finest one sampled.
+        if (!job.subImage) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job.firstLevel + static_cast<GLint>(level_));
+        }
+        row_ = 0;
+        if (level_ > 0) {
+            --level_;
+            continue;
+        }
+
+        finished(job);
+        jobs_.pop_front();
+        started_ = false;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+bool TextureUploader::initialized() const {
+    return !buffers_.empty();
+}
+
+bool TextureUploader::idle() const {
+    return jobs_.empty();
+}
+
+std::size_t TextureUploader::queuedBytes() const {
+    return queuedBytes_;
+}
+
+TextureUploader::Job TextureUploader::cookedJob(
+    const texcook::Layout& layout,
+    const unsigned char* data,
+    std::shared_ptr<const void> storage,
+    std::size_t first,
+    std::size_t count
+) {
+    Job job;
+    switch (layout.format) {
+        case texcook::Format::Rgb8:
+            job.format = GL_RGB;
+            break;
+        case texcook::Format::Rgba8:
+            job.format = GL_RGBA;
+            break;
+        case texcook::Format::Bc1:
+            job.format = kCompressedRgbS3tcDxt1;
+            break;
+        case texcook::Format::Bc3:
+            job.format = kCompressedRgbaS3tcDxt5;
+            break;
+    }
+    job.bytesPerPixel = texcook::bytesPerPixel(layout.format);
+    job.blockBytes = texcook::compressed(layout.format) ? texcook::blockBytes(layout.format) : 0;
+    job.firstLevel = static_cast<GLint>(first);
+    for (std::size_t i = first; i < first + count; ++i) {
+        const texcook::Level& level = layout.levels[i];
+        job.levels.push_back({level.width, level.height, data + level.offset, level.size});
+    }
+    job.storage = std::move(storage);
+    return job;
+}
+
+bool TextureUploader::supports(texcook::Format format) {
+    static const bool s3tc = glutil::hasExtension("GL_EXT_texture_compression_s3tc");
+    return !texcook::compressed(format) || s3tc;
+}
+
+void TextureUploader::release() {
+    for (Buffer& buffer : buffers_) {
+        if (buffer.fence != nullptr) {
+            glDeleteSync(buffer.fence);
+        }
+        if (buffer.buffer != 0) {
+            glDeleteBuffers(1, &buffer.buffer);
+        }
+    }
+    buffers_.clear();
+}
+
+bool TextureUploader::acquireBuffer() {
+    Buffer& buffer = buffers_[nextBuffer_];
+    if (buffer.fence == nullptr) {
+        return true;
+    }
+
+    // A zero timeout only polls; the flush makes sure the fence is
+    // submitted and can eventually signal.
+    const GLenum status = glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+        return false;
+    }
+    glDeleteSync(buffer.fence);
+    buffer.fence = nullptr;
+    return true;
+}
+
+void TextureUploader::beginJob(const Job& job) const {
+    // Storage for every level is defined up front so the texture stays
+    // complete; only the coarsest is sampled until finer ones arrive.
+    // No unpack buffer may be bound, or the null pointers become offsets.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, job.texture);
+    for (std::size_t i = 0; i < job.levels.size(); ++i) {
+        const GLint level = job.firstLevel + static_cast<GLint>(i);
+        if (job.blockBytes > 0) {
+            glCompressedTexImage2D(
+                GL_TEXTURE_2D,
+                level,
+                job.format,
+                job.levels[i].width,
+                job.levels[i].height,
+                0,
+                static_cast<GLsizei>(job.levels[i].bytes),
+                nullptr
+            );
+            continue;
+        }
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            level,
+            static_cast<GLint>(job.format),
+            job.levels[i].width,
+            job.levels[i].height,
+            0,
+            job.format,
+            GL_UNSIGNED_BYTE,
+            nullptr
+        );
+    }
+    // A refinement keeps sampling the levels already there until it is done.
+    const Level& last = job.levels.back();
+    if (last.width == 1 && last.height == 1) {
+        const GLint lastLevel = job.firstLevel + static_cast<GLint>(job.levels.size() - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, lastLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+    }
+}
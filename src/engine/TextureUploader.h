@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "engine/TextureCook.h"
+
+// Streams texel data into textures through a ring of pixel unpack buffers,
+// a few rows at a time. Each buffer is fenced after its copy is issued and
+// is only refilled once the GPU has consumed it, so pump() never waits on
+// the driver: when the next buffer is still busy it simply stops for this
+// frame. Levels go coarsest first and the texture's base level follows
+// them, so a texture sharpens as it streams in instead of showing
+// undefined texels. All calls belong on the GL thread.
+class TextureUploader {
+public:
+    struct Level {
+        int width = 0;
+        int height = 0;
+        const unsigned char* pixels = nullptr;
+        std::size_t bytes = 0;
+    };
+
+    struct Job {
+        GLuint texture = 0;
+        std::uint64_t generation = 0;
+        GLenum format = GL_RGBA;
+        int bytesPerPixel = 4;
+        // Nonzero for block-compressed formats, which go up in rows of
+        // 4x4 blocks through glCompressedTexSubImage2D.
+        int blockBytes = 0;
+        // levels[i] is GL level firstLevel + i, each next one half the
+        // size. A job that reaches 1x1 defines the whole tail and resets
+        // the sampled range to it; others refine an existing texture.
+        GLint firstLevel = 0;
+        std::vector<Level> levels;
+        // Fills the levels at (offsetX, offsetY) of an existing image, such
+        // as a slot of an atlas, instead of defining them; the sampled range
+        // is left alone.
+        bool subImage = false;
+        int offsetX = 0;
+        int offsetY = 0;
+        // Keeps the memory the levels point into alive.
+        std::shared_ptr<const void> storage;
+    };
+
+    TextureUploader() = default;
+    ~TextureUploader();
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+    TextureUploader(TextureUploader&& other) noexcept;
+    TextureUploader& operator=(TextureUploader&& other) noexcept;
+
+    void initialize(std::size_t bufferCount, std::size_t bufferBytes);
+    void enqueue(Job job);
+
+    // Uploads until budgetBytes or budgetSeconds is spent or the next buffer
+    // is still in use. Jobs for which current() turns false are dropped
+    // before their next slice; finished() is called for each completed job.
+    void pump(
+        std::size_t budgetBytes,
+        double budgetSeconds,
+        const std::function<bool(const Job&)>& current,
+        const std::function<void(const Job&)>& finished
+    );
+
+    [[nodiscard]] bool initialized() const;
+    [[nodiscard]] bool idle() const;
+    [[nodiscard]] std::size_t queuedBytes() const;
+
+    // Levels [first, first + count) of a cooked layout whose offsets are
+    // relative to data.
+    static Job cookedJob(
+        const texcook::Layout& layout,
+        const unsigned char* data,
+        std::shared_ptr<const void> storage,
+        std::size_t first,
+        std::size_t count
+    );
+    // Whether the context can sample format; compressed formats need
+    // GL_EXT_texture_compression_s3tc. The first call must come from the GL
+    // thread.
+    static bool supports(texcook::Format format);
+
+private:
+    struct Buffer {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+    };
+
+    void release();
+    [[nodiscard]] bool acquireBuffer();
+    void beginJob(const Job& job) const;
+
+    std::vector<Buffer> buffers_;
+    std::size_t bufferBytes_ = 0;
+    std::size_t nextBuffer_ = 0;
+
+    std::deque<Job> jobs_;
+    std::size_t queuedBytes_ = 0;
+    // Progress through jobs_.front(): the level being uploaded and the next
+    // row of it. level_ counts down from the coarsest level.
+    bool started_ = false;
+    std::size_t level_ = 0;
+    int row_ = 0;
+};
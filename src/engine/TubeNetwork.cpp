@@ -0,0 +1,550 @@
+#include "engine/TubeNetwork.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "app_config.hpp"
+#include "engine/Capsule.h"
+
+namespace {
+
+constexpr float kPi = 3.14159265359f;
+constexpr std::size_t kTreeFanOut = 4;
+
+// Vertex layout matches the object meshes: aPos is the offset in radius
+// units in the segment frame (x, y radial, z along the axis), aNormal the
+// local normal and aTexCoord.y selects the start (0) or end (1) point.
+Mesh createUnitCapsule(int radialSegments, int capStacks) {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    const int rows = 2 * (capStacks + 1);
+    vertices.reserve(static_cast<std::size_t>(rows * (radialSegments + 1)) * app::kVertexStrideFloats);
+    indices.reserve(static_cast<std::size_t>((rows - 1) * radialSegments) * 6);
+
+    for (int row = 0; row < rows; ++row) {
+        const bool endCap = row > capStacks;
+        const int capRow = endCap ? row - (capStacks + 1) : capStacks - row;
+        const float phi = static_cast<float>(capRow) / static_cast<float>(std::max(capStacks, 1)) * (kPi / 2.0f);
+        const float ringScale = capStacks == 0 ? 1.0f : std::cos(phi);
+        const float axial = capStacks == 0 ? 0.0f : (endCap ? std::sin(phi) : -std::sin(phi));
+
+        for (int segment = 0; segment <= radialSegments; ++segment) {
+            const float theta = 2.0f * kPi * static_cast<float>(segment) / static_cast<float>(radialSegments);
+            const float x = ringScale * std::cos(theta);
+            const float y = ringScale * std::sin(theta);
+
+            vertices.insert(vertices.end(), {
+                x, y, axial,
+                x, y, axial,
+                static_cast<float>(segment) / static_cast<float>(radialSegments),
+                endCap ? 1.0f : 0.0f,
+            });
+        }
+    }
+
+    for (int row = 0; row + 1 < rows; ++row) {
+        const auto current = static_cast<unsigned int>(row * (radialSegments + 1));
+        const auto next = static_cast<unsigned int>(current + radialSegments + 1);
+
+        for (unsigned int segment = 0; segment < static_cast<unsigned int>(radialSegments); ++segment) {
+            indices.insert(indices.end(), {
+                current + segment, current + segment + 1, next + segment + 1,
+                current + segment, next + segment + 1, next + segment,
+            });
+        }
+    }
+
+    return Mesh::createFromRaw(
+        vertices.data(),
+        vertices.size() * sizeof(float),
+        indices.data(),
+        indices.size() * sizeof(unsigned int),
+        true
+    );
+}
+
+// Oriented box around the capsule (radius units across, one extra radius
+// past each end) that the impostor shader ray casts against.
+Mesh createProxyBox() {
+    std::vector<float> vertices;
+    for (int corner = 0; corner < 8; ++corner) {
+        const float x = (corner & 1) != 0 ? 1.0f : -1.0f;
+        const float y = (corner & 2) != 0 ? 1.0f : -1.0f;
+        const bool endPoint = (corner & 4) != 0;
+        const float z = endPoint ? 1.0f : -1.0f;
+
+        vertices.insert(vertices.end(), {
+            x, y, z,
+            0.0f, 0.0f, 0.0f,
+            0.0f, endPoint ? 1.0f : 0.0f,
+        });
+    }
+
+    const unsigned int indices[] = {
+        0, 2, 3, 0, 3, 1,
+        4, 5, 7, 4, 7, 6,
+        0, 1, 5, 0, 5, 4,
+        2, 6, 7, 2, 7, 3,
+        0, 4, 6, 0, 6, 2,
+        1, 3, 7, 1, 7, 5,
+    };
+
+    return Mesh::createFromRaw(
+        vertices.data(),
+        vertices.size() * sizeof(float),
+        indices,
+        sizeof(indices),
+        true
+    );
+}
+
+Mesh createLineMesh() {
+    const float vertices[] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+    };
+    const unsigned int indices[] = {0, 1};
+    return Mesh::createFromRaw(vertices, sizeof(vertices), indices, sizeof(indices), true);
+}
+
+glm::vec3 unpackColor(std::uint32_t color) {
+    return glm::vec3(
+        static_cast<float>(color & 0xffu),
+        static_cast<float>((color >> 8) & 0xffu),
+        static_cast<float>((color >> 16) & 0xffu)
+    ) / 255.0f;
+}
+
+float distanceToBox(const glm::vec3& point, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    return glm::length(point - glm::clamp(point, boundsMin, boundsMax));
+}
+
+}  // namespace
+
+TubeNetwork::~TubeNetwork() {
+    release();
+}
+
+TubeNetwork::TubeNetwork(TubeNetwork&& other) noexcept
+    : unitMesh_(std::move(other.unitMesh_)),
+      proxyMesh_(std::move(other.proxyMesh_)),
+      lineMesh_(std::move(other.lineMesh_)),
+      instanceVbo_(other.instanceVbo_),
+      aggregateVbo_(other.aggregateVbo_),
+      segmentCount_(other.segmentCount_),
+      capacity_(other.capacity_),
+      segmentsPerCluster_(other.segmentsPerCluster_),
+      clusters_(std::move(other.clusters_)),
+      coverage_(std::move(other.coverage_)),
+      levels_(std::move(other.levels_)),
+      selectedAggregates_(std::move(other.selectedAggregates_)) {
+    other.instanceVbo_ = 0;
+    other.aggregateVbo_ = 0;
+    other.segmentCount_ = 0;
+    other.capacity_ = 0;
+}
+
+TubeNetwork& TubeNetwork::operator=(TubeNetwork&& other) noexcept {
+    if (this != &other) {
+        release();
+        unitMesh_ = std::move(other.unitMesh_);
+        proxyMesh_ = std::move(other.proxyMesh_);
+        lineMesh_ = std::move(other.lineMesh_);
+        instanceVbo_ = other.instanceVbo_;
+        aggregateVbo_ = other.aggregateVbo_;
+        segmentCount_ = other.segmentCount_;
+        capacity_ = other.capacity_;
+        segmentsPerCluster_ = other.segmentsPerCluster_;
+        clusters_ = std::move(other.clusters_);
+        coverage_ = std::move(other.coverage_);
+        levels_ = std::move(other.levels_);
+        selectedAggregates_ = std::move(other.selectedAggregates_);
+
+        other.instanceVbo_ = 0;
+        other.aggregateVbo_ = 0;
+        other.segmentCount_ = 0;
+        other.capacity_ = 0;
+    }
+    return *this;
+}
+
+void TubeNetwork::initialize(int radialSegments, int capStacks, std::size_t segmentsPerCluster) {
+    release();
+    unitMesh_ = createUnitCapsule(radialSegments, capStacks);
+    proxyMesh_ = createProxyBox();
+    lineMesh_ = createLineMesh();
+    segmentsPerCluster_ = std::max<std::size_t>(1, segmentsPerCluster);
+    glGenBuffers(1, &instanceVbo_);
+    glGenBuffers(1, &aggregateVbo_);
+}
+
+void TubeNetwork::setSegments(const TubeSegment* segments, std::size_t count) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        static_cast<GLsizeiptr>(count * sizeof(TubeSegment)),
+        segments,
+        GL_STATIC_DRAW
+    );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    segmentCount_ = 0;
+    capacity_ = count;
+    clusters_.clear();
+    coverage_.clear();
+    appendClusters(segments, count);
+    updateTree(0, clusters_.size());
+}
+
+void TubeNetwork::appendSegments(const TubeSegment* segments, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // The instance buffer grows geometrically and keeps its contents, so
+    // streamed data is uploaded once.
+    const std::size_t required = segmentCount_ + count;
+    if (required > capacity_) {
+        const std::size_t capacity = std::max(required, capacity_ * 2);
+        GLuint grown = 0;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(TubeSegment)), nullptr, GL_DYNAMIC_DRAW);
+        if (segmentCount_ > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, instanceVbo_);
+            glCopyBufferSubData(
+                GL_COPY_READ_BUFFER,
+                GL_COPY_WRITE_BUFFER,
+                0,
+                0,
+                static_cast<GLsizeiptr>(segmentCount_ * sizeof(TubeSegment))
+            );
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        glDeleteBuffers(1, &instanceVbo_);
+        instanceVbo_ = grown;
+        capacity_ = capacity;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    glBufferSubData(
+        GL_ARRAY_BUFFER,
+        static_cast<GLintptr>(segmentCount_ * sizeof(TubeSegment)),
+        static_cast<GLsizeiptr>(count * sizeof(TubeSegment)),
+        segments
+    );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The last cluster may have been filled further; everything before it
+    // keeps its nodes.
+    const std::size_t firstChanged = clusters_.empty() ? 0 : clusters_.size() - 1;
+    appendClusters(segments, count);
+    updateTree(firstChanged, clusters_.size());
+}
+
+void TubeNetwork::updateSegments(std::size_t first, const TubeSegment* segments, std::size_t count) {
+    if (first >= segmentCount_ || count == 0) {
+        return;
+    }
+    count = std::min(count, segmentCount_ - first);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    glBufferSubData(
+        GL_ARRAY_BUFFER,
+        static_cast<GLintptr>(first * sizeof(TubeSegment)),
+        static_cast<GLsizeiptr>(count * sizeof(TubeSegment)),
+        segments
+    );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Bounds only grow here; moved segments keep the cluster conservative.
+    for (std::size_t i = 0; i < count; ++i) {
+        growCluster(clusters_[(first + i) / segmentsPerCluster_], segments[i]);
+    }
+    updateTree(first / segmentsPerCluster_, (first + count - 1) / segmentsPerCluster_ + 1);
+}
+
+void TubeNetwork::selectLods(const Camera& camera, const Frustum& frustum, const TubeLodPolicy& policy) {
+    selectedAggregates_.clear();
+    if (levels_.empty()) {
+        return;
+    }
+
+    selectNode(levels_.size() - 1, 0, camera, frustum, policy);
+
+    glBindBuffer(GL_ARRAY_BUFFER, aggregateVbo_);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        static_cast<GLsizeiptr>(selectedAggregates_.size() * sizeof(TubeSegment)),
+        selectedAggregates_.data(),
+        GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TubeNetwork::draw(TubeLod lod) const {
+    if (lod == TubeLod::Culled) {
+        return;
+    }
+
+    const Mesh& mesh = lod == TubeLod::Impostor ? proxyMesh_ : (lod == TubeLod::Lines ? lineMesh_ : unitMesh_);
+    const GLenum mode = lod == TubeLod::Lines ? GL_LINES : GL_TRIANGLES;
+
+    // Neighbouring clusters are contiguous in the instance buffer, so runs
+    // with the same LOD collapse into a single instanced draw.
+    for (std::size_t i = 0; i < clusters_.size();) {
+        if (clusters_[i].lod != lod) {
+            ++i;
+            continue;
+        }
+
+        const std::size_t first = clusters_[i].first;
+        std::size_t count = 0;
+        for (; i < clusters_.size() && clusters_[i].lod == lod; ++i) {
+            count += clusters_[i].count;
+        }
+
+        bindInstances(mesh, instanceVbo_, first);
+        mesh.drawInstanced(static_cast<GLsizei>(count), mode);
+    }
+}
+
+void TubeNetwork::drawAggregates() const {
+    if (selectedAggregates_.empty()) {
+        return;
+    }
+
+    bindInstances(proxyMesh_, aggregateVbo_, 0);
+    proxyMesh_.drawInstanced(static_cast<GLsizei>(selectedAggregates_.size()));
+}
+
+std::size_t TubeNetwork::segmentCount() const {
+    return segmentCount_;
+}
+
+std::size_t TubeNetwork::gpuBytes() const {
+    std::size_t nodes = 0;
+    for (const std::vector<Node>& level : levels_) {
+        nodes += level.size();
+    }
+    return unitMesh_.gpuBytes() + proxyMesh_.gpuBytes() + lineMesh_.gpuBytes()
+           + (capacity_ + nodes) * sizeof(TubeSegment);
+}
+
+std::uint32_t TubeNetwork::packColor(const glm::vec3& color) {
+    const auto channel = [](float value) {
+        return static_cast<std::uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+    return channel(color.r) | (channel(color.g) << 8) | (channel(color.b) << 16) | (255u << 24);
+}
+
+void TubeNetwork::growCluster(Cluster& cluster, const TubeSegment& segment) const {
+    const glm::vec3 extent(segment.radius);
+    cluster.boundsMin = glm::min(cluster.boundsMin, glm::min(segment.start, segment.end) - extent);
+    cluster.boundsMax = glm::max(cluster.boundsMax, glm::max(segment.start, segment.end) + extent);
+    cluster.maxRadius = std::max(cluster.maxRadius, segment.radius);
+}
+
+// Fills the last cluster before opening new ones, so appending in several
+// calls yields the same clusters as one setSegments call.
+void TubeNetwork::appendClusters(const TubeSegment* segments, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (clusters_.empty() || clusters_.back().count == segmentsPerCluster_) {
+            Cluster cluster;
+            cluster.first = segmentCount_ + i;
+            cluster.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+            cluster.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+            clusters_.push_back(cluster);
+            coverage_.emplace_back();
+        }
+
+        const TubeSegment& segment = segments[i];
+        Cluster& cluster = clusters_.back();
+        growCluster(cluster, segment);
+        ++cluster.count;
+
+        Coverage& coverage = coverage_.back();
+        const float area = 2.0f * segment.radius * (glm::length(segment.end - segment.start) + segment.radius);
+        coverage.area += area;
+        coverage.color += area * unpackColor(segment.color);
+    }
+    segmentCount_ += count;
+}
+
+void TubeNetwork::updateTree(std::size_t firstCluster, std::size_t endCluster) {
+    std::size_t count = clusters_.size();
+    if (count == 0) {
+        levels_.clear();
+        return;
+    }
+
+    std::size_t first = firstCluster;
+    std::size_t end = std::min(endCluster, count);
+    for (std::size_t level = 0;; ++level) {
+        if (level == levels_.size()) {
+            levels_.emplace_back();
+        }
+        levels_[level].resize(count);
+        for (std::size_t i = first; i < end; ++i) {
+            refreshNode(level, i);
+        }
+
+        if (count == 1) {
+            levels_.resize(level + 1);
+            return;
+        }
+        // A parent is refitted whole, so its untouched children count too.
+        first /= kTreeFanOut;
+        end = (end + kTreeFanOut - 1) / kTreeFanOut;
+        count = (count + kTreeFanOut - 1) / kTreeFanOut;
+    }
+}
+
+// Leaves take their cluster's bounds, which already include the radii;
+// parents enclose their children's capsules, so every aggregate holds all
+// of its segments. Aggregates are tinted with the area-weighted colour of
+// the segments they replace.
+void TubeNetwork::refreshNode(std::size_t level, std::size_t index) {
+    Node& node = levels_[level][index];
+    std::vector<Capsule> children;
+    if (level == 0) {
+        const Cluster& cluster = clusters_[index];
+        node.firstCluster = index;
+        node.clusterCount = 1;
+        node.boundsMin = cluster.boundsMin;
+        node.boundsMax = cluster.boundsMax;
+        node.coverage = coverage_[index];
+    } else {
+        const std::vector<Node>& below = levels_[level - 1];
+        const std::size_t childBegin = index * kTreeFanOut;
+        const std::size_t childEnd = std::min(below.size(), childBegin + kTreeFanOut);
+        node.firstCluster = below[childBegin].firstCluster;
+        node.clusterCount = 0;
+        node.boundsMin = below[childBegin].boundsMin;
+        node.boundsMax = below[childBegin].boundsMax;
+        node.coverage = {};
+        for (std::size_t child = childBegin; child < childEnd; ++child) {
+            const Node& childNode = below[child];
+            node.clusterCount += childNode.clusterCount;
+            node.boundsMin = glm::min(node.boundsMin, childNode.boundsMin);
+            node.boundsMax = glm::max(node.boundsMax, childNode.boundsMax);
+            node.coverage.area += childNode.coverage.area;
+            node.coverage.color += childNode.coverage.color;
+            children.push_back({childNode.aggregate.start, childNode.aggregate.end, childNode.aggregate.radius});
+        }
+    }
+
+    const Capsule capsule = enclosingCapsule(node.boundsMin, node.boundsMax, children.data(), children.size());
+    node.aggregate.start = capsule.start;
+    node.aggregate.end = capsule.end;
+    node.aggregate.radius = std::max(capsule.radius, 1.0e-4f);
+    const glm::vec3 color = node.coverage.area > 0.0f ? node.coverage.color / node.coverage.area : glm::vec3(0.5f);
+    node.aggregate.color = TubeNetwork::packColor(color);
+}
+
+void TubeNetwork::selectNode(
+    std::size_t level,
+    std::size_t index,
+    const Camera& camera,
+    const Frustum& frustum,
+    const TubeLodPolicy& policy
+) {
+    const Node& node = levels_[level][index];
+    const auto hideClusters = [this, &node]() {
+        for (std::size_t i = 0; i < node.clusterCount; ++i) {
+            clusters_[node.firstCluster + i].lod = TubeLod::Culled;
+        }
+    };
+
+    if (!frustum.intersectsBox(node.boundsMin, node.boundsMax)) {
+        hideClusters();
+        return;
+    }
+
+    if (level == 0) {
+        selectCluster(clusters_[node.firstCluster], camera, policy);
+        return;
+    }
+
+    const float distance = distanceToBox(camera.position(), node.boundsMin, node.boundsMax);
+    const float pixelSize = glm::length(node.boundsMax - node.boundsMin) * camera.pixelsPerUnit(distance);
+    if (pixelSize < policy.aggregateBelowPixels) {
+        hideClusters();
+        selectedAggregates_.push_back(node.aggregate);
+        return;
+    }
+
+    const std::size_t childBegin = index * kTreeFanOut;
+    const std::size_t childEnd = std::min(levels_[level - 1].size(), childBegin + kTreeFanOut);
+    for (std::size_t child = childBegin; child < childEnd; ++child) {
+        selectNode(level - 1, child, camera, frustum, policy);
+    }
+}
+
+void TubeNetwork::selectCluster(Cluster& cluster, const Camera& camera, const TubeLodPolicy& policy) const {
+    const float distance = distanceToBox(camera.position(), cluster.boundsMin, cluster.boundsMax);
+    const float pixelRadius = cluster.maxRadius * camera.pixelsPerUnit(distance);
+
+    if (pixelRadius < policy.linesBelowPixels) {
+        cluster.lod = TubeLod::Lines;
+    } else if (policy.impostorsOnly || pixelRadius < policy.impostorBelowPixels) {
+        cluster.lod = TubeLod::Impostor;
+    } else {
+        cluster.lod = TubeLod::Geometry;
+    }
+}
+
+// GL 3.3 has no base-instance draws, so the instance attributes are
+// re-pointed at the first instance of every run instead.
+void TubeNetwork::bindInstances(const Mesh& mesh, GLuint buffer, std::size_t firstInstance) const {
+    constexpr auto stride = static_cast<GLsizei>(sizeof(TubeSegment));
+    const std::size_t base = firstInstance * sizeof(TubeSegment);
+
+    glBindVertexArray(mesh.vertexArray());
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(base + offsetof(TubeSegment, start)));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(base + offsetof(TubeSegment, end)));
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+
+    glVertexAttribPointer(
+        5,
+        4,
+        GL_UNSIGNED_BYTE,
+        GL_TRUE,
+        stride,
+        reinterpret_cast<void*>(base + offsetof(TubeSegment, color))
+    );
+    glEnableVertexAttribArray(5);
+    glVertexAttribDivisor(5, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TubeNetwork::release() {
+    if (instanceVbo_ != 0) {
+        glDeleteBuffers(1, &instanceVbo_);
+        instanceVbo_ = 0;
+    }
+    if (aggregateVbo_ != 0) {
+        glDeleteBuffers(1, &aggregateVbo_);
+        aggregateVbo_ = 0;
+    }
+    segmentCount_ = 0;
+    capacity_ = 0;
+    clusters_.clear();
+    coverage_.clear();
+    levels_.clear();
+    selectedAggregates_.clear();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "engine/Camera.h"
+#include "engine/Frustum.h"
+#include "engine/Mesh.h"
+
+struct TubeSegment {
+    glm::vec3 start;
+    float radius;
+    glm::vec3 end;
+    // RGBA8, red in the lowest byte.
+    std::uint32_t color;
+};
+
+static_assert(sizeof(TubeSegment) == 32, "TubeSegment is uploaded verbatim as instance data");
+
+enum class TubeLod {
+    Culled,
+    Geometry,
+    Impostor,
+    Lines,
+};
+
+struct TubeLodPolicy {
+    // Clusters whose thickest pipe projects below this radius are ray cast.
+    float impostorBelowPixels = 4.0f;
+    bool impostorsOnly = false;
+    // Below this projected radius segments become coverage-weighted lines.
+    float linesBelowPixels = 0.75f;
+    // Tree nodes whose bounds project smaller than this are replaced by
+    // one capsule enclosing all of their segments.
+    float aggregateBelowPixels = 24.0f;
+};
+
+class TubeNetwork {
+public:
+    TubeNetwork() = default;
+    ~TubeNetwork();
+
+    TubeNetwork(const TubeNetwork&) = delete;
+    TubeNetwork& operator=(const TubeNetwork&) = delete;
+    TubeNetwork(TubeNetwork&& other) noexcept;
+    TubeNetwork& operator=(TubeNetwork&& other) noexcept;
+
+    // The shared mesh is a unit capsule: a radialSegments-sided cylinder with
+    // hemispherical caps, so segments meeting at a joint blend into a round
+    // elbow instead of leaving a wedge-shaped gap.
+    void initialize(int radialSegments, int capStacks, std::size_t segmentsPerCluster);
+    // Clusters and the LOD tree group consecutive segments, so the input
+    // should be spatially coherent (e.g. ordered along routes).
+    void setSegments(const TubeSegment* segments, std::size_t count);
+    // Adds segments after the existing ones, e.g. while a dataset streams
+    // in; drawing can continue between calls.
+    void appendSegments(const TubeSegment* segments, std::size_t count);
+    void updateSegments(std::size_t first, const TubeSegment* segments, std::size_t count);
+
+    void selectLods(const Camera& camera, const Frustum& frustum, const TubeLodPolicy& policy);
+    void draw(TubeLod lod) const;
+    // Draws the aggregate capsules chosen by the last selectLods call; they
+    // use the impostor shader.
+    void drawAggregates() const;
+
+    [[nodiscard]] std::size_t segmentCount() const;
+    [[nodiscard]] std::size_t gpuBytes() const;
+
+    [[nodiscard]] static std::uint32_t packColor(const glm::vec3& color);
+
+private:
+    struct Cluster {
+        std::size_t first = 0;
+        std::size_t count = 0;
+        glm::vec3 boundsMin{0.0f};
+        glm::vec3 boundsMax{0.0f};
+        float maxRadius = 0.0f;
+        TubeLod lod = TubeLod::Geometry;
+    };
+
+    struct Coverage {
+        float area = 0.0f;
+        glm::vec3 color{0.0f};
+    };
+
+    // Node of the fan-out tree over consecutive clusters; it carries a
+    // single capsule standing in for all of its segments.
+    struct Node {
+        std::size_t firstCluster = 0;
+        std::size_t clusterCount = 0;
+        glm::vec3 boundsMin{0.0f};
+        glm::vec3 boundsMax{0.0f};
+        Coverage coverage;
+        TubeSegment aggregate{};
+    };
+
+    void growCluster(Cluster& cluster, const TubeSegment& segment) const;
+    void appendClusters(const TubeSegment* segments, std::size_t count);
+    // Refits the nodes over clusters [firstCluster, endCluster) and their
+    // ancestors, adding or dropping levels as the cluster count requires.
+    void updateTree(std::size_t firstCluster, std::size_t endCluster);
+    void refreshNode(std::size_t level, std::size_t index);
+    void selectNode(
+        std::size_t level,
+        std::size_t index,
+        const Camera& camera,
+        const Frustum& frustum,
+        const TubeLodPolicy& policy
+    );
+    void selectCluster(Cluster& cluster, const Camera& camera, const TubeLodPolicy& policy) const;
+    void bindInstances(const Mesh& mesh, GLuint buffer, std::size_t firstInstance) const;
+    void release();
+
+    Mesh unitMesh_;
+    Mesh proxyMesh_;
+    Mesh lineMesh_;
+    GLuint instanceVbo_ = 0;
+    GLuint aggregateVbo_ = 0;
+    std::size_t segmentCount_ = 0;
+    std::size_t capacity_ = 0;
+    std::size_t segmentsPerCluster_ = 1;
+    std::vector<Cluster> clusters_;
+    std::vector<Coverage> coverage_;
+    // The tree level by level: levels_[0] maps one-to-one onto clusters,
+    // node i of a level has children [i * fan-out, (i + 1) * fan-out) on
+    // the one below, and the last level holds only the root. Appending
+    // clusters only touches the tail of each level.
+    std::vector<std::vector<Node>> levels_;
+    std::vector<TubeSegment> selectedAggregates_;
+};
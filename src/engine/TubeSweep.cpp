@@ -0,0 +1,321 @@
+#include "engine/TubeSweep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "app_config.hpp"
+#include "engine/MeshKernels.h"
+#include "engine/Parallel.h"
+
+namespace meshgen {
+
+namespace {
+
+constexpr float kDegenerateLengthSquared = 1.0e-12f;
+constexpr std::size_t kMinPointsPerBatch = 16384;
+
+glm::vec3 pathTangent(const std::vector<glm::vec3>& points, std::size_t index) {
+    const std::size_t previous = index == 0 ? 0 : index - 1;
+    const std::size_t next = std::min(index + 1, points.size() - 1);
+    glm::vec3 direction = points[next] - points[previous];
+
+    if (glm::dot(direction, direction) < kDegenerateLengthSquared) {
+        direction = points[next] - points[index];
+    }
+    if (glm::dot(direction, direction) < kDegenerateLengthSquared) {
+        direction = points[index] - points[previous];
+    }
+    if (glm::dot(direction, direction) < kDegenerateLengthSquared) {
+        return {0.0f, 0.0f, 1.0f};
+    }
+    return glm::normalize(direction);
+}
+
+glm::vec3 anyPerpendicular(const glm::vec3& tangent) {
+    const glm::vec3 axis = std::fabs(tangent.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    return glm::normalize(glm::cross(glm::cross(tangent, axis), tangent));
+}
+
+glm::vec3 reflectAcross(const glm::vec3& value, const glm::vec3& axis, float axisLengthSquared) {
+    return value - (2.0f / axisLengthSquared) * glm::dot(axis, value) * axis;
+}
+
+glm::vec3 transportNormal(
+    const glm::vec3& fromPoint,
+    const glm::vec3& toPoint,
+    const glm::vec3& fromTangent,
+    const glm::vec3& toTangent,
+    const glm::vec3& normal
+) {
+    const glm::vec3 step = toPoint - fromPoint;
+    const float stepLengthSquared = glm::dot(step, step);
+
+    glm::vec3 reflectedNormal = normal;
+    glm::vec3 reflectedTangent = fromTangent;
+    if (stepLengthSquared >= kDegenerateLengthSquared) {
+        reflectedNormal = reflectAcross(normal, step, stepLengthSquared);
+        reflectedTangent = reflectAcross(fromTangent, step, stepLengthSquared);
+    }
+
+    const glm::vec3 correction = toTangent - reflectedTangent;
+    const float correctionLengthSquared = glm::dot(correction, correction);
+    glm::vec3 result = correctionLengthSquared >= kDegenerateLengthSquared
+        ? reflectAcross(reflectedNormal, correction, correctionLengthSquared)
+        : reflectedNormal;
+
+    result -= glm::dot(result, toTangent) * toTangent;
+    const float resultLengthSquared = glm::dot(result, result);
+    return resultLengthSquared >= kDegenerateLengthSquared ? result / std::sqrt(resultLengthSquared)
+                                                           : anyPerpendicular(toTangent);
+}
+
+glm::vec3 catmullRomPoint(
+    const glm::vec3& p0,
+    const glm::vec3& p1,
+    const glm::vec3& p2,
+    const glm::vec3& p3,
+    float t
+) {
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+                   + (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+}  // namespace
+
+float SweepPath::radiusAt(std::size_t index) const {
+    if (radii.empty()) {
+        return 1.0f;
+    }
+    return radii.size() == 1 ? radii.front() : radii[std::min(index, radii.size() - 1)];
+}
+
+SweepPath catmullRom(const SweepPath& path, int subdivisions) {
+    if (subdivisions <= 0 || path.points.size() < 2) {
+        return path;
+    }
+
+    const std::size_t spanCount = path.points.size() - 1;
+    const auto samplesPerSpan = static_cast<std::size_t>(subdivisions) + 1;
+    const bool perPointRadius = path.radii.size() > 1;
+
+    SweepPath result;
+    result.points.resize(spanCount * samplesPerSpan + 1);
+    result.radii.resize(perPointRadius ? result.points.size() : path.radii.size());
+    if (!perPointRadius && !path.radii.empty()) {
+        result.radii.front() = path.radii.front();
+    }
+
+    parallelFor(spanCount, kMinPointsPerBatch / samplesPerSpan + 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t span = begin; span < end; ++span) {
+            const glm::vec3& p0 = path.points[span == 0 ? 0 : span - 1];
+            const glm::vec3& p1 = path.points[span];
+            const glm::vec3& p2 = path.points[span + 1];
+            const glm::vec3& p3 = path.points[std::min(span + 2, path.points.size() - 1)];
+
+            for (std::size_t sample = 0; sample < samplesPerSpan; ++sample) {
+                const float t = static_cast<float>(sample) / static_cast<float>(samplesPerSpan);
+                const std::size_t out = span * samplesPerSpan + sample;
+                result.points[out] = catmullRomPoint(p0, p1, p2, p3, t);
+                if (perPointRadius) {
+                    result.radii[out] = path.radiusAt(span) + (path.radiusAt(span + 1) - path.radiusAt(span)) * t;
+                }
+            }
+        }
+    });
+
+    result.points.back() = path.points.back();
+    if (perPointRadius) {
+        result.radii.back() = path.radii.back();
+    }
+    return result;
+}
+
+std::vector<SweepFrame> computeFrames(const std::vector<glm::vec3>& points, std::size_t pointsPerChunk) {
+    std::vector<SweepFrame> frames(points.size());
+    if (points.empty()) {
+        return frames;
+    }
+
+    pointsPerChunk = std::max<std::size_t>(2, pointsPerChunk);
+    const std::size_t chunkCount = (points.size() + pointsPerChunk - 1) / pointsPerChunk;
+
+    parallelFor(chunkCount, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t chunk = begin; chunk < end; ++chunk) {
+            const std::size_t first = chunk * pointsPerChunk;
+            const std::size_t last = std::min(points.size(), first + pointsPerChunk);
+
+            frames[first].tangent = pathTangent(points, first);
+            frames[first].normal = anyPerpendicular(frames[first].tangent);
+
+            for (std::size_t i = first + 1; i < last; ++i) {
+                frames[i].tangent = pathTangent(points, i);
+                frames[i].normal = transportNormal(
+                    points[i - 1],
+                    points[i],
+                    frames[i - 1].tangent,
+                    frames[i].tangent,
+                    frames[i - 1].normal
+                );
+            }
+        }
+    });
+
+    // Transport is a rotation, so a chunk started from the wrong normal is
+    // off by one constant twist angle; find it from the previous chunk.
+    std::vector<float> twist(chunkCount, 0.0f);
+    for (std::size_t chunk = 1; chunk < chunkCount; ++chunk) {
+        const std::size_t first = chunk * pointsPerChunk;
+        const SweepFrame& previous = frames[first - 1];
+        const float previousTwist = twist[chunk - 1];
+        const glm::vec3 previousNormal = std::cos(previousTwist) * previous.normal
+                                         + std::sin(previousTwist) * glm::cross(previous.tangent, previous.normal);
+
+        const glm::vec3 expected = transportNormal(
+            points[first - 1],
+            points[first],
+            previous.tangent,
+            frames[first].tangent,
+            previousNormal
+        );
+        const glm::vec3& local = frames[first].normal;
+        twist[chunk] = std::atan2(glm::dot(glm::cross(local, expected), frames[first].tangent), glm::dot(local, expected));
+    }
+
+    parallelFor(chunkCount, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t chunk = begin; chunk < end; ++chunk) {
+            const std::size_t first = chunk * pointsPerChunk;
+            const std::size_t last = std::min(points.size(), first + pointsPerChunk);
+            const float c = std::cos(twist[chunk]);
+            const float s = std::sin(twist[chunk]);
+
+            for (std::size_t i = first; i < last; ++i) {
+                SweepFrame& frame = frames[i];
+                frame.normal = c * frame.normal + s * glm::cross(frame.tangent, frame.normal);
+                frame.binormal = glm::cross(frame.tangent, frame.normal);
+            }
+        }
+    });
+
+    return frames;
+}
+
+std::vector<float> arcLengths(const std::vector<glm::vec3>& points) {
+    std::vector<float> lengths(points.size(), 0.0f);
+    double total = 0.0;
+    for (std::size_t i = 1; i < points.size(); ++i) {
+        total += static_cast<double>(glm::length(points[i] - points[i - 1]));
+        lengths[i] = static_cast<float>(total);
+    }
+    return lengths;
+}
+
+SweptChunk buildSweepChunk(
+    const SweepPath& path,
+    const std::vector<SweepFrame>& frames,
+    const std::vector<float>& lengths,
+    std::size_t firstPoint,
+    std::size_t lastPoint,
+    int radialSegments,
+    float textureLength
+) {
+    SweptChunk chunk;
+    chunk.firstPoint = firstPoint;
+    chunk.lastPoint = lastPoint;
+
+    const auto ringSize = static_cast<std::size_t>(radialSegments) + 1;
+    const std::size_t ringCount = lastPoint - firstPoint + 1;
+    constexpr std::size_t kStride = app::kVertexStrideFloats;
+
+    std::vector<float> cosRing(ringSize);
+    std::vector<float> sinRing(ringSize);
+    computeRing(radialSegments, cosRing.data(), sinRing.data());
+
+    chunk.vertices.resize(ringCount * ringSize * kStride);
+    chunk.indices.resize((ringCount - 1) * static_cast<std::size_t>(radialSegments) * 6);
+    chunk.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    chunk.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+
+    const float vScale = textureLength > 0.0f ? 1.0f / textureLength : 1.0f;
+    const float repeatOrigin = std::floor(lengths[firstPoint] * vScale);
+    float* out = chunk.vertices.data();
+
+    for (std::size_t ring = 0; ring < ringCount; ++ring) {
+        const std::size_t point = firstPoint + ring;
+        const SweepFrame& frame = frames[point];
+        const glm::vec3& center = path.points[point];
+        const float radius = path.radiusAt(point);
+        const float v = lengths[point] * vScale - repeatOrigin;
+
+        for (std::size_t j = 0; j < ringSize; ++j, out += kStride) {
+            const glm::vec3 normal = cosRing[j] * frame.normal + sinRing[j] * frame.binormal;
+            const glm::vec3 position = center + radius * normal;
+            out[0] = position.x;
+            out[1] = position.y;
+            out[2] = position.z;
+            out[3] = normal.x;
+            out[4] = normal.y;
+            out[5] = normal.z;
+            out[6] = static_cast<float>(j) / static_cast<float>(radialSegments);
+            out[7] = v;
+        }
+
+        chunk.boundsMin = glm::min(chunk.boundsMin, center - glm::vec3(radius));
+        chunk.boundsMax = glm::max(chunk.boundsMax, center + glm::vec3(radius));
+    }
+
+    unsigned int* index = chunk.indices.data();
+    for (std::size_t ring = 0; ring + 1 < ringCount; ++ring) {
+        const auto base = static_cast<unsigned int>(ring * ringSize);
+        const auto next = static_cast<unsigned int>(base + ringSize);
+
+        for (unsigned int j = 0; j < static_cast<unsigned int>(radialSegments); ++j) {
+            *index++ = base + j;
+            *index++ = base + j + 1;
+            *index++ = next + j + 1;
+            *index++ = base + j;
+            *index++ = next + j + 1;
+            *index++ = next + j;
+        }
+    }
+
+    return chunk;
+}
+
+std::vector<SweptChunk> sweepTube(const SweepPath& input, const SweepOptions& options) {
+    const SweepPath path = catmullRom(input, options.splineSubdivisions);
+    if (path.points.size() < 2 || options.radialSegments < 3) {
+        return {};
+    }
+
+    const std::size_t pointsPerChunk = std::max<std::size_t>(2, options.pointsPerChunk);
+    const std::vector<SweepFrame> frames = computeFrames(path.points, pointsPerChunk);
+    const std::vector<float> lengths = arcLengths(path.points);
+
+    const std::size_t spanCount = path.points.size() - 1;
+    const std::size_t spansPerChunk = pointsPerChunk - 1;
+    const std::size_t chunkCount = (spanCount + spansPerChunk - 1) / spansPerChunk;
+    std::vector<SweptChunk> chunks(chunkCount);
+
+    parallelFor(chunkCount, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t chunk = begin; chunk < end; ++chunk) {
+            const std::size_t first = chunk * spansPerChunk;
+            const std::size_t last = std::min(spanCount, first + spansPerChunk);
+            chunks[chunk] = buildSweepChunk(
+                path,
+                frames,
+                lengths,
+                first,
+                last,
+                options.radialSegments,
+                options.textureLength
+            );
+        }
+    });
+
+    return chunks;
+}
+
+}  // namespace meshgen
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace meshgen {
+
+struct SweepPath {
+    std::vector<glm::vec3> points;
+    // One radius per point; a single entry applies to the whole path.
+    std::vector<float> radii;
+
+    [[nodiscard]] float radiusAt(std::size_t index) const;
+};
+
+struct SweepFrame {
+    glm::vec3 tangent;
+    glm::vec3 normal;
+    glm::vec3 binormal;
+};
+
+struct SweepOptions {
+    int radialSegments = 12;
+    std::size_t pointsPerChunk = 4096;
+    // Catmull-Rom samples inserted between consecutive input points.
+    int splineSubdivisions = 0;
+    // World units of path length per texture repeat along the tube.
+    float textureLength = 1.0f;
+};
+
+struct SweptChunk {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    glm::vec3 boundsMin{0.0f};
+    glm::vec3 boundsMax{0.0f};
+    std::size_t firstPoint = 0;
+    std::size_t lastPoint = 0;
+};
+
+[[nodiscard]] SweepPath catmullRom(const SweepPath& path, int subdivisions);
+
+// Rotation-minimizing frames (double reflection) computed per chunk in
+// parallel and then rotated so the frames agree across chunk boundaries.
+[[nodiscard]] std::vector<SweepFrame> computeFrames(
+    const std::vector<glm::vec3>& points,
+    std::size_t pointsPerChunk
+);
+
+[[nodiscard]] std::vector<float> arcLengths(const std::vector<glm::vec3>& points);
+
+// Emits the ring sweep for points [firstPoint, lastPoint] inclusive using the
+// kVertexStrideFloats position/normal/texcoord layout.
+[[nodiscard]] SweptChunk buildSweepChunk(
+    const SweepPath& path,
+    const std::vector<SweepFrame>& frames,
+    const std::vector<float>& lengths,
+    std::size_t firstPoint,
+    std::size_t lastPoint,
+    int radialSegments,
+    float textureLength
+);
+
+// Consecutive chunks share their boundary ring so each one is a closed,
+// independently drawable and cullable mesh.
+[[nodiscard]] std::vector<SweptChunk> sweepTube(const SweepPath& path, const SweepOptions& options);
+
+}  // namespace meshgen
@@ -0,0 +1,51 @@
+#include "engine/TubeTessellation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace meshgen {
+
+std::vector<std::size_t> placeRings(
+    const SweepPath& path,
+    const std::vector<SweepFrame>& frames,
+    const RingPlacement& placement
+) {
+    std::vector<std::size_t> rings;
+    if (path.points.empty()) {
+        return rings;
+    }
+
+    rings.push_back(0);
+    float turned = 0.0f;
+    float travelled = 0.0f;
+    float ringRadius = path.radiusAt(0);
+
+    for (std::size_t i = 1; i + 1 < path.points.size(); ++i) {
+        const float cosTurn = std::clamp(glm::dot(frames[i - 1].tangent, frames[i].tangent), -1.0f, 1.0f);
+        turned += std::acos(cosTurn);
+        travelled += glm::length(path.points[i] - path.points[i - 1]);
+
+        const float radius = path.radiusAt(i);
+        const float radiusChange = std::fabs(radius - ringRadius) / std::max(ringRadius, 1.0e-6f);
+
+        if (turned >= placement.maxTurnAngle
+            || travelled >= placement.maxSpacing
+            || radiusChange >= placement.radiusTolerance) {
+            rings.push_back(i);
+            turned = 0.0f;
+            travelled = 0.0f;
+            ringRadius = radius;
+        }
+    }
+
+    if (path.points.size() > 1) {
+        rings.push_back(path.points.size() - 1);
+    }
+    return rings;
+}
+
+float ringSagitta(float radius, int radialSegments) {
+    return radius * (1.0f - std::cos(3.14159265359f / static_cast<float>(std::max(radialSegments, 3))));
+}
+
+}  // namespace meshgen
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "engine/TubeSweep.h"
+
+namespace meshgen {
+
+struct RingPlacement {
+    // Turning angle (radians) accumulated before a new ring is forced.
+    float maxTurnAngle = 0.08f;
+    // Longest straight run covered by a single pair of rings.
+    float maxSpacing = 4.0f;
+    // Relative radius change that forces a ring.
+    float radiusTolerance = 0.05f;
+};
+
+// Picks the path points that become rings: dense through bends and radius
+// changes, sparse on straight runs. Always keeps the first and last point.
+[[nodiscard]] std::vector<std::size_t> placeRings(
+    const SweepPath& path,
+    const std::vector<SweepFrame>& frames,
+    const RingPlacement& placement
+);
+
+// Largest chord sagitta r * (1 - cos(pi / n)) for an n-gon of radius r.
+[[nodiscard]] float ringSagitta(float radius, int radialSegments);
+
+}  // namespace meshgen
@@ -0,0 +1,542 @@
+#include "engine/VirtualTexture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+#include "app_config.hpp"
+
+namespace {
+
+constexpr std::uint64_t kPinned = std::numeric_limits<std::uint64_t>::max();
+
+}  // namespace
+
+std::size_t VirtualTexture::PageKeyHash::operator()(const PageKey& key) const {
+    std::size_t hash = std::hash<int>()(key.x);
+    hash ^= std::hash<int>()(key.y) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>()(key.level) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+VirtualTexture::~VirtualTexture() {
+    release();
+}
+
+VirtualTexture::VirtualTexture(VirtualTexture&& other) noexcept
+    : options_(other.options_),
+      file_(std::move(other.file_)),
+      layout_(other.layout_),
+      pageTable_(other.pageTable_),
+      atlas_(other.atlas_),
+      cachePagesPerSide_(other.cachePagesPerSide_),
+      entries_(std::move(other.entries_)),
+      dirty_(std::move(other.dirty_)),
+      pages_(std::move(other.pages_)),
+      lookup_(std::move(other.lookup_)),
+      requests_(std::move(other.requests_)),
+      frame_(other.frame_),
+      uploader_(std::move(other.uploader_)),
+      uploading_(std::move(other.uploading_)),
+      nextGeneration_(other.nextGeneration_),
+      framebuffer_(other.framebuffer_),
+      colorBuffer_(other.colorBuffer_),
+      depthBuffer_(other.depthBuffer_),
+      feedbackWidth_(other.feedbackWidth_),
+      feedbackHeight_(other.feedbackHeight_),
+      nextReadback_(other.nextReadback_) {
+    for (std::size_t i = 0; i < 2; ++i) {
+        readbacks_[i] = other.readbacks_[i];
+        other.readbacks_[i] = {};
+    }
+    other.pageTable_ = 0;
+    other.atlas_ = 0;
+    other.framebuffer_ = 0;
+    other.colorBuffer_ = 0;
+    other.depthBuffer_ = 0;
+    other.layout_ = {};
+}
+
+VirtualTexture& VirtualTexture::operator=(VirtualTexture&& other) noexcept {
+    if (this != &other) {
+        release();
+        options_ = other.options_;
+        file_ = std::move(other.file_);
+        layout_ = other.layout_;
+        pageTable_ = other.pageTable_;
+        atlas_ = other.atlas_;
+        cachePagesPerSide_ = other.cachePagesPerSide_;
+        entries_ = std::move(other.entries_);
+        dirty_ = std::move(other.dirty_);
+        pages_ = std::move(other.pages_);
+        lookup_ = std::move(other.lookup_);
+        requests_ = std::move(other.requests_);
+        frame_ = other.frame_;
+        uploader_ = std::move(other.uploader_);
+        uploading_ = std::move(other.uploading_);
+        nextGeneration_ = other.nextGeneration_;
+        framebuffer_ = other.framebuffer_;
+        colorBuffer_ = other.colorBuffer_;
+        depthBuffer_ = other.depthBuffer_;
+        feedbackWidth_ = other.feedbackWidth_;
+        feedbackHeight_ = other.feedbackHeight_;
+        nextReadback_ = other.nextReadback_;
+        for (std::size_t i = 0; i < 2; ++i) {
+            readbacks_[i] = other.readbacks_[i];
+            other.readbacks_[i] = {};
+        }
+
+        other.pageTable_ = 0;
+        other.atlas_ = 0;
+        other.framebuffer_ = 0;
+        other.colorBuffer_ = 0;
+        other.depthBuffer_ = 0;
+        other.layout_ = {};
+    }
+    return *this;
+}
+
+void VirtualTexture::initialize(const VirtualTextureOptions& options) {
+    release();
+    options_ = options;
+    options_.feedbackDivisor = std::max(1, options_.feedbackDivisor);
+
+    glGenFramebuffers(1, &framebuffer_);
+    glGenRenderbuffers(1, &colorBuffer_);
+    glGenRenderbuffers(1, &depthBuffer_);
+    for (Readback& readback : readbacks_) {
+        glGenBuffers(1, &readback.buffer);
+    }
+    uploader_.initialize(app::kTextureUploadBuffers, app::kTextureUploadBufferBytes);
+}
+
+void VirtualTexture::open(const std::string& path) {
+    // Pages are read wherever the feedback points, not in file order.
+    auto file = std::make_shared<MappedFile>(path, MappedFile::Access::Random);
+    const texcook::PageLayout layout = texcook::parsePages(file->data(), file->size(), path);
+
+    // Slots are addressed by one byte per axis in the page table.
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    const int side = std::min({options_.cachePagesPerSide, maxTextureSize / layout.storedSize(), 255});
+    if (side < 2) {
+        throw std::runtime_error("Paginas grandes demais para o cache: " + path);
+    }
+
+    file_ = std::move(file);
+    layout_ = layout;
+    cachePagesPerSide_ = side;
+
+    if (atlas_ == 0) {
+        glGenTextures(1, &atlas_);
+    }
+    const int atlasSize = side * layout_.storedSize();
+    glBindTexture(GL_TEXTURE_2D, atlas_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasSize, atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // Every texel starts out on the root page, which goes into slot 0.
+    if (pageTable_ == 0) {
+        glGenTextures(1, &pageTable_);
+    }
+    const int rootLevel = layout_.levelCount - 1;
+    glBindTexture(GL_TEXTURE_2D, pageTable_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, rootLevel);
+    entries_.assign(static_cast<std::size_t>(layout_.levelCount), {});
+    dirty_.assign(static_cast<std::size_t>(layout_.levelCount), {});
+    for (int level = 0; level < layout_.levelCount; ++level) {
+        const int pages = layout_.pagesPerSide(level);
+        const Entry root{0, 0, static_cast<std::uint8_t>(rootLevel), 255};
+        entries_[static_cast<std::size_t>(level)].assign(static_cast<std::size_t>(pages) * static_cast<std::size_t>(pages), root);
+        dirty_[static_cast<std::size_t>(level)] = {0, pages - 1};
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, pages, pages, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    // Jobs still queued for the previous file are dropped. The root page
+    // goes up at once so there is something to sample from the first frame.
+    pages_.assign(static_cast<std::size_t>(side) * static_cast<std::size_t>(side), {});
+    lookup_.clear();
+    requests_.clear();
+    uploading_.clear();
+    const PageKey root{rootLevel, 0, 0};
+    const int stored = layout_.storedSize();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, atlas_);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stored, stored, GL_RGBA, GL_UNSIGNED_BYTE, pageData(root));
+    pages_.front() = {root, kPinned, true, false};
+    lookup_[root] = 0;
+    uploadPageTable();
+}
+
+bool VirtualTexture::opened() const {
+    return layout_.levelCount > 0;
+}
+
+void VirtualTexture::beginFeedback() {
+    glGetIntegerv(GL_VIEWPORT, previousViewport_);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColor_);
+    resizeFeedback(
+        std::max(1, previousViewport_[2] / options_.feedbackDivisor),
+        std::max(1, previousViewport_[3] / options_.feedbackDivisor)
+    );
+
+    // Alpha zero marks texels no page was drawn to.
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(0, 0, feedbackWidth_, feedbackHeight_);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void VirtualTexture::endFeedback() {
+    // A buffer whose previous readback has not been consumed yet is left
+    // alone; that frame's feedback is simply skipped.
+    Readback& readback = readbacks_[nextReadback_];
+    if (readback.fence == nullptr) {
+        const auto bytes = static_cast<GLsizeiptr>(feedbackWidth_) * feedbackHeight_ * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        if (readback.width != feedbackWidth_ || readback.height != feedbackHeight_) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+            readback.width = feedbackWidth_;
+            readback.height = feedbackHeight_;
+        }
+        glReadPixels(0, 0, feedbackWidth_, feedbackHeight_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextReadback_ = (nextReadback_ + 1) % 2;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(previousViewport_[0], previousViewport_[1], previousViewport_[2], previousViewport_[3]);
+    glClearColor(previousClearColor_[0], previousClearColor_[1], previousClearColor_[2], previousClearColor_[3]);
+}
+
+void VirtualTexture::update(std::size_t uploadBudgetBytes, double uploadBudgetSeconds) {
+    if (!opened()) {
+        return;
+    }
+    ++frame_;
+
+    // Older readback first, so requests follow the order they were drawn.
+    for (std::size_t i = 0; i < 2; ++i) {
+        Readback& readback = readbacks_[(nextReadback_ + i) % 2];
+        if (readback.fence == nullptr) {
+            continue;
+        }
+        const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            continue;
+        }
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        readFeedback(readback);
+    }
+
+    // Coarse pages first: they are the fallback for the finer ones, and a
+    // blurry view fills in sooner than a sharp corner of it.
+    std::sort(requests_.begin(), requests_.end(), [](const PageKey& a, const PageKey& b) {
+        return a.level > b.level;
+    });
+    for (const PageKey& key : requests_) {
+        if (uploading_.size() >= options_.pagesPerFrame) {
+            break;
+        }
+        if (lookup_.count(key) != 0) {
+            continue;
+        }
+        if (!loadPage(key)) {
+            break;
+        }
+    }
+    requests_.clear();
+
+    uploader_.pump(
+        uploadBudgetBytes,
+        uploadBudgetSeconds,
+        [this](const TextureUploader::Job& job) {
+            return uploading_.count(job.generation) != 0;
+        },
+        [this](const TextureUploader::Job& job) {
+            pageLoaded(job);
+        }
+    );
+    uploadPageTable();
+}
+
+void VirtualTexture::bind(const Shader& shader, GLenum pageTableUnit, GLenum atlasUnit) const {
+    glActiveTexture(pageTableUnit);
+    glBindTexture(GL_TEXTURE_2D, pageTable_);
+    glActiveTexture(atlasUnit);
+    glBindTexture(GL_TEXTURE_2D, atlas_);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.setInt("pageTable", static_cast<int>(pageTableUnit - GL_TEXTURE0));
+    shader.setInt("pageAtlas", static_cast<int>(atlasUnit - GL_TEXTURE0));
+    shader.setFloat("virtualSize", static_cast<float>(layout_.virtualSize()));
+    shader.setInt("virtualLevels", layout_.levelCount);
+    shader.setFloat("pageSize", static_cast<float>(layout_.pageSize));
+    shader.setFloat("pageBorder", static_cast<float>(layout_.border));
+    shader.setFloat("atlasSize", static_cast<float>(cachePagesPerSide_ * layout_.storedSize()));
+}
+
+glm::vec2 VirtualTexture::imageExtent() const {
+    if (!opened()) {
+        return glm::vec2(0.0f);
+    }
+    return glm::vec2(imageSize()) / static_cast<float>(layout_.virtualSize());
+}
+
+glm::ivec2 VirtualTexture::imageSize() const {
+    return {layout_.imageWidth, layout_.imageHeight};
+}
+
+int VirtualTexture::virtualSize() const {
+    return opened() ? layout_.virtualSize() : 0;
+}
+
+std::size_t VirtualTexture::residentPages() const {
+    return lookup_.size() - uploading_.size();
+}
+
+std::size_t VirtualTexture::gpuBytes() const {
+    if (!opened()) {
+        return 0;
+    }
+    std::size_t bytes = pages_.size() * layout_.pageBytes();
+    for (const std::vector<Entry>& level : entries_) {
+        bytes += level.size() * sizeof(Entry);
+    }
+    return bytes + static_cast<std::size_t>(feedbackWidth_) * static_cast<std::size_t>(feedbackHeight_) * 8u;
+}
+
+void VirtualTexture::release() {
+    for (Readback& readback : readbacks_) {
+        if (readback.fence != nullptr) {
+            glDeleteSync(readback.fence);
+        }
+        if (readback.buffer != 0) {
+            glDeleteBuffers(1, &readback.buffer);
+        }
+        readback = {};
+    }
+    if (framebuffer_ != 0) {
+        glDeleteFramebuffers(1, &framebuffer_);
+        framebuffer_ = 0;
+    }
+    if (colorBuffer_ != 0) {
+        glDeleteRenderbuffers(1, &colorBuffer_);
+        colorBuffer_ = 0;
+    }
+    if (depthBuffer_ != 0) {
+        glDeleteRenderbuffers(1, &depthBuffer_);
+        depthBuffer_ = 0;
+    }
+    if (pageTable_ != 0) {
+        glDeleteTextures(1, &pageTable_);
+        pageTable_ = 0;
+    }
+    if (atlas_ != 0) {
+        glDeleteTextures(1, &atlas_);
+        atlas_ = 0;
+    }
+    layout_ = {};
+    feedbackWidth_ = 0;
+    feedbackHeight_ = 0;
+    uploading_.clear();
+}
+
+void VirtualTexture::resizeFeedback(int width, int height) {
+    if (width == feedbackWidth_ && height == feedbackHeight_) {
+        return;
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    feedbackWidth_ = width;
+    feedbackHeight_ = height;
+}
+
+void VirtualTexture::readFeedback(Readback& readback) {
+    const auto bytes = static_cast<GLsizeiptr>(readback.width) * readback.height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const auto* texels = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+    if (texels == nullptr) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return;
+    }
+
+    // Neighbouring pixels mostly name the same page, so each distinct
+    // texel value is handled once.
+    std::unordered_set<std::uint32_t> seen;
+    for (GLsizeiptr i = 0; i < bytes; i += 4) {
+        std::uint32_t value = 0;
+        std::memcpy(&value, texels + i, 4);
+        if (texels[i + 3] == 0 || !seen.insert(value).second) {
+            continue;
+        }
+        const int level = texels[i + 3] - 1;
+        const int x = texels[i] | ((texels[i + 2] & 0x0f) << 8);
+        const int y = texels[i + 1] | ((texels[i + 2] >> 4) << 8);
+        if (level < layout_.levelCount && x < layout_.pagesPerSide(level) && y < layout_.pagesPerSide(level)) {
+            request({level, x, y});
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void VirtualTexture::request(const PageKey& key) {
+    // Ancestors stay in use with their descendants, so eviction always
+    // takes the finest pages first.
+    for (PageKey page = key; page.level < layout_.levelCount; ++page.level, page.x /= 2, page.y /= 2) {
+        const auto found = lookup_.find(page);
+        if (found == lookup_.end()) {
+            requests_.push_back(page);
+        } else if (pages_[found->second].lastUsed != kPinned) {
+            pages_[found->second].lastUsed = frame_;
+        }
+    }
+}
+
+bool VirtualTexture::loadPage(const PageKey& key) {
+    // Least recently used slot, never one drawn from this frame; among
+    // equally old ones the finest goes first.
+    std::size_t slot = pages_.size();
+    for (std::size_t i = 0; i < pages_.size(); ++i) {
+        const Page& page = pages_[i];
+        if (!page.resident) {
+            slot = i;
+            break;
+        }
+        if (page.loading || page.lastUsed == frame_ || page.lastUsed == kPinned) {
+            continue;
+        }
+        if (slot == pages_.size() || page.lastUsed < pages_[slot].lastUsed ||
+            (page.lastUsed == pages_[slot].lastUsed && page.key.level < pages_[slot].key.level)) {
+            slot = i;
+        }
+    }
+    if (slot == pages_.size()) {
+        return false;
+    }
+
+    Page& page = pages_[slot];
+    if (page.resident) {
+        // Texels that sampled the evicted page fall back to whatever its
+        // parent falls back to.
+        const PageKey& old = page.key;
+        remap(old, old.level, entry(old.level + 1, old.x / 2, old.y / 2));
+        lookup_.erase(old);
+    }
+
+    const int side = cachePagesPerSide_;
+    const int stored = layout_.storedSize();
+    TextureUploader::Job job;
+    job.texture = atlas_;
+    job.generation = ++nextGeneration_;
+    job.format = GL_RGBA;
+    job.bytesPerPixel = 4;
+    job.levels.push_back({stored, stored, pageData(key), layout_.pageBytes()});
+    job.storage = file_;
+    job.subImage = true;
+    job.offsetX = static_cast<int>(slot) % side * stored;
+    job.offsetY = static_cast<int>(slot) / side * stored;
+    uploader_.enqueue(std::move(job));
+
+    page = {key, frame_, true, true};
+    lookup_[key] = slot;
+    uploading_[nextGeneration_] = slot;
+    return true;
+}
+
+void VirtualTexture::pageLoaded(const TextureUploader::Job& job) {
+    const auto found = uploading_.find(job.generation);
+    const std::size_t slot = found->second;
+    uploading_.erase(found);
+
+    Page& page = pages_[slot];
+    page.loading = false;
+    const int side = cachePagesPerSide_;
+    const PageKey& key = page.key;
+    const Entry mapped{
+        static_cast<std::uint8_t>(static_cast<int>(slot) % side),
+        static_cast<std::uint8_t>(static_cast<int>(slot) / side),
+        static_cast<std::uint8_t>(key.level),
+        255
+    };
+    remap(key, entry(key.level, key.x, key.y).level, mapped);
+}
+
+const unsigned char* VirtualTexture::pageData(const PageKey& key) const {
+    return reinterpret_cast<const unsigned char*>(file_->data()) + layout_.pageOffset(key.level, key.x, key.y);
+}
+
+void VirtualTexture::remap(const PageKey& key, int fromLevel, Entry to) {
+    // A texel that already points somewhere finer covers its whole subtree.
+    Entry& current = entry(key.level, key.x, key.y);
+    if (current.level != fromLevel) {
+        return;
+    }
+    current = to;
+    DirtyRows& rows = dirty_[static_cast<std::size_t>(key.level)];
+    if (rows.first > rows.last) {
+        rows = {key.y, key.y};
+    } else {
+        rows.first = std::min(rows.first, key.y);
+        rows.last = std::max(rows.last, key.y);
+    }
+
+    if (key.level > 0) {
+        for (int i = 0; i < 4; ++i) {
+            remap({key.level - 1, key.x * 2 + i % 2, key.y * 2 + i / 2}, fromLevel, to);
+        }
+    }
+}
+
+void VirtualTexture::uploadPageTable() {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, pageTable_);
+    for (int level = 0; level < layout_.levelCount; ++level) {
+        DirtyRows& rows = dirty_[static_cast<std::size_t>(level)];
+        if (rows.first > rows.last) {
+            continue;
+        }
+
+        const int pages = layout_.pagesPerSide(level);
+        glTexSubImage2D(
+            GL_TEXTURE_2D,
+            level,
+            0,
+            rows.first,
+            pages,
+            rows.last - rows.first + 1,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            &entries_[static_cast<std::size_t>(level)][static_cast<std::size_t>(rows.first) * static_cast<std::size_t>(pages)]
+        );
+        rows = {};
+    }
+}
+
+VirtualTexture::Entry& VirtualTexture::entry(int level, int x, int y) {
+    const auto pages = static_cast<std::size_t>(layout_.pagesPerSide(level));
+    return entries_[static_cast<std::size_t>(level)][static_cast<std::size_t>(y) * pages + static_cast<std::size_t>(x)];
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "engine/MappedFile.h"
+#include "engine/Shader.h"
+#include "engine/TextureCook.h"
+#include "engine/TextureUploader.h"
+
+struct VirtualTextureOptions {
+    // The physical cache is a square atlas of this many pages on a side.
+    int cachePagesPerSide = 16;
+    // Pages queued for upload at once.
+    std::size_t pagesPerFrame = 16;
+    // The feedback pass renders at the viewport size divided by this.
+    int feedbackDivisor = 8;
+};
+
+// Sparse virtual texture over a paged file (see texcook::PageLayout). Only
+// the pages the view samples are resident, in a fixed atlas of physical
+// pages, so the footprint does not depend on the image size. A page table
+// texture, one texel per virtual page and one mip level per page level,
+// maps each page to its atlas slot or to the nearest resident ancestor.
+// Which pages are needed is learnt from a low-resolution feedback pass that
+// writes page coordinates instead of colour; it is read back through a
+// pixel buffer and consumed a frame later, so the GPU is never waited on.
+// Only what is drawn into that pass asks for pages, so every surface that
+// samples the texture has to be drawn there too. Pages go up through a
+// TextureUploader within a per-frame budget and are mapped once complete.
+// The single page of the coarsest level is loaded at open() and stays
+// resident as the fallback for everything else. All calls belong on the GL
+// thread.
+class VirtualTexture {
+public:
+    VirtualTexture() = default;
+    ~VirtualTexture();
+
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+    VirtualTexture(VirtualTexture&& other) noexcept;
+    VirtualTexture& operator=(VirtualTexture&& other) noexcept;
+
+    void initialize(const VirtualTextureOptions& options = {});
+    // Throws when path is not a paged texture the cache can hold.
+    void open(const std::string& path);
+    [[nodiscard]] bool opened() const;
+
+    // Redirects rendering into the feedback target, a fraction of the
+    // current viewport; draw with a shader using
+    // virtual_feedback_fragment.glsl, after bind(), then call endFeedback()
+    // to queue the readback and restore the viewport.
+    void beginFeedback();
+    void endFeedback();
+
+    // Consumes the latest feedback that has arrived, queues missing pages
+    // coarsest first, keeping at most pagesPerFrame in flight, uploads
+    // within the budget and maps the pages that completed.
+    void update(std::size_t uploadBudgetBytes, double uploadBudgetSeconds);
+
+    // Sets the sampling uniforms on shader, which must be in use, and binds
+    // the page table and the atlas.
+    void bind(const Shader& shader, GLenum pageTableUnit, GLenum atlasUnit) const;
+
+    // Fraction of the virtual texture the image covers on each axis.
+    [[nodiscard]] glm::vec2 imageExtent() const;
+    [[nodiscard]] glm::ivec2 imageSize() const;
+    [[nodiscard]] int virtualSize() const;
+    [[nodiscard]] std::size_t residentPages() const;
+    [[nodiscard]] std::size_t gpuBytes() const;
+
+private:
+    struct PageKey {
+        int level = 0;
+        int x = 0;
+        int y = 0;
+
+        bool operator==(const PageKey& other) const {
+            return level == other.level && x == other.x && y == other.y;
+        }
+    };
+
+    struct PageKeyHash {
+        std::size_t operator()(const PageKey& key) const;
+    };
+
+    struct Page {
+        PageKey key;
+        std::uint64_t lastUsed = 0;
+        bool resident = false;
+        // Holds the slot but is not mapped until its upload completes.
+        bool loading = false;
+    };
+
+    struct Readback {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+
+    // Atlas slot and level a page table texel points at.
+    struct Entry {
+        std::uint8_t slotX = 0;
+        std::uint8_t slotY = 0;
+        std::uint8_t level = 0;
+        std::uint8_t unused = 255;
+    };
+
+    struct DirtyRows {
+        int first = 0;
+        int last = -1;
+    };
+
+    void release();
+    void resizeFeedback(int width, int height);
+    void readFeedback(Readback& readback);
+    void request(const PageKey& key);
+    [[nodiscard]] bool loadPage(const PageKey& key);
+    void pageLoaded(const TextureUploader::Job& job);
+    [[nodiscard]] const unsigned char* pageData(const PageKey& key) const;
+    // Points the texels of key's subtree that fell back to fromLevel at to.
+    void remap(const PageKey& key, int fromLevel, Entry to);
+    void uploadPageTable();
+    [[nodiscard]] Entry& entry(int level, int x, int y);
+
+    VirtualTextureOptions options_;
+    // Shared with the upload jobs that read from it.
+    std::shared_ptr<MappedFile> file_;
+    texcook::PageLayout layout_;
+
+    GLuint pageTable_ = 0;
+    GLuint atlas_ = 0;
+    int cachePagesPerSide_ = 0;
+    // Page table texels per level, row by row.
+    std::vector<std::vector<Entry>> entries_;
+    std::vector<DirtyRows> dirty_;
+
+    std::vector<Page> pages_;
+    std::unordered_map<PageKey, std::size_t, PageKeyHash> lookup_;
+    std::vector<PageKey> requests_;
+    std::uint64_t frame_ = 0;
+
+    TextureUploader uploader_;
+    // Slot each upload job fills, by generation.
+    std::unordered_map<std::uint64_t, std::size_t> uploading_;
+    std::uint64_t nextGeneration_ = 0;
+
+    GLuint framebuffer_ = 0;
+    GLuint colorBuffer_ = 0;
+    GLuint depthBuffer_ = 0;
+    int feedbackWidth_ = 0;
+    int feedbackHeight_ = 0;
+    GLint previousViewport_[4] = {0, 0, 0, 0};
+    GLfloat previousClearColor_[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    Readback readbacks_[2];
+    std::size_t nextReadback_ = 0;
+};
@@ -1,7 +1,10 @@
 #include "engine/Application.h"
 
-int main() {
-    Application app;
+int main(int argc, char** argv) {
+    // Optional arguments name a polyline dataset (binary or CSV) that is
+    // streamed in while the scene renders, a heightmap for the terrain and
+    // a paged ground texture (TubeCookTextures --pages) to drape over it.
+    Application app(argc > 1 ? argv[1] : "", argc > 2 ? argv[2] : "", argc > 3 ? argv[3] : "");
     app.run();
     return 0;
 }
@@ -0,0 +1,105 @@
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "engine/Capsule.h"
+
+namespace {
+
+std::mt19937 random(7);
+
+float uniform(float low, float high) {
+    return std::uniform_real_distribution<float>(low, high)(random);
+}
+
+glm::vec3 point(const glm::vec3& low, const glm::vec3& high) {
+    return {uniform(low.x, high.x), uniform(low.y, high.y), uniform(low.z, high.z)};
+}
+
+// Random segments inside a box, returned with the box around them.
+std::vector<Capsule> scatter(std::size_t count, const glm::vec3& size, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    std::vector<Capsule> capsules(count);
+    boundsMin = glm::vec3(1.0e9f);
+    boundsMax = glm::vec3(-1.0e9f);
+    for (Capsule& capsule : capsules) {
+        capsule.start = point(glm::vec3(0.0f), size);
+        capsule.end = point(glm::vec3(0.0f), size);
+        capsule.radius = uniform(0.01f, 0.5f);
+        boundsMin = glm::min(boundsMin, glm::min(capsule.start, capsule.end) - capsule.radius);
+        boundsMax = glm::max(boundsMax, glm::max(capsule.start, capsule.end) + capsule.radius);
+    }
+    return capsules;
+}
+
+bool holds(const Capsule& outer, const Capsule& inner) {
+    return containsSphere(outer, inner.start, inner.radius) && containsSphere(outer, inner.end, inner.radius);
+}
+
+void testBoxCapsuleHoldsCorners() {
+    const glm::vec3 boundsMin(-1.0f, 2.0f, 0.5f);
+    const glm::vec3 boundsMax(7.0f, 3.0f, 2.5f);
+    const Capsule capsule = enclosingCapsule(boundsMin, boundsMax);
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec3 p(
+            (corner & 1) != 0 ? boundsMax.x : boundsMin.x,
+            (corner & 2) != 0 ? boundsMax.y : boundsMin.y,
+            (corner & 4) != 0 ? boundsMax.z : boundsMin.z
+        );
+        CHECK(containsSphere(capsule, p, 0.0f));
+    }
+}
+
+void testFittedCapsuleHoldsChildren() {
+    for (int trial = 0; trial < 200; ++trial) {
+        const glm::vec3 size(uniform(0.1f, 40.0f), uniform(0.1f, 5.0f), uniform(0.1f, 5.0f));
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        const std::vector<Capsule> children = scatter(1 + trial % 6, size, boundsMin, boundsMax);
+
+        const Capsule parent = enclosingCapsule(boundsMin, boundsMax, children.data(), children.size());
+        for (const Capsule& child : children) {
+            CHECK(holds(parent, child));
+        }
+    }
+}
+
+// Two levels, as TubeNetwork builds them: leaves from cluster bounds,
+// the parent from the leaves. Every segment must end up inside the root.
+void testNestedCapsulesHoldSegments() {
+    for (int trial = 0; trial < 50; ++trial) {
+        std::vector<Capsule> segments;
+        std::vector<Capsule> leaves;
+        glm::vec3 rootMin(1.0e9f);
+        glm::vec3 rootMax(-1.0e9f);
+        for (int leaf = 0; leaf < 4; ++leaf) {
+            glm::vec3 boundsMin;
+            glm::vec3 boundsMax;
+            std::vector<Capsule> cluster = scatter(8, glm::vec3(uniform(1.0f, 20.0f), 3.0f, 2.0f), boundsMin, boundsMax);
+            const glm::vec3 shift = point(glm::vec3(-20.0f), glm::vec3(20.0f));
+            for (Capsule& segment : cluster) {
+                segment.start += shift;
+                segment.end += shift;
+            }
+            boundsMin += shift;
+            boundsMax += shift;
+            rootMin = glm::min(rootMin, boundsMin);
+            rootMax = glm::max(rootMax, boundsMax);
+            leaves.push_back(enclosingCapsule(boundsMin, boundsMax));
+            segments.insert(segments.end(), cluster.begin(), cluster.end());
+        }
+
+        const Capsule root = enclosingCapsule(rootMin, rootMax, leaves.data(), leaves.size());
+        for (const Capsule& segment : segments) {
+            CHECK(holds(root, segment));
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    testBoxCapsuleHoldsCorners();
+    testFittedCapsuleHoldsChildren();
+    testNestedCapsulesHoldSegments();
+    return check::failures();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the unit tests: a failed CHECK reports its
+// location and lets the test carry on, and main returns the failure count.
+namespace check {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* expression) {
+    std::fprintf(stderr, "%s:%d: falhou: %s\n", file, line, expression);
+    ++failures();
+}
+
+}  // namespace check
+
+#define CHECK(condition)                                  \
+    do {                                                  \
+        if (!(condition)) {                               \
+            check::fail(__FILE__, __LINE__, #condition);  \
+        }                                                 \
+    } while (false)
@@ -0,0 +1,130 @@
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <jpeglib.h>
+
+#include "Check.h"
+#include "engine/ImageDecoder.h"
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+struct Encoding {
+    int components = 3;
+    // Luma sampling factors; chroma is always 1x1.
+    int horizontal = 2;
+    int vertical = 2;
+    int restartRows = 1;
+    // Restart interval in MCUs, used when restartRows is zero.
+    int restartInterval = 0;
+};
+
+// Detail in every channel, so a seam in the chroma shows in the output.
+Bytes encode(int width, int height, const Encoding& encoding) {
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(width) * height * encoding.components);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < encoding.components; ++c) {
+                const float wave = std::sin(0.11f * x * (c + 1) + 0.07f * y) * std::cos(0.05f * y * (3 - c));
+                pixels[(static_cast<std::size_t>(y) * width + x) * encoding.components + c] = static_cast<unsigned char>(127.5f + 127.0f * wave);
+            }
+        }
+    }
+
+    jpeg_compress_struct info{};
+    jpeg_error_mgr error{};
+    info.err = jpeg_std_error(&error);
+    jpeg_create_compress(&info);
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&info, &buffer, &size);
+    info.image_width = static_cast<JDIMENSION>(width);
+    info.image_height = static_cast<JDIMENSION>(height);
+    info.input_components = encoding.components;
+    info.in_color_space = encoding.components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, 90, TRUE);
+    info.comp_info[0].h_samp_factor = encoding.horizontal;
+    info.comp_info[0].v_samp_factor = encoding.vertical;
+    info.restart_in_rows = encoding.restartRows;
+    info.restart_interval = static_cast<unsigned int>(encoding.restartInterval);
+    jpeg_start_compress(&info, TRUE);
+
+    const std::size_t stride = static_cast<std::size_t>(width) * encoding.components;
+    while (info.next_scanline < info.image_height) {
+        JSAMPROW row = pixels.data() + info.next_scanline * stride;
+        jpeg_write_scanlines(&info, &row, 1);
+    }
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+
+    Bytes file(buffer, buffer + size);
+    std::free(buffer);
+    return file;
+}
+
+// The banded decode against one whole decode by the same inner decoder.
+bool sameAsInner(const Bytes& file, const std::shared_ptr<const ImageDecoder>& inner, std::size_t bandCount) {
+    DecodedImage whole;
+    DecodedImage banded;
+    const std::unique_ptr<ImageDecoder> parallel = makeRestartParallelDecoder(inner, bandCount);
+    if (!inner->decode(file.data(), file.size(), whole) || !parallel->decode(file.data(), file.size(), banded)) {
+        return false;
+    }
+    return banded.width == whole.width && banded.height == whole.height && banded.channels == whole.channels &&
+        banded.pixels == whole.pixels;
+}
+
+void testBands(const std::shared_ptr<const ImageDecoder>& inner) {
+    // 4:2:0, where the vertical chroma filter reaches across band seams,
+    // at a size that leaves partial MCUs on both edges.
+    const Bytes subsampled = encode(203, 157, Encoding{});
+    for (const std::size_t bands : {2u, 3u, 5u, 10u}) {
+        CHECK(sameAsInner(subsampled, inner, bands));
+    }
+
+    Encoding tall;
+    tall.horizontal = 1;
+    tall.restartRows = 2;
+    CHECK(sameAsInner(encode(96, 200, tall), inner, 4));
+
+    Encoding full;
+    full.horizontal = 1;
+    full.vertical = 1;
+    CHECK(sameAsInner(encode(70, 90, full), inner, 3));
+
+    Encoding grey;
+    grey.components = 1;
+    grey.horizontal = 1;
+    grey.vertical = 1;
+    CHECK(sameAsInner(encode(64, 64, grey), inner, 4));
+}
+
+void testFallback(const std::shared_ptr<const ImageDecoder>& inner) {
+    // No restarts, and an interval that ends mid-row, both decode whole.
+    Encoding none;
+    none.restartRows = 0;
+    CHECK(sameAsInner(encode(120, 80, none), inner, 4));
+
+    Encoding unaligned;
+    unaligned.restartRows = 0;
+    unaligned.restartInterval = 3;
+    CHECK(sameAsInner(encode(120, 80, unaligned), inner, 4));
+}
+
+}  // namespace
+
+int main() {
+    const std::shared_ptr<const ImageDecoder> jpeg = makeLibjpegDecoder();
+    const std::shared_ptr<const ImageDecoder> stb = makeStbDecoder();
+    CHECK(jpeg != nullptr);
+    if (jpeg != nullptr) {
+        testBands(jpeg);
+        testFallback(jpeg);
+    }
+    testBands(stb);
+    return check::failures();
+}
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Check.h"
+#include "app_config.hpp"
+#include "engine/MeshKernels.h"
+#include "engine/MeshSimplify.h"
+
+namespace {
+
+constexpr std::size_t kStride = app::kVertexStrideFloats;
+
+struct TestMesh {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+};
+
+TestMesh sphere(int sectors, int stacks, const glm::vec3& offset) {
+    const meshgen::MeshLayout layout = meshgen::sphereLayout(sectors, stacks);
+    TestMesh mesh;
+    mesh.vertices.resize(layout.vertexCount * kStride);
+    mesh.indices.resize(layout.indexCount);
+    meshgen::writeSphere(meshgen::SphereParams{1.0f, sectors, stacks}, mesh.vertices.data(), mesh.indices.data());
+    for (std::size_t v = 0; v < layout.vertexCount; ++v) {
+        for (int axis = 0; axis < 3; ++axis) {
+            mesh.vertices[v * kStride + axis] += offset[axis];
+        }
+    }
+    return mesh;
+}
+
+// A rolling heightfield of size x size quads, one connected component large
+// enough to be cut into patches.
+TestMesh terrain(int size) {
+    TestMesh mesh;
+    for (int z = 0; z <= size; ++z) {
+        for (int x = 0; x <= size; ++x) {
+            const float u = static_cast<float>(x) / static_cast<float>(size);
+            const float v = static_cast<float>(z) / static_cast<float>(size);
+            const float height = 0.05f * std::sin(u * 9.0f) * std::cos(v * 7.0f);
+            mesh.vertices.insert(mesh.vertices.end(), {u, height, v, 0.0f, 1.0f, 0.0f, u, v});
+        }
+    }
+    const auto at = [size](int x, int z) {
+        return static_cast<unsigned int>(z * (size + 1) + x);
+    };
+    for (int z = 0; z < size; ++z) {
+        for (int x = 0; x < size; ++x) {
+            mesh.indices.insert(mesh.indices.end(), {at(x, z), at(x, z + 1), at(x + 1, z)});
+            mesh.indices.insert(mesh.indices.end(), {at(x + 1, z), at(x, z + 1), at(x + 1, z + 1)});
+        }
+    }
+    return mesh;
+}
+
+glm::vec3 position(const std::vector<float>& vertices, unsigned int v) {
+    return {vertices[v * kStride], vertices[v * kStride + 1], vertices[v * kStride + 2]};
+}
+
+float segmentDistance(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b) {
+    const glm::vec3 ab = b - a;
+    const float t = glm::clamp(glm::dot(p - a, ab) / std::max(glm::dot(ab, ab), 1.0e-20f), 0.0f, 1.0f);
+    return glm::length(p - (a + ab * t));
+}
+
+// The plane distance when p projects inside the triangle, else the nearest
+// edge.
+float triangleDistance(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    const glm::vec3 normal = glm::cross(b - a, c - a);
+    const float area = glm::length(normal);
+    if (area > 0.0f) {
+        const glm::vec3 unit = normal / area;
+        const glm::vec3 projected = p - unit * glm::dot(p - a, unit);
+        const bool inside = glm::dot(glm::cross(b - a, projected - a), unit) >= 0.0f
+            && glm::dot(glm::cross(c - b, projected - b), unit) >= 0.0f
+            && glm::dot(glm::cross(a - c, projected - c), unit) >= 0.0f;
+        if (inside) {
+            return std::abs(glm::dot(p - a, unit));
+        }
+    }
+    return std::min({segmentDistance(p, a, b), segmentDistance(p, b, c), segmentDistance(p, c, a)});
+}
+
+// Every sample against every triangle.
+float bruteDistance(const TestMesh& from, const std::vector<unsigned int>& fromIndices, const TestMesh& to, const std::vector<unsigned int>& toIndices) {
+    std::vector<glm::vec3> samples;
+    for (const unsigned int v : fromIndices) {
+        samples.push_back(position(from.vertices, v));
+    }
+    for (std::size_t i = 0; i < fromIndices.size(); i += 3) {
+        samples.push_back((position(from.vertices, fromIndices[i]) + position(from.vertices, fromIndices[i + 1])
+                           + position(from.vertices, fromIndices[i + 2])) / 3.0f);
+    }
+
+    float largest = 0.0f;
+    for (const glm::vec3& sample : samples) {
+        float nearest = 1.0e30f;
+        for (std::size_t i = 0; i < toIndices.size(); i += 3) {
+            nearest = std::min(nearest, triangleDistance(
+                sample,
+                position(to.vertices, toIndices[i]),
+                position(to.vertices, toIndices[i + 1]),
+                position(to.vertices, toIndices[i + 2])
+            ));
+        }
+        largest = std::max(largest, nearest);
+    }
+    return largest;
+}
+
+// Every edge is used once on a border or twice inside, once each way.
+bool manifold(const std::vector<unsigned int>& indices) {
+    std::map<std::pair<unsigned int, unsigned int>, int> directed;
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        for (std::size_t corner = 0; corner < 3; ++corner) {
+            const unsigned int a = indices[i + corner];
+            const unsigned int b = indices[i + (corner + 1) % 3];
+            if (a == b || ++directed[{a, b}] > 1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void testSphereError() {
+    const TestMesh source = sphere(32, 16, glm::vec3(0.0f));
+    const std::size_t target = source.indices.size() / 2;
+    float error = -1.0f;
+    const std::vector<unsigned int> reduced = meshgen::simplifyMesh(
+        source.vertices.data(),
+        source.vertices.size() / kStride,
+        source.indices.data(),
+        source.indices.size(),
+        target,
+        1.0f,
+        &error
+    );
+
+    CHECK(!reduced.empty());
+    CHECK(reduced.size() <= target + 3);
+    CHECK(std::all_of(reduced.begin(), reduced.end(), [&](unsigned int v) {
+        return v < source.vertices.size() / kStride;
+    }));
+
+    // The reported error is the measured one, both ways round.
+    const float expected = std::max(
+        bruteDistance(source, source.indices, source, reduced),
+        bruteDistance(source, reduced, source, source.indices)
+    );
+    CHECK(error > 0.0f);
+    CHECK(std::abs(error - expected) <= 1.0e-5f + 1.0e-3f * expected);
+}
+
+void testLargeComponent() {
+    const TestMesh source = terrain(160);
+    const std::size_t target = source.indices.size() / 3 / 4;
+    float error = -1.0f;
+    const std::vector<unsigned int> reduced = meshgen::simplifyMesh(
+        source.vertices.data(),
+        source.vertices.size() / kStride,
+        source.indices.data(),
+        source.indices.size(),
+        target * 3,
+        1.0f,
+        &error
+    );
+
+    // Patches are cut along both directions, so nothing stays pinned and
+    // the whole component reaches the target.
+    CHECK(reduced.size() / 3 <= target);
+    CHECK(reduced.size() / 3 >= target - target / 10);
+    CHECK(manifold(reduced));
+    CHECK(error < 0.01f);
+
+    bool upward = true;
+    for (std::size_t i = 0; i < reduced.size(); i += 3) {
+        const glm::vec3 a = position(source.vertices, reduced[i]);
+        const glm::vec3 normal = glm::cross(position(source.vertices, reduced[i + 1]) - a, position(source.vertices, reduced[i + 2]) - a);
+        upward = upward && normal.y > 0.0f;
+    }
+    CHECK(upward);
+}
+
+void testChainAwayFromOrigin() {
+    // The bound follows the mesh's own radius, not its distance from the
+    // origin, so it cuts the chain short.
+    const TestMesh source = sphere(48, 24, glm::vec3(100.0f, 0.0f, 0.0f));
+    meshgen::LodChainOptions options;
+    options.maxRelativeError = 0.05f;
+    const std::vector<meshgen::LodLevel> levels = meshgen::buildLodChain(
+        source.vertices.data(),
+        source.vertices.size() / kStride,
+        source.indices.data(),
+        source.indices.size(),
+        options
+    );
+
+    CHECK(!levels.empty());
+    CHECK(levels.size() < options.maxLevels);
+    std::size_t previousTriangles = source.indices.size() / 3;
+    float previousError = 0.0f;
+    for (const meshgen::LodLevel& level : levels) {
+        CHECK(level.indices.size() / 3 < previousTriangles);
+        CHECK(level.error >= previousError);
+        CHECK(level.error <= options.maxRelativeError);
+        const float measured = meshgen::surfaceDistance(
+            source.vertices.data(),
+            source.indices.data(),
+            source.indices.size(),
+            level.vertices.data(),
+            level.indices.data(),
+            level.indices.size()
+        );
+        CHECK(measured <= level.error + 1.0e-6f);
+        previousTriangles = level.indices.size() / 3;
+        previousError = level.error;
+    }
+}
+
+}  // namespace
+
+int main() {
+    testSphereError();
+    testLargeComponent();
+    testChainAwayFromOrigin();
+    return check::failures();
+}
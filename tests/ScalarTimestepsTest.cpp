@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "Check.h"
+#include "engine/ScalarTimesteps.h"
+
+namespace {
+
+constexpr std::size_t kValues = 10000;
+
+std::vector<float> timestep(int id) {
+    return std::vector<float>(kValues, static_cast<float>(id));
+}
+
+// Stands in for the back buffer: applies one frame's slice and reports the
+// timestep it completed, or -1.
+int pumpFrame(ScalarTimesteps& timesteps, std::vector<float>& back, std::size_t budget) {
+    const ScalarTimesteps::Slice slice = timesteps.next(budget);
+    if (slice.count == 0) {
+        return -1;
+    }
+    std::copy(slice.values, slice.values + slice.count, back.begin() + static_cast<std::ptrdiff_t>(slice.offset));
+    if (!timesteps.advance(slice.count)) {
+        return -1;
+    }
+
+    // A swapped buffer holds one whole timestep.
+    const bool whole = std::all_of(back.begin(), back.end(), [&back](float value) {
+        return value == back.front();
+    });
+    CHECK(whole);
+    return static_cast<int>(back.front());
+}
+
+void testFasterProducer() {
+    // A new timestep every frame, five frames to upload each one.
+    ScalarTimesteps timesteps;
+    std::vector<float> back(kValues, -1.0f);
+    std::vector<int> swapped;
+    std::vector<int> swapFrames;
+    int lastSwapFrame = -1;
+    for (int frame = 0; frame < 60; ++frame) {
+        timesteps.submit(timestep(frame));
+        const int completed = pumpFrame(timesteps, back, kValues / 5);
+        if (completed >= 0) {
+            swapped.push_back(completed);
+            swapFrames.push_back(frame);
+            CHECK(frame - lastSwapFrame <= 5);
+            lastSwapFrame = frame;
+        }
+    }
+
+    CHECK(swapped.size() >= 11);
+    CHECK(!swapped.empty() && swapped.front() == 0);
+    for (std::size_t i = 1; i < swapped.size(); ++i) {
+        // Each is the newest submitted when the previous one completed.
+        CHECK(swapped[i] == swapFrames[i - 1]);
+    }
+    CHECK(timesteps.busy());
+}
+
+void testSlowerProducer() {
+    // Every timestep is shown when each one finishes before the next.
+    ScalarTimesteps timesteps;
+    std::vector<float> back(kValues, -1.0f);
+    std::vector<int> swapped;
+    for (int frame = 0; frame < 40; ++frame) {
+        if (frame % 4 == 0) {
+            timesteps.submit(timestep(frame / 4));
+        }
+        const int completed = pumpFrame(timesteps, back, kValues / 2);
+        if (completed >= 0) {
+            swapped.push_back(completed);
+        }
+    }
+
+    CHECK(swapped.size() == 10);
+    for (std::size_t i = 0; i < swapped.size(); ++i) {
+        CHECK(swapped[i] == static_cast<int>(i));
+    }
+    CHECK(!timesteps.busy());
+
+    timesteps.submit({});
+    CHECK(!timesteps.busy());
+}
+
+}  // namespace
+
+int main() {
+    testFasterProducer();
+    testSlowerProducer();
+    return check::failures();
+}
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Check.h"
+#include "engine/TerrainQuadtree.h"
+
+namespace {
+
+// Every tile is resident, or becomes so the first time it is asked for.
+struct AllResident {
+    std::unordered_map<TerrainTileKey, std::size_t, TerrainTileKeyHash> layers;
+
+    int find(const TerrainTileKey& key) {
+        return static_cast<int>(layers.emplace(key, layers.size()).first->second);
+    }
+
+    int load(const TerrainTileKey& key) {
+        return find(key);
+    }
+
+    [[nodiscard]] glm::vec2 heights(std::size_t) const {
+        return {0.0f, 2.0f};
+    }
+};
+
+// Only what load() paged in is resident.
+struct Cold {
+    std::unordered_map<TerrainTileKey, std::size_t, TerrainTileKeyHash> layers;
+    int loads = 0;
+
+    int find(const TerrainTileKey& key) {
+        const auto found = layers.find(key);
+        return found == layers.end() ? -1 : static_cast<int>(found->second);
+    }
+
+    int load(const TerrainTileKey& key) {
+        ++loads;
+        return static_cast<int>(layers.emplace(key, layers.size()).first->second);
+    }
+
+    [[nodiscard]] glm::vec2 heights(std::size_t) const {
+        return {0.0f, 2.0f};
+    }
+};
+
+TerrainLayout testLayout() {
+    TerrainLayout layout;
+    layout.gridSize = 8;
+    layout.levels = 5;
+    layout.spacing = 1.5f;
+    layout.rangeFactor = 2.0f;
+    layout.origin = glm::vec2(-20.0f, 7.0f);
+    return layout;
+}
+
+Frustum everything() {
+    return Frustum(glm::ortho(-1.0e5f, 1.0e5f, -1.0e5f, 1.0e5f, -1.0e5f, 1.0e5f));
+}
+
+void bounds(const TerrainLayout& layout, const TerrainTileKey& key, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    const std::int64_t samples = layout.nodeSamples(key.level);
+    const glm::vec2 low = layout.sampleToWorld(key.x * samples, key.z * samples);
+    const glm::vec2 high = layout.sampleToWorld((key.x + 1) * samples, (key.z + 1) * samples);
+    boundsMin = glm::vec3(low.x, 0.0f, low.y);
+    boundsMax = glm::vec3(high.x, 2.0f, high.y);
+}
+
+float distanceTo(const glm::vec3& eye, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    return glm::length(eye - glm::clamp(eye, boundsMin, boundsMax));
+}
+
+// The selected node under (x, z), or -1 where none or several are.
+int levelAt(const TerrainLayout& layout, const std::vector<TerrainNode>& nodes, float x, float z) {
+    int level = -1;
+    int covering = 0;
+    for (const TerrainNode& node : nodes) {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        bounds(layout, node.key, boundsMin, boundsMax);
+        if (x >= boundsMin.x && x < boundsMax.x && z >= boundsMin.z && z < boundsMax.z) {
+            level = node.key.level;
+            ++covering;
+        }
+    }
+    return covering == 1 ? level : -1;
+}
+
+void testSplitRule() {
+    const TerrainLayout layout = testLayout();
+    const glm::vec3 eye(37.0f, 5.0f, -12.0f);
+    AllResident tiles;
+    std::vector<TerrainNode> nodes;
+    std::vector<TerrainTileKey> requests;
+    selectTerrainNodes(layout, eye, everything(), tiles, nodes, requests);
+
+    CHECK(!nodes.empty());
+    CHECK(requests.empty());
+    for (const TerrainNode& node : nodes) {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        bounds(layout, node.key, boundsMin, boundsMax);
+        // Not split although it could be, and its parent was split.
+        CHECK(node.key.level == 0 || distanceTo(eye, boundsMin, boundsMax) >= layout.range(node.key.level - 1));
+        if (node.key.level + 1 < layout.levels) {
+            const TerrainTileKey parent{node.key.level + 1, node.key.x >> 1, node.key.z >> 1};
+            bounds(layout, parent, boundsMin, boundsMax);
+            CHECK(distanceTo(eye, boundsMin, boundsMax) < layout.range(node.key.level));
+        }
+    }
+    CHECK(std::any_of(nodes.begin(), nodes.end(), [](const TerrainNode& node) {
+        return node.key.level == 0;
+    }));
+}
+
+void testCoverage() {
+    const TerrainLayout layout = testLayout();
+    const glm::vec3 eye(37.0f, 5.0f, -12.0f);
+    AllResident tiles;
+    std::vector<TerrainNode> nodes;
+    std::vector<TerrainTileKey> requests;
+    selectTerrainNodes(layout, eye, everything(), tiles, nodes, requests);
+
+    // Each point near the camera lies in exactly one node, and levels only
+    // step by one between neighbours, which is what the morph relies on.
+    const float reach = layout.range(layout.levels - 1) * 0.9f;
+    // Half the finest node, so no neighbour is skipped.
+    const float step = 0.5f * static_cast<float>(layout.gridSize) * layout.spacing;
+    bool covered = true;
+    bool gradual = true;
+    for (float z = eye.z - reach; z < eye.z + reach; z += step) {
+        for (float x = eye.x - reach; x < eye.x + reach; x += step) {
+            const int level = levelAt(layout, nodes, x, z);
+            covered = covered && level >= 0;
+            const int right = levelAt(layout, nodes, x + step, z);
+            const int below = levelAt(layout, nodes, x, z + step);
+            gradual = gradual && (right < 0 || std::abs(right - level) <= 1) && (below < 0 || std::abs(below - level) <= 1);
+        }
+    }
+    CHECK(covered);
+    CHECK(gradual);
+}
+
+void testMissingChildren() {
+    const TerrainLayout layout = testLayout();
+    const glm::vec3 eye(0.0f, 5.0f, 0.0f);
+    Cold tiles;
+    std::vector<TerrainNode> nodes;
+    std::vector<TerrainTileKey> requests;
+    selectTerrainNodes(layout, eye, everything(), tiles, nodes, requests);
+
+    // Only the roots are paged in at once; they draw whole and ask for
+    // the children they would split into.
+    const int top = layout.levels - 1;
+    CHECK(!nodes.empty());
+    CHECK(tiles.loads == static_cast<int>(nodes.size()));
+    CHECK(std::all_of(nodes.begin(), nodes.end(), [top](const TerrainNode& node) {
+        return node.key.level == top;
+    }));
+    CHECK(!requests.empty());
+    for (const TerrainTileKey& request : requests) {
+        CHECK(request.level == top - 1);
+        CHECK(std::any_of(nodes.begin(), nodes.end(), [&](const TerrainNode& node) {
+            return node.key.x == request.x >> 1 && node.key.z == request.z >> 1;
+        }));
+    }
+}
+
+void testMapBounds() {
+    TerrainLayout layout = testLayout();
+    layout.width = 100;
+    layout.depth = 60;
+    layout.origin = glm::vec2(0.0f);
+    const glm::vec3 eye(10.0f, 5.0f, 10.0f);
+    AllResident tiles;
+    std::vector<TerrainNode> nodes;
+    std::vector<TerrainTileKey> requests;
+    selectTerrainNodes(layout, eye, everything(), tiles, nodes, requests);
+
+    CHECK(!nodes.empty());
+    for (const TerrainNode& node : nodes) {
+        const std::int64_t samples = layout.nodeSamples(node.key.level);
+        CHECK(node.key.x >= 0 && node.key.x * samples < layout.width);
+        CHECK(node.key.z >= 0 && node.key.z * samples < layout.depth);
+    }
+}
+
+void testCulling() {
+    const TerrainLayout layout = testLayout();
+    const glm::vec3 eye(0.0f, 5.0f, 0.0f);
+    const glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(1.0f, -0.2f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum(glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 2000.0f) * view);
+
+    AllResident allTiles;
+    std::vector<TerrainNode> all;
+    std::vector<TerrainTileKey> requests;
+    selectTerrainNodes(layout, eye, everything(), allTiles, all, requests);
+
+    AllResident tiles;
+    std::vector<TerrainNode> nodes;
+    selectTerrainNodes(layout, eye, frustum, tiles, nodes, requests);
+
+    CHECK(!nodes.empty());
+    CHECK(nodes.size() < all.size());
+    for (const TerrainNode& node : nodes) {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        bounds(layout, node.key, boundsMin, boundsMax);
+        CHECK(frustum.intersectsBox(boundsMin, boundsMax));
+    }
+}
+
+}  // namespace
+
+int main() {
+    testSplitRule();
+    testCoverage();
+    testMissingChildren();
+    testMapBounds();
+    testCulling();
+    return check::failures();
+}
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "engine/TextureCook.h"
+
+namespace {
+
+std::string tempPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::vector<char> readAll(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+template <typename Function>
+bool throws(Function function) {
+    try {
+        function();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Colours along one line through RGB, which BC1 can represent closely, with
+// blue falling as red and green rise, so only endpoints on the anti-diagonal
+// fit.
+std::vector<unsigned char> gradient(int width, int height, int channels) {
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(width) * height * channels);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            unsigned char* texel = &pixels[(static_cast<std::size_t>(y) * width + x) * channels];
+            const int t = (2 * x + y) * 255 / (2 * (width - 1) + height - 1);
+            texel[0] = static_cast<unsigned char>(t);
+            texel[1] = static_cast<unsigned char>(64 + t / 2);
+            texel[2] = static_cast<unsigned char>(255 - t);
+            if (channels == 4) {
+                texel[3] = static_cast<unsigned char>(x * 255 / (width - 1));
+            }
+        }
+    }
+    return pixels;
+}
+
+void decode565(std::uint16_t packed, int* color) {
+    const int r = packed >> 11 & 31;
+    const int g = packed >> 5 & 63;
+    const int b = packed & 31;
+    color[0] = r << 3 | r >> 2;
+    color[1] = g << 2 | g >> 4;
+    color[2] = b << 3 | b >> 2;
+}
+
+// Reference decoders, written from the format rather than the encoder.
+void decodeColorBlock(const unsigned char* block, unsigned char (&texels)[16][4]) {
+    const auto color0 = static_cast<std::uint16_t>(block[0] | block[1] << 8);
+    const auto color1 = static_cast<std::uint16_t>(block[2] | block[3] << 8);
+    int palette[4][3];
+    decode565(color0, palette[0]);
+    decode565(color1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+        if (color0 > color1) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    const std::uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<std::uint32_t>(block[7]) << 24;
+    for (int i = 0; i < 16; ++i) {
+        const int* color = palette[indices >> (2 * i) & 3];
+        for (int c = 0; c < 3; ++c) {
+            texels[i][c] = static_cast<unsigned char>(color[c]);
+        }
+    }
+}
+
+void decodeAlphaBlock(const unsigned char* block, unsigned char (&texels)[16][4]) {
+    const int alpha0 = block[0];
+    const int alpha1 = block[1];
+    int palette[8] = {alpha0, alpha1};
+    if (alpha0 > alpha1) {
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+        }
+    } else {
+        for (int i = 1; i < 5; ++i) {
+            palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    std::uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= static_cast<std::uint64_t>(block[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        texels[i][3] = static_cast<unsigned char>(palette[indices >> (3 * i) & 7]);
+    }
+}
+
+// Root mean square error per channel of a compressed level against the
+// source, over the texels inside the image.
+std::vector<double> blockError(const texcook::MipChain& source, const texcook::MipChain& encoded, std::size_t levelIndex) {
+    const texcook::Level& level = source.layout.levels[levelIndex];
+    const int channels = texcook::bytesPerPixel(source.layout.format);
+    const bool alpha = encoded.layout.format == texcook::Format::Bc3;
+    const unsigned char* pixels = source.pixels.data() + level.offset;
+    const unsigned char* block = encoded.pixels.data() + encoded.layout.levels[levelIndex].offset;
+
+    std::vector<double> error(channels, 0.0);
+    for (int by = 0; by < level.height; by += 4) {
+        for (int bx = 0; bx < level.width; bx += 4) {
+            unsigned char texels[16][4] = {};
+            if (alpha) {
+                decodeAlphaBlock(block, texels);
+                block += 8;
+            }
+            decodeColorBlock(block, texels);
+            block += 8;
+
+            for (int i = 0; i < 16; ++i) {
+                const int x = bx + i % 4;
+                const int y = by + i / 4;
+                if (x >= level.width || y >= level.height) {
+                    continue;
+                }
+                const unsigned char* texel = pixels + (static_cast<std::size_t>(y) * level.width + x) * channels;
+                for (int c = 0; c < channels; ++c) {
+                    const double d = static_cast<double>(texel[c]) - texels[i][c];
+                    error[c] += d * d;
+                }
+            }
+        }
+    }
+    for (double& value : error) {
+        value = std::sqrt(value / (static_cast<double>(level.width) * level.height));
+    }
+    return error;
+}
+
+void testMipChain() {
+    const std::vector<unsigned char> pixels = gradient(37, 10, 3);
+    const texcook::MipChain chain = texcook::buildMipChain(pixels.data(), 37, 10, 3);
+
+    CHECK(chain.layout.format == texcook::Format::Rgb8);
+    CHECK(chain.layout.levels.size() == 6);
+    int width = 37;
+    int height = 10;
+    for (const texcook::Level& level : chain.layout.levels) {
+        CHECK(level.width == width && level.height == height);
+        CHECK(level.size == static_cast<std::size_t>(width) * height * 3);
+        CHECK(level.offset % 16 == 0);
+        CHECK(level.offset + level.size <= chain.pixels.size());
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    CHECK(chain.layout.levels.back().width == 1 && chain.layout.levels.back().height == 1);
+    CHECK(std::memcmp(chain.pixels.data(), pixels.data(), pixels.size()) == 0);
+
+    // A flat image stays flat all the way down.
+    const std::vector<unsigned char> flat(64 * 64 * 4, 200);
+    const texcook::MipChain flatChain = texcook::buildMipChain(flat.data(), 64, 64, 4);
+    CHECK(flatChain.layout.format == texcook::Format::Rgba8);
+    const texcook::Level& last = flatChain.layout.levels.back();
+    for (std::size_t i = 0; i < last.size; ++i) {
+        CHECK(flatChain.pixels[last.offset + i] == 200);
+    }
+}
+
+void testBc1() {
+    const std::vector<unsigned char> pixels = gradient(64, 64, 3);
+    const texcook::MipChain chain = texcook::buildMipChain(pixels.data(), 64, 64, 3);
+    const texcook::MipChain encoded = texcook::compress(chain);
+
+    CHECK(encoded.layout.format == texcook::Format::Bc1);
+    CHECK(encoded.layout.levels.size() == chain.layout.levels.size());
+    CHECK(encoded.layout.levels.front().size == 16 * 16 * 8);
+    // Levels under one block still take a whole one.
+    CHECK(encoded.layout.levels.back().size == 8);
+    for (const texcook::Level& level : encoded.layout.levels) {
+        CHECK(level.offset % 16 == 0);
+    }
+
+    // The ramp steeps as the levels shrink, so only the top two, where a
+    // block holds a short stretch of it, are held to a tight bound.
+    for (std::size_t l = 0; l < chain.layout.levels.size(); ++l) {
+        for (const double error : blockError(chain, encoded, l)) {
+            CHECK(error < (l < 2 ? 3.0 : 20.0));
+        }
+    }
+
+    // A solid block only loses the 565 rounding.
+    const std::vector<unsigned char> solid(4 * 4 * 3, 77);
+    const texcook::MipChain solidChain = texcook::compress(texcook::buildMipChain(solid.data(), 4, 4, 3));
+    for (const double error : blockError(texcook::buildMipChain(solid.data(), 4, 4, 3), solidChain, 0)) {
+        CHECK(error <= 4.0);
+    }
+}
+
+void testBc3() {
+    const std::vector<unsigned char> pixels = gradient(60, 36, 4);
+    const texcook::MipChain chain = texcook::buildMipChain(pixels.data(), 60, 36, 4);
+    const texcook::MipChain encoded = texcook::compress(chain);
+
+    CHECK(encoded.layout.format == texcook::Format::Bc3);
+    CHECK(encoded.layout.levels.front().size == 15 * 9 * 16);
+    for (std::size_t l = 0; l < chain.layout.levels.size(); ++l) {
+        const std::vector<double> error = blockError(chain, encoded, l);
+        const double bound = l < 2 ? 3.0 : 20.0;
+        CHECK(error[0] < bound && error[1] < bound && error[2] < bound);
+        // Eight alpha steps per block are finer than the colour's four.
+        CHECK(error[3] < bound / 2.0);
+    }
+}
+
+void testRoundTrip() {
+    const std::vector<unsigned char> pixels = gradient(40, 24, 4);
+    const texcook::MipChain chain = texcook::compress(texcook::buildMipChain(pixels.data(), 40, 24, 4));
+    const std::string path = tempPath("tube_cook_test.ttx");
+    texcook::write(path, chain);
+    const std::vector<char> data = readAll(path);
+    std::remove(path.c_str());
+
+    CHECK(texcook::isCooked(data.data(), data.size()));
+    const texcook::Layout layout = texcook::parse(data.data(), data.size(), path);
+    CHECK(layout.format == texcook::Format::Bc3);
+    CHECK(layout.levels.size() == chain.layout.levels.size());
+    for (std::size_t l = 0; l < layout.levels.size() && l < chain.layout.levels.size(); ++l) {
+        const texcook::Level& read = layout.levels[l];
+        const texcook::Level& written = chain.layout.levels[l];
+        CHECK(read.width == written.width && read.height == written.height && read.size == written.size);
+        CHECK(read.offset % 16 == 0);
+        CHECK(std::memcmp(data.data() + read.offset, chain.pixels.data() + written.offset, written.size) == 0);
+    }
+
+    CHECK(texcook::cookedPath("textures/stone.png") == "textures/stone.ttx");
+    CHECK(texcook::cookedPath("a.b/stone") == "a.b/stone.ttx");
+}
+
+void testCorruption() {
+    const std::vector<unsigned char> pixels = gradient(16, 16, 3);
+    const texcook::MipChain chain = texcook::compress(texcook::buildMipChain(pixels.data(), 16, 16, 3));
+    const std::string path = tempPath("tube_cook_corrupt.ttx");
+    texcook::write(path, chain);
+    const std::vector<char> data = readAll(path);
+    std::remove(path.c_str());
+
+    std::vector<char> magic = data;
+    magic[0] = 'X';
+    CHECK(!texcook::isCooked(magic.data(), magic.size()));
+    CHECK(throws([&]() {
+        texcook::parse(magic.data(), magic.size(), path);
+    }));
+
+    // Cut inside the pixel data, so the last level no longer fits.
+    CHECK(throws([&]() {
+        texcook::parse(data.data(), data.size() - 1 - chain.layout.levels.back().size, path);
+    }));
+    // Cut inside the level table.
+    CHECK(throws([&]() {
+        texcook::parse(data.data(), 30, path);
+    }));
+
+    std::vector<char> format = data;
+    format[8] = 9;
+    CHECK(throws([&]() {
+        texcook::parse(format.data(), format.size(), path);
+    }));
+
+    // The second level claims the base level's width.
+    std::vector<char> level = data;
+    const std::uint32_t width = 16;
+    std::memcpy(level.data() + 24 + 24 + 16, &width, 4);
+    CHECK(throws([&]() {
+        texcook::parse(level.data(), level.size(), path);
+    }));
+
+    std::vector<char> offset = data;
+    const std::uint64_t far = data.size();
+    std::memcpy(offset.data() + 24, &far, 8);
+    CHECK(throws([&]() {
+        texcook::parse(offset.data(), offset.size(), path);
+    }));
+}
+
+void testPages() {
+    const int width = 50;
+    const int height = 20;
+    const std::vector<unsigned char> pixels = gradient(width, height, 3);
+    const std::string path = tempPath("tube_cook_pages.tvt");
+    texcook::writePages(path, pixels.data(), width, height, 3, 16, 2);
+    const std::vector<char> data = readAll(path);
+    std::remove(path.c_str());
+
+    CHECK(texcook::isPaged(data.data(), data.size()));
+    CHECK(!texcook::isCooked(data.data(), data.size()));
+    const texcook::PageLayout layout = texcook::parsePages(data.data(), data.size(), path);
+    CHECK(layout.pageSize == 16 && layout.border == 2);
+    CHECK(layout.imageWidth == width && layout.imageHeight == height);
+    CHECK(layout.levelCount == 3);
+    CHECK(layout.virtualSize() == 64);
+    CHECK(layout.fileBytes() == data.size());
+
+    // Every stored texel of level 0, borders included, is the image texel
+    // it covers, clamped to the edge, with opaque alpha.
+    bool matches = true;
+    const int stored = layout.storedSize();
+    for (int py = 0; py < layout.pagesPerSide(0); ++py) {
+        for (int px = 0; px < layout.pagesPerSide(0); ++px) {
+            const auto* page = reinterpret_cast<const unsigned char*>(data.data() + layout.pageOffset(0, px, py));
+            for (int y = 0; y < stored; ++y) {
+                for (int x = 0; x < stored; ++x) {
+                    const int sx = std::clamp(px * 16 + x - 2, 0, width - 1);
+                    const int sy = std::clamp(py * 16 + y - 2, 0, height - 1);
+                    const unsigned char* texel = page + (static_cast<std::size_t>(y) * stored + x) * 4;
+                    const unsigned char* source = &pixels[(static_cast<std::size_t>(sy) * width + sx) * 3];
+                    matches = matches && std::memcmp(texel, source, 3) == 0 && texel[3] == 255;
+                }
+            }
+        }
+    }
+    CHECK(matches);
+
+    std::vector<char> truncated(data.begin(), data.end() - 1);
+    CHECK(throws([&]() {
+        texcook::parsePages(truncated.data(), truncated.size(), path);
+    }));
+    std::vector<char> border = data;
+    const std::uint32_t wide = 17;
+    std::memcpy(border.data() + 12, &wide, 4);
+    CHECK(throws([&]() {
+        texcook::parsePages(border.data(), border.size(), path);
+    }));
+}
+
+}  // namespace
+
+int main() {
+    testMipChain();
+    testBc1();
+    testBc3();
+    testRoundTrip();
+    testCorruption();
+    testPages();
+    return check::failures();
+}
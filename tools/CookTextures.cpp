@@ -0,0 +1,112 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "app_config.hpp"
+#include "engine/TextureCook.h"
+
+namespace {
+
+const char* formatName(texcook::Format format) {
+    switch (format) {
+        case texcook::Format::Rgb8:
+            return "RGB8";
+        case texcook::Format::Rgba8:
+            return "RGBA8";
+        case texcook::Format::Bc1:
+            return "BC1";
+        case texcook::Format::Bc3:
+            return "BC3";
+    }
+    return "?";
+}
+
+enum class Mode {
+    Mip,
+    BlockCompressed,
+    Paged,
+};
+
+void cook(const std::string& input, const std::string& output, Mode mode) {
+    const auto start = std::chrono::steady_clock::now();
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    if (stbi_info(input.c_str(), &width, &height, &channels) == 0) {
+        throw std::runtime_error("Erro ao carregar textura: " + input);
+    }
+    const int wanted = channels == 2 || channels == 4 ? 4 : 3;
+    unsigned char* pixels = stbi_load(input.c_str(), &width, &height, &channels, wanted);
+    if (pixels == nullptr) {
+        throw std::runtime_error("Erro ao carregar textura: " + input);
+    }
+
+    if (mode == Mode::Paged) {
+        try {
+            texcook::writePages(output, pixels, width, height, wanted, app::kVirtualPageSize, app::kVirtualPageBorder);
+        } catch (...) {
+            stbi_image_free(pixels);
+            throw;
+        }
+        stbi_image_free(pixels);
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("%s -> %s: %dx%d paged, %.1f ms\n", input.c_str(), output.c_str(), width, height, elapsed.count() * 1000.0);
+        return;
+    }
+
+    texcook::MipChain chain = texcook::buildMipChain(pixels, width, height, wanted);
+    stbi_image_free(pixels);
+    if (mode == Mode::BlockCompressed) {
+        chain = texcook::compress(chain);
+    }
+    texcook::write(output, chain);
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf(
+        "%s -> %s: %dx%d %s, %zu levels, %zu KiB, %.1f ms\n",
+        input.c_str(),
+        output.c_str(),
+        width,
+        height,
+        formatName(chain.layout.format),
+        chain.layout.levels.size(),
+        chain.pixels.size() / 1024,
+        elapsed.count() * 1000.0
+    );
+}
+
+}  // namespace
+
+// Usage: TubeCookTextures [--bc | --pages] <input> <output>
+// --bc stores BC1 for opaque images and BC3 for ones with alpha; --pages
+// writes a paged file for VirtualTexture instead of a mip chain.
+int main(int argc, char** argv) {
+    Mode mode = Mode::Mip;
+    int first = 1;
+    if (argc > 1 && std::strcmp(argv[1], "--bc") == 0) {
+        mode = Mode::BlockCompressed;
+        first = 2;
+    } else if (argc > 1 && std::strcmp(argv[1], "--pages") == 0) {
+        mode = Mode::Paged;
+        first = 2;
+    }
+    if (argc - first != 2) {
+        std::fprintf(stderr, "Uso: %s [--bc | --pages] <entrada> <saida>\n", argv[0]);
+        return 1;
+    }
+
+    try {
+        cook(argv[first], argv[first + 1], mode);
+    } catch (const std::exception& error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}